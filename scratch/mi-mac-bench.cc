@@ -0,0 +1,307 @@
+// Simulator-performance benchmark: how fast the engine runs, not what the
+// protocol achieves.  Every combination of MAC, node count, density and
+// reading interval is run on the lattice scenario and measured for
+//   - setup time (node and device creation, placement, energy install)
+//   - events executed per wall-clock second of Simulator::Run()
+//   - peak resident memory above the process baseline, per node
+//   - wall-clock overhead of a binary MiTraceSink and of MiMacStats
+// Each run is a forked child, so memory peaks and ns-3's process-wide state
+// start fresh; runs are sequential so they do not compete for cores, and
+// the fastest of --repeat runs is kept.
+//
+// Rows are appended to --csv under --label (a commit id, say).  With
+// --baseline, every point is compared against the row of that label and
+// the program fails if events/s dropped, or memory per node grew, by more
+// than --tolerance.
+//
+//   ./ns3 run "scratch/mi-mac-bench --label=$(git rev-parse --short HEAD)"
+//   ./ns3 run "scratch/mi-mac-bench --label=$(git rev-parse --short HEAD) --baseline=a1b2c3d"
+
+#include "mi-mac-scenario.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <fstream>
+#include <map>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+enum BenchMode {
+    BENCH_PLAIN,
+    BENCH_TRACE,
+    BENCH_STATS,
+    NUM_BENCH_MODES
+};
+
+// Written by the child that ran it, so plain data only.
+struct BenchSample {
+    bool done;
+    uint64_t events;
+    double setupSec;
+    double wallSec;         // Run(), plus draining the trace writer when tracing
+    uint64_t peakBytes;     // resident set peak above the child's starting size
+    uint64_t traceRecords;
+};
+
+struct BenchPoint {
+    MiScenarioConfig config;
+    double density;  // nodes per m²
+    BenchSample best[NUM_BENCH_MODES];
+};
+
+const char* const CSV_HEADER =
+    "label,mac,nodes,density,interval_s,sim_time,events,setup_s,wall_s,events_per_s,peak_MB,bytes_per_node,"
+    "trace_records,trace_overhead_pct,stats_overhead_pct";
+
+// Field of /proc/self/status in bytes, 0 if missing.
+uint64_t ReadStatusBytes(const char* field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t length = std::strlen(field);
+    while (std::getline(status, line)) {
+        if (line.compare(0, length, field) == 0 && line[length] == ':') {
+            return std::strtoull(line.c_str() + length + 1, nullptr, 10) * 1024;
+        }
+    }
+    return 0;
+}
+
+void RunChild(const MiScenarioConfig& config, BenchMode mode, const std::string& traceFile, BenchSample* sample) {
+    // Restart the peak at the current size, so the peak measures this run alone.
+    std::ofstream("/proc/self/clear_refs") << "5";
+    uint64_t baseline = ReadStatusBytes("VmRSS");
+
+    RngSeedManager::SetSeed(1);
+    RngSeedManager::SetRun(1);
+    MiTraceSink trace(traceFile, mode == BENCH_TRACE ? MI_TRACE_BINARY : MI_TRACE_SILENT);
+    MiMacStats stats;
+    MiScenarioResult result = RunMiScenario(config, &trace, mode == BENCH_STATS ? &stats : nullptr);
+    auto closeStart = std::chrono::steady_clock::now();
+    trace.Close();
+    double closeSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - closeStart).count();
+
+    uint64_t peak = ReadStatusBytes("VmHWM");
+    sample->events = result.events;
+    sample->setupSec = result.setupSec;
+    sample->wallSec = result.wallSec + closeSec;
+    sample->peakBytes = peak > baseline ? peak - baseline : 0;
+    sample->traceRecords = trace.GetRecordCount();
+    sample->done = true;
+}
+
+struct BaselineRow {
+    double eventsPerSec = 0.0;
+    double bytesPerNode = 0.0;
+};
+
+std::string PointKey(const std::string& mac, uint32_t nodes, double density, double interval, double simTime) {
+    std::ostringstream key;
+    key << mac << "/" << nodes << "/" << density << "/" << interval << "/" << simTime;
+    return key.str();
+}
+
+// Last row per point recorded under label.
+std::map<std::string, BaselineRow> ReadBaseline(const std::string& path, const std::string& label) {
+    std::map<std::string, BaselineRow> rows;
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields = MiParseList<std::string>(line);
+        if (fields.size() < 12 || fields[0] != label) {
+            continue;
+        }
+        BaselineRow row;
+        row.eventsPerSec = std::stod(fields[9]);
+        row.bytesPerNode = std::stod(fields[11]);
+        rows[PointKey(fields[1], std::stoul(fields[2]), std::stod(fields[3]), std::stod(fields[4]),
+                      std::stod(fields[5]))] = row;
+    }
+    return rows;
+}
+
+int main(int argc, char *argv[]) {
+    std::string macList = "mi,csma";
+    std::string nodeList = "1000,10000";
+    std::string densityList = "0.25,1";
+    std::string intervalList = "30,5";
+    double simTime = 30.0;
+    double range = 4.0;
+    uint32_t repeat = 1;
+    bool overhead = true;
+    std::string label = "current";
+    std::string baseline;
+    double tolerance = 0.10;
+    std::string csvFile = "mi-mac-bench.csv";
+    std::string traceFile = "mi-mac-bench.trace";
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("mac", "Comma-separated MACs: mi and/or csma", macList);
+    cmd.AddValue("nodes", "Comma-separated node counts", nodeList);
+    cmd.AddValue("density", "Comma-separated node densities (nodes/m²)", densityList);
+    cmd.AddValue("interval", "Comma-separated mean reading intervals per node (s); sets the offered load",
+                 intervalList);
+    cmd.AddValue("simTime", "Simulated time per run (s)", simTime);
+    cmd.AddValue("range", "Coupling evaluation radius (m)", range);
+    cmd.AddValue("repeat", "Runs per point and mode; the fastest is kept", repeat);
+    cmd.AddValue("overhead", "Also time every point with tracing and with statistics attached", overhead);
+    cmd.AddValue("label", "Name the rows are recorded under, e.g. a commit id", label);
+    cmd.AddValue("baseline", "Label of earlier rows in --csv to compare against", baseline);
+    cmd.AddValue("tolerance", "Largest accepted loss of events/s or growth of memory per node (fraction)",
+                 tolerance);
+    cmd.AddValue("csv", "File the result rows are appended to and the baseline read from", csvFile);
+    cmd.AddValue("traceFile", "Scratch file for the trace overhead runs", traceFile);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(label.find(',') != std::string::npos, "--label cannot contain a comma");
+
+    std::vector<BenchPoint> points;
+    for (const std::string& mac : MiParseList<std::string>(macList)) {
+        NS_ABORT_MSG_IF(mac != "mi" && mac != "csma", "unknown MAC '" << mac << "'");
+        for (uint32_t nodes : MiParseList<uint32_t>(nodeList)) {
+            for (double density : MiParseList<double>(densityList)) {
+                for (double interval : MiParseList<double>(intervalList)) {
+                    NS_ABORT_MSG_IF(density <= 0.0, "density must be positive");
+                    BenchPoint point = {};
+                    point.config.nodes = nodes;
+                    point.config.spacing = 1.0 / std::sqrt(density);
+                    point.config.range = range;
+                    point.config.simTime = simTime;
+                    point.config.meanInterval = interval;
+                    point.config.csma = mac == "csma";
+                    point.density = density;
+                    points.push_back(point);
+                }
+            }
+        }
+    }
+    NS_ABORT_MSG_IF(points.empty() || repeat == 0, "empty benchmark");
+    std::map<std::string, BaselineRow> reference;
+    if (!baseline.empty()) {
+        reference = ReadBaseline(csvFile, baseline);
+        NS_ABORT_MSG_IF(reference.empty(), "no rows labelled '" << baseline << "' in " << csvFile);
+    }
+
+    void* mapping = mmap(nullptr, sizeof(BenchSample), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    NS_ABORT_MSG_IF(mapping == MAP_FAILED, "cannot map shared result memory");
+    BenchSample* shared = static_cast<BenchSample*>(mapping);
+
+    std::cout << "\n" << std::string(70, '=') << std::endl;
+    std::cout << "   MI MAC SIMULATOR BENCHMARK (" << label << ")" << std::endl;
+    std::cout << std::string(70, '=') << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n  Points:                  " << points.size() << std::endl;
+    std::cout << "  Simulated time:          " << simTime << " s per run" << std::endl;
+    std::cout << "  Runs per point:          " << repeat << (overhead ? " x 3 (plain, trace, stats)" : "")
+              << std::endl;
+
+    uint32_t failed = 0;
+    int modes = overhead ? NUM_BENCH_MODES : 1;
+    for (BenchPoint& point : points) {
+        for (int mode = 0; mode < modes; mode++) {
+            for (uint32_t r = 0; r < repeat; r++) {
+                std::memset(shared, 0, sizeof(BenchSample));
+                std::cout.flush();
+                pid_t pid = fork();
+                NS_ABORT_MSG_IF(pid < 0, "fork failed");
+                if (pid == 0) {
+                    RunChild(point.config, static_cast<BenchMode>(mode), traceFile, shared);
+                    _exit(0);
+                }
+                int status = 0;
+                waitpid(pid, &status, 0);
+                BenchSample& best = point.best[mode];
+                if (!shared->done) {
+                    failed++;
+                } else if (!best.done || shared->wallSec < best.wallSec) {
+                    best = *shared;
+                }
+            }
+        }
+    }
+    std::remove(traceFile.c_str());
+    munmap(mapping, sizeof(BenchSample));
+
+    bool fresh = !std::ifstream(csvFile).good();
+    std::ofstream csv(csvFile, std::ios::app);
+    csv << std::setprecision(10);
+    if (fresh) {
+        csv << CSV_HEADER << "\n";
+    }
+
+    std::cout << "\n" << std::setw(5) << "MAC" << std::setw(8) << "Nodes" << std::setw(7) << "Dens" << std::setw(8)
+              << "Int(s)" << std::setw(10) << "Setup s" << std::setw(13) << "Events/s" << std::setw(11) << "Peak MB"
+              << std::setw(9) << "B/node" << std::setw(9) << "Trace%" << std::setw(9) << "Stats%";
+    if (!reference.empty()) {
+        std::cout << std::setw(12) << "vs " + baseline;
+    }
+    std::cout << std::endl;
+
+    uint32_t regressions = 0;
+    for (const BenchPoint& point : points) {
+        const BenchSample& plain = point.best[BENCH_PLAIN];
+        if (!plain.done) {
+            continue;
+        }
+        const char* mac = point.config.csma ? "csma" : "mi";
+        double eventsPerSec = plain.events / plain.wallSec;
+        double bytesPerNode = static_cast<double>(plain.peakBytes) / point.config.nodes;
+        // Same seed, so the traced runs execute the same events.
+        auto overheadPct = [&plain](const BenchSample& s) {
+            return s.done ? 100.0 * (s.wallSec - plain.wallSec) / plain.wallSec : 0.0;
+        };
+        double tracePct = overheadPct(point.best[BENCH_TRACE]);
+        double statsPct = overheadPct(point.best[BENCH_STATS]);
+
+        std::cout << std::setw(5) << mac << std::setw(8) << point.config.nodes << std::setw(7) << point.density
+                  << std::setw(8) << std::setprecision(1) << point.config.meanInterval << std::setprecision(3)
+                  << std::setw(10) << plain.setupSec << std::setprecision(0) << std::setw(13) << eventsPerSec
+                  << std::setprecision(1) << std::setw(11) << plain.peakBytes / 1e6 << std::setprecision(0)
+                  << std::setw(9) << bytesPerNode << std::setprecision(1);
+        if (overhead) {
+            std::cout << std::setw(9) << tracePct << std::setw(9) << statsPct;
+        } else {
+            std::cout << std::setw(9) << "-" << std::setw(9) << "-";
+        }
+        auto found = reference.find(PointKey(mac, point.config.nodes, point.density, point.config.meanInterval,
+                                             simTime));
+        if (found != reference.end()) {
+            double speed = eventsPerSec / found->second.eventsPerSec - 1.0;
+            double memory = found->second.bytesPerNode > 0.0 ? bytesPerNode / found->second.bytesPerNode - 1.0 : 0.0;
+            bool regressed = speed < -tolerance || memory > tolerance;
+            regressions += regressed;
+            std::cout << std::setw(10) << std::showpos << 100.0 * speed << "%" << std::noshowpos
+                      << (regressed ? "  REGRESSION" : "");
+        } else if (!reference.empty()) {
+            std::cout << std::setw(12) << "-";
+        }
+        std::cout << std::setprecision(2) << std::endl;
+
+        csv << label << "," << mac << "," << point.config.nodes << "," << point.density << ","
+            << point.config.meanInterval << "," << simTime << "," << plain.events << "," << plain.setupSec << ","
+            << plain.wallSec << "," << eventsPerSec << "," << plain.peakBytes / 1e6 << "," << bytesPerNode << ","
+            << point.best[BENCH_TRACE].traceRecords << ",";
+        if (overhead) {
+            csv << tracePct << "," << statsPct;
+        } else {
+            csv << ",";
+        }
+        csv << "\n";
+    }
+
+    std::cout << std::endl;
+    if (failed > 0) {
+        std::cout << "  Failed runs:             " << failed << " (excluded)" << std::endl;
+    }
+    if (!reference.empty()) {
+        std::cout << "  Regressions vs " << baseline << ":     " << regressions << " (tolerance " << 100.0 * tolerance
+                  << "%)" << std::endl;
+    }
+    std::cout << "  Rows appended to " << csvFile << " as '" << label << "'\n" << std::endl;
+
+    return failed > 0 || regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+#ifndef MI_MAC_COMMON_H
+#define MI_MAC_COMMON_H
+
+// Shared definitions for the Multi-Coil MI MAC scratch programs.
+// Each scratch/*.cc file is built as its own ns-3 program, so everything
+// here is header-only.
+
+#include <cstdint>
+#include <string>
+
+enum PacketType {
+    REV_PACKET = 1,
+    ACK_PACKET = 2,
+    DATA_PACKET = 3,
+    RTS_PACKET = 4,
+    CTS_PACKET = 5
+};
+
+enum CoilID {
+    COIL_X = 0,
+    COIL_Y = 1,
+    COIL_Z = 2
+};
+
+enum NodeState {
+    STATE_IDLE = 0,
+    STATE_RECEIVE = 1,
+    STATE_CHANNEL_SENSING = 2,
+    STATE_DATA_ACQUIRE = 3,
+    STATE_TRANSMIT = 4
+};
+
+const int NUM_COILS = 3;
+const int NUM_STATES = 5;
+
+inline const std::string stateNames[] = {"IDLE", "RECEIVE", "CHANNEL_SENSING", "DATA_ACQUIRE", "TRANSMIT"};
+inline const std::string packetNames[] = {"UNKNOWN", "REV", "ACK", "DATA", "RTS", "CTS"};
+inline const std::string coilNames[] = {"X", "Y", "Z"};
+
+// Energy consumption values from Table II of the paper
+struct EnergyMetrics {
+    double idleCurrent = 50.0;      // µA
+    double receiveCurrent = 200.0;   // µA
+    double dataAcquireCurrent = 250.0; // µA
+    double channelSensingCurrent = 200.0; // µA
+    double transmitCurrent = 1120.0; // µA (1.12 mA)
+    double totalEnergy = 0.0;        // µJ
+    int stateTransitions = 0;
+    int packetsSent = 0;
+
+    double CurrentFor(NodeState state) const {
+        switch (state) {
+            case STATE_IDLE: return idleCurrent;
+            case STATE_RECEIVE: return receiveCurrent;
+            case STATE_CHANNEL_SENSING: return channelSensingCurrent;
+            case STATE_DATA_ACQUIRE: return dataAcquireCurrent;
+            case STATE_TRANSMIT: return transmitCurrent;
+        }
+        return 0.0;
+    }
+};
+
+#endif // MI_MAC_COMMON_H
@@ -0,0 +1,180 @@
+#ifndef MI_MAC_COUPLING_H
+#define MI_MAC_COUPLING_H
+
+// Magneto-inductive coupling between three-coil nodes.
+//
+// Each coil is a magnetic dipole along one column of its node's orientation
+// matrix.  For a transmit axis a, a receive axis b and separation r (length
+// d, unit vector u) the mutual inductance is proportional to
+//
+//     J = (3 (a.u)(b.u) - a.b) / d^3
+//
+// and received power to J^2, i.e. the usual 1/r^6 MI path loss.  Powers are
+// normalised to a coaxial pair 1 m apart (J = 2), so
+//
+//     RSSI = TxPower - ReferenceLoss + 10 log10(J^2 / 4)
+//
+// The kernel evaluates all nine Tx/Rx coil pairs for a whole batch of links
+// stored as structure-of-arrays, eight links per SIMD step.
+
+#include "mi-mac-common.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// Rotation from a node's body frame to the world frame.  Column k is the axis
+// of coil k (X, Y, Z) in world coordinates; stored row-major.
+struct MiOrientation {
+    double m[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+    double Axis(int coil, int component) const { return m[component * 3 + coil]; }
+
+    // Z-Y-X (yaw, pitch, roll) Euler angles in radians.
+    static MiOrientation FromEuler(double yaw, double pitch, double roll) {
+        double cy = std::cos(yaw), sy = std::sin(yaw);
+        double cp = std::cos(pitch), sp = std::sin(pitch);
+        double cr = std::cos(roll), sr = std::sin(roll);
+        MiOrientation o;
+        o.m[0] = cy * cp;
+        o.m[1] = cy * sp * sr - sy * cr;
+        o.m[2] = cy * sp * cr + sy * sr;
+        o.m[3] = sy * cp;
+        o.m[4] = sy * sp * sr + cy * cr;
+        o.m[5] = sy * sp * cr - cy * sr;
+        o.m[6] = -sp;
+        o.m[7] = cp * sr;
+        o.m[8] = cp * cr;
+        return o;
+    }
+};
+
+// A batch of links in structure-of-arrays form.  Geometry goes in, the
+// normalised coupling power J^2/4 of every coil pair comes out in
+// gain[txCoil * 3 + rxCoil].  Arrays are padded to a whole number of SIMD
+// blocks; padding lanes hold a harmless dummy link.
+struct MiLinkBatch {
+    static const size_t LANES = 8;
+
+    size_t size = 0;
+    std::vector<float> dx, dy, dz;  // rx position - tx position (m)
+    std::vector<float> tx[9];       // tx orientation, row-major
+    std::vector<float> rx[9];       // rx orientation, row-major
+    std::vector<float> gain[9];     // output
+
+    void Resize(size_t n) {
+        size = n;
+        size_t padded = (n + LANES - 1) / LANES * LANES;
+        dx.resize(padded, 1.0f);
+        dy.resize(padded, 0.0f);
+        dz.resize(padded, 0.0f);
+        for (int k = 0; k < 9; k++) {
+            tx[k].resize(padded, (k % 4 == 0) ? 1.0f : 0.0f);
+            rx[k].resize(padded, (k % 4 == 0) ? 1.0f : 0.0f);
+            gain[k].resize(padded);
+        }
+    }
+
+    void Set(size_t i, double sepX, double sepY, double sepZ, const MiOrientation& txO, const MiOrientation& rxO) {
+        dx[i] = static_cast<float>(sepX);
+        dy[i] = static_cast<float>(sepY);
+        dz[i] = static_cast<float>(sepZ);
+        for (int k = 0; k < 9; k++) {
+            tx[k][i] = static_cast<float>(txO.m[k]);
+            rx[k][i] = static_cast<float>(rxO.m[k]);
+        }
+    }
+
+    float Gain(size_t i, int txCoil, int rxCoil) const { return gain[txCoil * 3 + rxCoil][i]; }
+};
+
+namespace MiCoupling {
+
+typedef float Block __attribute__((vector_size(MiLinkBatch::LANES * sizeof(float))));
+
+// Blocks are passed by reference so the ABI does not depend on whether the
+// target has 256-bit registers.
+inline void Load(Block& b, const std::vector<float>& v, size_t i) {
+    std::memcpy(&b, v.data() + i, sizeof(Block));
+}
+
+inline void Store(std::vector<float>& v, size_t i, const Block& b) {
+    std::memcpy(v.data() + i, &b, sizeof(Block));
+}
+
+// Added to every squared separation so co-located nodes stay finite.
+const float MIN_DISTANCE_SQ = 1e-4f;
+
+// Fills batch.gain for every link in the batch.
+inline void ComputeGains(MiLinkBatch& batch) {
+    const Block three = Block{} + 3.0f;
+    const Block quarter = Block{} + 0.25f;
+    const Block minD2 = Block{} + MIN_DISTANCE_SQ;
+    for (size_t i = 0; i < batch.size; i += MiLinkBatch::LANES) {
+        Block rx, ry, rz;
+        Load(rx, batch.dx, i);
+        Load(ry, batch.dy, i);
+        Load(rz, batch.dz, i);
+        Block d2 = rx * rx + ry * ry + rz * rz + minD2;
+        // J^2/4 = (3 (a.r)(b.r) - (a.b) d^2)^2 / (4 d^10)
+        Block d4 = d2 * d2;
+        Block scale = quarter / (d4 * d4 * d2);
+
+        Block t[9], q[9];
+        for (int k = 0; k < 9; k++) {
+            Load(t[k], batch.tx[k], i);
+            Load(q[k], batch.rx[k], i);
+        }
+        Block ar[3], br[3];
+        for (int c = 0; c < 3; c++) {
+            ar[c] = t[c] * rx + t[3 + c] * ry + t[6 + c] * rz;
+            br[c] = q[c] * rx + q[3 + c] * ry + q[6 + c] * rz;
+        }
+        for (int a = 0; a < 3; a++) {
+            for (int b = 0; b < 3; b++) {
+                Block ab = t[a] * q[b] + t[3 + a] * q[3 + b] + t[6 + a] * q[6 + b];
+                Block j = three * ar[a] * br[b] - ab * d2;
+                Block g = j * j * scale;
+                Store(batch.gain[a * 3 + b], i, g);
+            }
+        }
+    }
+}
+
+// Scalar reference for one coil pair, used to validate the batched kernel.
+inline double Gain(double sepX, double sepY, double sepZ, const MiOrientation& txO, int txCoil,
+                   const MiOrientation& rxO, int rxCoil) {
+    double d2 = sepX * sepX + sepY * sepY + sepZ * sepZ + MIN_DISTANCE_SQ;
+    double ar = txO.Axis(txCoil, 0) * sepX + txO.Axis(txCoil, 1) * sepY + txO.Axis(txCoil, 2) * sepZ;
+    double br = rxO.Axis(rxCoil, 0) * sepX + rxO.Axis(rxCoil, 1) * sepY + rxO.Axis(rxCoil, 2) * sepZ;
+    double ab = 0.0;
+    for (int k = 0; k < 3; k++) {
+        ab += txO.Axis(txCoil, k) * rxO.Axis(rxCoil, k);
+    }
+    double j = 3.0 * ar * br - ab * d2;
+    double d4 = d2 * d2;
+    return j * j / (4.0 * d4 * d4 * d2);
+}
+
+// Converts a normalised coupling gain to received power.
+inline double ToRssi(double gain, double txPowerDbm, double referenceLossDb) {
+    const double floorDbm = -200.0;
+    if (gain <= 0.0) {
+        return floorDbm;
+    }
+    return std::max(floorDbm, txPowerDbm - referenceLossDb + 10.0 * std::log10(gain));
+}
+
+// Interference adds up in linear power.
+inline double DbmToMw(double dbm) {
+    return std::pow(10.0, dbm / 10.0);
+}
+
+inline double MwToDbm(double mw) {
+    return mw > 0.0 ? std::max(-200.0, 10.0 * std::log10(mw)) : -200.0;
+}
+
+} // namespace MiCoupling
+
+#endif // MI_MAC_COUPLING_H
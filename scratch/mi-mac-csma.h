@@ -0,0 +1,742 @@
+#ifndef MI_MAC_CSMA_H
+#define MI_MAC_CSMA_H
+
+// IEEE 802.11-style CSMA/CA (DCF) on the MI medium, the baseline the
+// Multi-Coil MAC is measured against.
+//
+// CsmaMacNetDevice shares MiMacChannel, the per-coil SINR reception of
+// MiRadioDevice (half duplex included) and the trace sources of
+// MiMacNetDevice, so MiEnergyModel and MiTraceSink work on it unchanged.
+// It has no coil selection: every frame leaves on the Z coil, which couples
+// equally in all directions of the horizontal plane, and is decoded on
+// whichever receive coil has the best SINR.  Carrier sense and the backoff
+// freeze on power at the sensitivity on any coil.
+//
+// Transfer, source side:
+//   IDLE -> DATA_ACQUIRE -> CHANNEL_SENSING (DIFS + backoff) -> TRANSMIT (RTS)
+//        -> RECEIVE (wait CTS) -> TRANSMIT (DATA) -> RECEIVE (wait ACK) -> IDLE
+// Destination side:
+//   IDLE -> RECEIVE (RTS) -> TRANSMIT (CTS) -> RECEIVE (wait DATA)
+//        -> TRANSMIT (ACK) -> IDLE
+//
+// The backoff is drawn uniformly from [0, CW - 1] slots and counts down only
+// after the medium has been idle for DIFS; a busy medium or a pending NAV
+// freezes the remaining slots.  CW starts at CwMin, doubles on every CTS or
+// ACK timeout up to CwMax and starts over with the next reading; a reading
+// is dropped after RetryLimit retries.  RTS, CTS and DATA carry how long the
+// exchange still holds the medium, which every node that overhears them
+// loads into its NAV.  With RtsCts off, DATA follows the backoff directly.
+
+#include "mi-mac-net-device.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+
+namespace ns3 {
+
+// Frame formats, sharing the Carrier/Preamble/PacketID framing of
+// MiMacHeader so trace tools classify both MACs' frames alike:
+//   RTS:  [Carrier|Preamble|RA|PacketID|Duration|TA|EOF]      16 bytes
+//   CTS:  [Carrier|PacketID|RA|Duration|EOF]                   7 bytes
+//   DATA: [Carrier|PacketID|RA|Duration|TA|Seq|Data|EOF]       10-26 bytes
+//   ACK:  [Carrier|PacketID|RA|EOF]                            5 bytes
+// DATA that opens an exchange (RtsCts off) carries the preamble like RTS.
+// Duration counts DURATION_UNIT_US steps, rounded up.  The formats are the
+// MiLayout::Csma* layouts.
+class CsmaMacHeader : public Header {
+  public:
+    static constexpr int64_t DURATION_UNIT_US = 100;
+
+    CsmaMacHeader() : CsmaMacHeader(DATA_PACKET) {}
+    explicit CsmaMacHeader(PacketType type) { m_fields[MiLayout::SLOT_PACKET_ID] = type; }
+
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::CsmaMacHeader")
+                                .SetParent<Header>()
+                                .SetGroupName("MiMac")
+                                .AddConstructor<CsmaMacHeader>();
+        return tid;
+    }
+    TypeId GetInstanceTypeId() const override { return GetTypeId(); }
+
+    void SetPacketType(PacketType type) { m_fields[MiLayout::SLOT_PACKET_ID] = type; }
+    PacketType GetPacketType() const { return static_cast<PacketType>(m_fields[MiLayout::SLOT_PACKET_ID]); }
+    void SetPreamble(bool preamble) { m_preamble = preamble; }
+    bool HasPreamble() const { return m_preamble || GetPacketType() == RTS_PACKET; }
+    void SetReceiver(uint16_t id) { m_fields[MiLayout::SLOT_RA] = id; }
+    uint16_t GetReceiver() const { return m_fields[MiLayout::SLOT_RA]; }
+    void SetTransmitter(uint16_t id) { m_fields[MiLayout::SLOT_TA] = id; }
+    uint16_t GetTransmitter() const { return m_fields[MiLayout::SLOT_TA]; }
+    void SetSequence(uint8_t sequence) { m_fields[MiLayout::SLOT_SEQUENCE] = sequence; }
+    uint8_t GetSequence() const { return static_cast<uint8_t>(m_fields[MiLayout::SLOT_SEQUENCE]); }
+    void SetDuration(Time duration) {
+        int64_t units = (duration.GetMicroSeconds() + DURATION_UNIT_US - 1) / DURATION_UNIT_US;
+        m_fields[MiLayout::SLOT_DURATION] = static_cast<uint16_t>(std::clamp<int64_t>(units, 0, UINT16_MAX));
+    }
+    Time GetDuration() const { return MicroSeconds(m_fields[MiLayout::SLOT_DURATION] * DURATION_UNIT_US); }
+    bool HasDuration() const { return GetPacketType() != ACK_PACKET; }
+
+    // Header bytes for a frame type, excluding payload and EOF.
+    static constexpr uint32_t GetHeaderSize(PacketType type, bool preamble = false) {
+        switch (type) {
+            case RTS_PACKET: return MiLayout::CsmaRts::SIZE;
+            case CTS_PACKET: return MiLayout::CsmaCts::SIZE;
+            case DATA_PACKET: return preamble ? MiLayout::CsmaPreambleData::SIZE : MiLayout::CsmaData::SIZE;
+            default: return MiLayout::CsmaAck::SIZE;
+        }
+    }
+
+    // Field structure of a whole frame, e.g. "[Carrier|PacketID|RA|EOF]".
+    static std::string Describe(PacketType type, bool preamble = false) {
+        switch (type) {
+            case RTS_PACKET: return MiLayout::CsmaRts::Describe() + "|EOF]";
+            case CTS_PACKET: return MiLayout::CsmaCts::Describe() + "|EOF]";
+            case DATA_PACKET:
+                return (preamble ? MiLayout::CsmaPreambleData::Describe() : MiLayout::CsmaData::Describe()) +
+                       "|Data|EOF]";
+            default: return MiLayout::CsmaAck::Describe() + "|EOF]";
+        }
+    }
+
+    uint32_t GetSerializedSize() const override { return GetHeaderSize(GetPacketType(), m_preamble); }
+
+    void Serialize(Buffer::Iterator start) const override {
+        switch (GetPacketType()) {
+            case RTS_PACKET: MiLayout::CsmaRts::Write(start, m_fields); break;
+            case CTS_PACKET: MiLayout::CsmaCts::Write(start, m_fields); break;
+            case DATA_PACKET:
+                if (m_preamble) {
+                    MiLayout::CsmaPreambleData::Write(start, m_fields);
+                } else {
+                    MiLayout::CsmaData::Write(start, m_fields);
+                }
+                break;
+            default: MiLayout::CsmaAck::Write(start, m_fields); break;
+        }
+    }
+
+    // With a preamble the PacketID sits behind RA, otherwise right after the
+    // Carrier.
+    uint32_t Deserialize(Buffer::Iterator start) override {
+        Buffer::Iterator probe = start;
+        probe.Next(1);
+        uint8_t next = probe.ReadU8();
+        m_preamble = next == MiLayout::PREAMBLE;
+        if (m_preamble) {
+            probe = start;
+            probe.Next(MiLayout::CsmaRts::OffsetOf<MiLayout::SLOT_PACKET_ID>());
+            next = probe.ReadU8();
+        }
+        switch (next) {
+            case RTS_PACKET: MiLayout::CsmaRts::Read(start, m_fields); break;
+            case CTS_PACKET: MiLayout::CsmaCts::Read(start, m_fields); break;
+            case DATA_PACKET:
+                if (m_preamble) {
+                    MiLayout::CsmaPreambleData::Read(start, m_fields);
+                } else {
+                    MiLayout::CsmaData::Read(start, m_fields);
+                }
+                break;
+            default: MiLayout::CsmaAck::Read(start, m_fields); break;
+        }
+        m_preamble = m_preamble && GetPacketType() == DATA_PACKET;
+        return GetSerializedSize();
+    }
+
+    void Print(std::ostream& os) const override {
+        PacketType type = GetPacketType();
+        os << packetNames[type] << " ra=" << GetReceiver();
+        if (type == RTS_PACKET || type == DATA_PACKET) {
+            os << " ta=" << GetTransmitter();
+        }
+        if (HasDuration()) {
+            os << " duration=" << GetDuration().GetMicroSeconds() << "us";
+        }
+        if (type == DATA_PACKET) {
+            os << " seq=" << static_cast<uint32_t>(GetSequence());
+        }
+    }
+
+  private:
+    bool m_preamble = false;
+    uint16_t m_fields[MiLayout::NUM_SLOTS] = {};
+};
+
+// Total on-air size of a CSMA/CA frame carrying payloadSize bytes of data.
+constexpr uint32_t GetCsmaFrameSize(PacketType type, uint32_t payloadSize = 0, bool preamble = false) {
+    return CsmaMacHeader::GetHeaderSize(type, preamble) + payloadSize + 1;
+}
+
+class CsmaMacNetDevice : public MiRadioDevice {
+  public:
+    static const uint16_t MAX_PAYLOAD = 16;
+    static constexpr CoilID TX_COIL = COIL_Z;
+
+    static TypeId GetTypeId();
+
+    CsmaMacNetDevice();
+
+    Mac16Address GetMacAddress() const override { return m_address; }
+    NodeState GetState() const { return m_state; }
+    uint32_t GetContentionWindow() const { return m_cw; }
+
+    // Frame airtime at the configured bit rate.
+    Time GetAirtime(uint32_t bytes) const { return Seconds(bytes * 8.0 / m_bitRate); }
+    Time GetDifs() const { return m_sifs + m_slotTime * 2; }
+
+    // NetDevice
+    void SetIfIndex(const uint32_t index) override { m_ifIndex = index; }
+    uint32_t GetIfIndex() const override { return m_ifIndex; }
+    void SetAddress(Address address) override { m_address = Mac16Address::ConvertFrom(address); }
+    Address GetAddress() const override { return m_address; }
+    bool SetMtu(const uint16_t mtu) override;
+    uint16_t GetMtu() const override { return m_mtu; }
+    void AddLinkChangeCallback(Callback<void> callback) override {}
+    bool IsBroadcast() const override { return false; }
+    Address GetBroadcast() const override { return Mac16Address::GetBroadcast(); }
+    bool IsMulticast() const override { return false; }
+    Address GetMulticast(Ipv4Address multicastGroup) const override { return Mac16Address::GetBroadcast(); }
+    Address GetMulticast(Ipv6Address addr) const override { return Mac16Address::GetBroadcast(); }
+    bool IsBridge() const override { return false; }
+    bool IsPointToPoint() const override { return false; }
+    bool Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) override;
+    bool SendFrom(Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber) override {
+        return Send(packet, dest, protocolNumber);
+    }
+    Ptr<Node> GetNode() const override { return m_node; }
+    void SetNode(Ptr<Node> node) override { m_node = node; }
+    bool NeedsArp() const override { return false; }
+    void SetReceiveCallback(ReceiveCallback cb) override { m_rxCallback = cb; }
+    void SetPromiscReceiveCallback(PromiscReceiveCallback cb) override { m_promiscRxCallback = cb; }
+    bool SupportsSendFrom() const override { return false; }
+
+  protected:
+    void DoDispose() override;
+    void HandleFrame(Ptr<MiRadioDevice> sender, Ptr<const Packet> frame, CoilID txCoil, CoilID rxCoil,
+                     double rssi) override;
+    // A carrier freezes the backoff; it resumes once the medium is idle again.
+    void NotifyRxStart() override;
+    void NotifyRxEnd() override { ResumeBackoff(); }
+
+  private:
+    enum CsmaPhase {
+        PHASE_NONE,
+        PHASE_ACQUIRE,
+        PHASE_CONTEND,
+        PHASE_SEND_RTS,
+        PHASE_WAIT_CTS,
+        PHASE_SEND_DATA,
+        PHASE_WAIT_ACK,
+        PHASE_SEND_CTS,
+        PHASE_WAIT_DATA,
+        PHASE_SEND_ACK
+    };
+
+    struct TxItem {
+        Ptr<Packet> packet;
+        Mac16Address dest;
+    };
+
+    void SetState(NodeState to, const char* reason);
+    void ServiceQueue();
+    void EndDataAcquire();
+    bool IsMediumIdle() const;
+    void StartContention(const char* reason);
+    void ResumeBackoff();
+    void FreezeBackoff();
+    void AccessGranted();
+    void SetNav(Time until);
+    void SendRts();
+    void SendCts();
+    void SendData();
+    void SendAck();
+    void SendFrame(Ptr<Packet> frame);
+    void EndTx();
+    void ExchangeTimeout();
+    void DataTimeout();
+    void EndResponse();
+    void ReturnToIdle(const char* reason);
+
+    Ptr<Node> m_node;
+    Mac16Address m_address;
+    uint32_t m_ifIndex;
+    uint16_t m_mtu;
+    ReceiveCallback m_rxCallback;
+    PromiscReceiveCallback m_promiscRxCallback;
+    Ptr<UniformRandomVariable> m_random;
+
+    double m_bitRate;  // bit/s
+    Time m_dataAcquireTime;
+    Time m_slotTime;
+    Time m_sifs;
+    uint32_t m_cwMin;
+    uint32_t m_cwMax;
+    uint32_t m_retryLimit;
+    bool m_rtsCts;
+    uint32_t m_queueLimit;
+
+    NodeState m_state;
+    CsmaPhase m_phase;
+    EventId m_stateEvent;
+    EventId m_timeoutEvent;
+    std::deque<TxItem> m_queue;
+
+    // Source: the reading at the head of the queue once it is acquired.
+    bool m_pending;
+    uint32_t m_cw;
+    uint32_t m_retries;
+    uint32_t m_backoffSlots;  // slots left to count down
+    EventId m_backoffEvent;
+    Time m_countdownStart;    // when the current countdown passed DIFS
+    Time m_accessStart;       // when the head reading started contending
+    uint8_t m_sequence;
+
+    // Destination: the source of the exchange being answered.
+    Mac16Address m_peer;
+    Time m_ctsDuration;
+    std::unordered_map<uint16_t, uint8_t> m_lastSequence;
+
+    // Virtual carrier sense.
+    Time m_navEnd;
+    EventId m_navEvent;
+
+    TracedCallback<uint32_t, NodeState, NodeState, const char*> m_stateTrace;
+    TracedCallback<uint32_t, Ptr<const Packet>, CoilID> m_macTxTrace;
+    TracedCallback<uint32_t, Ptr<const Packet>, CoilID, CoilID, double> m_macRxTrace;
+    TracedCallback<uint32_t, Ptr<const Packet>> m_macTxDropTrace;
+};
+
+inline TypeId CsmaMacNetDevice::GetTypeId() {
+    static TypeId tid =
+        TypeId("ns3::CsmaMacNetDevice")
+            .SetParent<MiRadioDevice>()
+            .SetGroupName("MiMac")
+            .AddConstructor<CsmaMacNetDevice>()
+            .AddAttribute("BitRate",
+                          "MI link bit rate (bit/s).",
+                          DoubleValue(10000.0),
+                          MakeDoubleAccessor(&CsmaMacNetDevice::m_bitRate),
+                          MakeDoubleChecker<double>(1.0))
+            .AddAttribute("DataAcquireTime",
+                          "Time spent in DATA_ACQUIRE reading the sensor.",
+                          TimeValue(MilliSeconds(10)),
+                          MakeTimeAccessor(&CsmaMacNetDevice::m_dataAcquireTime),
+                          MakeTimeChecker())
+            .AddAttribute("SlotTime",
+                          "Backoff slot; DIFS is SIFS plus two slots.",
+                          TimeValue(MilliSeconds(1)),
+                          MakeTimeAccessor(&CsmaMacNetDevice::m_slotTime),
+                          MakeTimeChecker())
+            .AddAttribute("Sifs",
+                          "Gap before a CTS, DATA or ACK that answers a frame.",
+                          TimeValue(MicroSeconds(500)),
+                          MakeTimeAccessor(&CsmaMacNetDevice::m_sifs),
+                          MakeTimeChecker())
+            .AddAttribute("CwMin",
+                          "Initial contention window, in slots.",
+                          UintegerValue(16),
+                          MakeUintegerAccessor(&CsmaMacNetDevice::m_cwMin),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("CwMax",
+                          "Largest contention window reached by doubling, in slots.",
+                          UintegerValue(1024),
+                          MakeUintegerAccessor(&CsmaMacNetDevice::m_cwMax),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("RetryLimit",
+                          "Retries after a CTS or ACK timeout before DATA is dropped.",
+                          UintegerValue(7),
+                          MakeUintegerAccessor(&CsmaMacNetDevice::m_retryLimit),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("RtsCts",
+                          "Reserve the medium with RTS/CTS before every DATA frame.",
+                          BooleanValue(true),
+                          MakeBooleanAccessor(&CsmaMacNetDevice::m_rtsCts),
+                          MakeBooleanChecker())
+            .AddAttribute("QueueLimit",
+                          "Maximum number of sensor readings waiting to be sent.",
+                          UintegerValue(16),
+                          MakeUintegerAccessor(&CsmaMacNetDevice::m_queueLimit),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddTraceSource("StateTransition",
+                            "NodeState change with its reason.",
+                            MakeTraceSourceAccessor(&CsmaMacNetDevice::m_stateTrace),
+                            "ns3::MiMacNetDevice::StateTracedCallback")
+            .AddTraceSource("MacTx",
+                            "A frame was put on the medium.",
+                            MakeTraceSourceAccessor(&CsmaMacNetDevice::m_macTxTrace),
+                            "ns3::MiMacNetDevice::FrameTracedCallback")
+            .AddTraceSource("MacRx",
+                            "A frame addressed to this node was received without collision.",
+                            MakeTraceSourceAccessor(&CsmaMacNetDevice::m_macRxTrace),
+                            "ns3::MiMacNetDevice::RxTracedCallback")
+            .AddTraceSource("MacTxDrop",
+                            "DATA dropped because the queue was full or retries ran out.",
+                            MakeTraceSourceAccessor(&CsmaMacNetDevice::m_macTxDropTrace),
+                            "ns3::MiMacNetDevice::DropTracedCallback");
+    return tid;
+}
+
+inline CsmaMacNetDevice::CsmaMacNetDevice()
+    : m_address(Mac16Address::Allocate()),
+      m_ifIndex(0),
+      m_mtu(MAX_PAYLOAD),
+      m_bitRate(10000.0),
+      m_cwMin(16),
+      m_cwMax(1024),
+      m_retryLimit(7),
+      m_rtsCts(true),
+      m_queueLimit(16),
+      m_state(STATE_IDLE),
+      m_phase(PHASE_NONE),
+      m_pending(false),
+      m_cw(16),
+      m_retries(0),
+      m_backoffSlots(0),
+      m_sequence(0) {
+    m_random = CreateObject<UniformRandomVariable>();
+}
+
+inline void CsmaMacNetDevice::DoDispose() {
+    m_stateEvent.Cancel();
+    m_timeoutEvent.Cancel();
+    m_backoffEvent.Cancel();
+    m_navEvent.Cancel();
+    m_queue.clear();
+    m_node = nullptr;
+    m_random = nullptr;
+    MiRadioDevice::DoDispose();
+}
+
+inline bool CsmaMacNetDevice::SetMtu(const uint16_t mtu) {
+    if (mtu == 0 || mtu > MAX_PAYLOAD) {
+        return false;
+    }
+    m_mtu = mtu;
+    return true;
+}
+
+inline bool CsmaMacNetDevice::Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) {
+    if (packet->GetSize() == 0 || packet->GetSize() > m_mtu || m_queue.size() >= m_queueLimit) {
+        m_counters.dataDropped++;
+        m_macTxDropTrace(m_node->GetId(), packet);
+        return false;
+    }
+    m_queue.push_back(TxItem{packet, Mac16Address::ConvertFrom(dest)});
+    m_counters.dataEnqueued++;
+    if (m_state == STATE_IDLE && m_phase == PHASE_NONE) {
+        ServiceQueue();
+    }
+    return true;
+}
+
+inline void CsmaMacNetDevice::SetState(NodeState to, const char* reason) {
+    if (to == m_state) {
+        return;
+    }
+    m_stateTrace(m_node->GetId(), m_state, to, reason);
+    m_counters.stateTransitions++;
+    m_state = to;
+}
+
+inline void CsmaMacNetDevice::ServiceQueue() {
+    if (m_queue.empty()) {
+        return;
+    }
+    m_phase = PHASE_ACQUIRE;
+    SetState(STATE_DATA_ACQUIRE, "Sensor interrupt");
+    m_stateEvent = Simulator::Schedule(m_dataAcquireTime, &CsmaMacNetDevice::EndDataAcquire, this);
+}
+
+inline void CsmaMacNetDevice::EndDataAcquire() {
+    m_pending = true;
+    m_retries = 0;
+    m_cw = m_cwMin;
+    m_sequence++;
+    m_accessStart = Simulator::Now();
+    StartContention("Data ready");
+}
+
+inline bool CsmaMacNetDevice::IsMediumIdle() const {
+    return !IsMediumBusy() && !m_transmitting && Simulator::Now() >= m_navEnd;
+}
+
+// Draws a fresh backoff and contends for the medium with it.
+inline void CsmaMacNetDevice::StartContention(const char* reason) {
+    m_backoffSlots = m_random->GetInteger(0, m_cw - 1);
+    m_phase = PHASE_CONTEND;
+    SetState(STATE_CHANNEL_SENSING, reason);
+    ResumeBackoff();
+}
+
+// Restarts the countdown once the medium is idle; called whenever it may
+// have become so.
+inline void CsmaMacNetDevice::ResumeBackoff() {
+    if (m_phase != PHASE_CONTEND || m_backoffEvent.IsPending() || !IsMediumIdle()) {
+        return;
+    }
+    m_countdownStart = Simulator::Now() + GetDifs();
+    m_backoffEvent = Simulator::Schedule(GetDifs() + m_slotTime * m_backoffSlots, &CsmaMacNetDevice::AccessGranted,
+                                         this);
+}
+
+// Keeps the slots that were not counted down yet.
+inline void CsmaMacNetDevice::FreezeBackoff() {
+    if (!m_backoffEvent.IsPending()) {
+        return;
+    }
+    m_backoffEvent.Cancel();
+    m_counters.backoffs++;
+    Time counted = Simulator::Now() - m_countdownStart;
+    if (counted.IsStrictlyPositive()) {
+        uint32_t slots = static_cast<uint32_t>(counted.GetTimeStep() / m_slotTime.GetTimeStep());
+        m_backoffSlots -= std::min(slots, m_backoffSlots);
+    }
+}
+
+inline void CsmaMacNetDevice::AccessGranted() {
+    m_backoffSlots = 0;
+    SetState(STATE_TRANSMIT, "Backoff complete");
+    if (m_rtsCts) {
+        SendRts();
+    } else {
+        SendData();
+    }
+}
+
+inline void CsmaMacNetDevice::SetNav(Time until) {
+    if (until <= m_navEnd) {
+        return;
+    }
+    m_navEnd = until;
+    FreezeBackoff();
+    m_navEvent.Cancel();
+    m_navEvent = Simulator::Schedule(until - Simulator::Now(), &CsmaMacNetDevice::ResumeBackoff, this);
+}
+
+inline void CsmaMacNetDevice::SendRts() {
+    m_phase = PHASE_SEND_RTS;
+    const TxItem& item = m_queue.front();
+    Time cts = GetAirtime(GetCsmaFrameSize(CTS_PACKET));
+    Time data = GetAirtime(GetCsmaFrameSize(DATA_PACKET, item.packet->GetSize()));
+    Time ack = GetAirtime(GetCsmaFrameSize(ACK_PACKET));
+    CsmaMacHeader header(RTS_PACKET);
+    header.SetReceiver(item.dest.ConvertToInt());
+    header.SetTransmitter(m_address.ConvertToInt());
+    header.SetDuration(m_sifs * 3 + cts + data + ack);
+    Ptr<Packet> frame = Create<Packet>();
+    frame->AddHeader(header);
+    frame->AddTrailer(MiMacTrailer());
+    SendFrame(frame);
+}
+
+inline void CsmaMacNetDevice::SendCts() {
+    m_phase = PHASE_SEND_CTS;
+    SetState(STATE_TRANSMIT, "Sending CTS");
+    CsmaMacHeader header(CTS_PACKET);
+    header.SetReceiver(m_peer.ConvertToInt());
+    header.SetDuration(m_ctsDuration);
+    Ptr<Packet> frame = Create<Packet>();
+    frame->AddHeader(header);
+    frame->AddTrailer(MiMacTrailer());
+    SendFrame(frame);
+}
+
+inline void CsmaMacNetDevice::SendData() {
+    m_phase = PHASE_SEND_DATA;
+    SetState(STATE_TRANSMIT, "Sending data");
+    const TxItem& item = m_queue.front();
+    CsmaMacHeader header(DATA_PACKET);
+    header.SetPreamble(!m_rtsCts);
+    header.SetReceiver(item.dest.ConvertToInt());
+    header.SetTransmitter(m_address.ConvertToInt());
+    header.SetSequence(m_sequence);
+    header.SetDuration(m_sifs + GetAirtime(GetCsmaFrameSize(ACK_PACKET)));
+    Ptr<Packet> frame = item.packet->Copy();
+    frame->AddHeader(header);
+    frame->AddTrailer(MiMacTrailer());
+    SendFrame(frame);
+}
+
+inline void CsmaMacNetDevice::SendAck() {
+    m_phase = PHASE_SEND_ACK;
+    SetState(STATE_TRANSMIT, "Sending ACK");
+    CsmaMacHeader header(ACK_PACKET);
+    header.SetReceiver(m_peer.ConvertToInt());
+    Ptr<Packet> frame = Create<Packet>();
+    frame->AddHeader(header);
+    frame->AddTrailer(MiMacTrailer());
+    SendFrame(frame);
+}
+
+inline void CsmaMacNetDevice::SendFrame(Ptr<Packet> frame) {
+    Time airtime = GetAirtime(frame->GetSize());
+    m_macTxTrace(m_node->GetId(), frame, TX_COIL);
+    TransmitFrame(frame, TX_COIL, airtime);
+    m_stateEvent = Simulator::Schedule(airtime, &CsmaMacNetDevice::EndTx, this);
+}
+
+inline void CsmaMacNetDevice::EndTx() {
+    m_transmitting = false;
+    // A response is due within SIFS, plus one slot of slack.
+    Time slack = m_sifs + m_slotTime;
+    switch (m_phase) {
+        case PHASE_SEND_RTS:
+            m_phase = PHASE_WAIT_CTS;
+            SetState(STATE_RECEIVE, "Waiting for CTS");
+            m_timeoutEvent = Simulator::Schedule(slack + GetAirtime(GetCsmaFrameSize(CTS_PACKET)),
+                                                 &CsmaMacNetDevice::ExchangeTimeout, this);
+            break;
+        case PHASE_SEND_DATA:
+            m_phase = PHASE_WAIT_ACK;
+            SetState(STATE_RECEIVE, "Waiting for ACK");
+            m_timeoutEvent = Simulator::Schedule(slack + GetAirtime(GetCsmaFrameSize(ACK_PACKET)),
+                                                 &CsmaMacNetDevice::ExchangeTimeout, this);
+            break;
+        case PHASE_SEND_CTS:
+            m_phase = PHASE_WAIT_DATA;
+            SetState(STATE_RECEIVE, "Waiting for data");
+            m_timeoutEvent = Simulator::Schedule(slack + GetAirtime(GetCsmaFrameSize(DATA_PACKET, MAX_PAYLOAD)),
+                                                 &CsmaMacNetDevice::DataTimeout, this);
+            break;
+        case PHASE_SEND_ACK:
+            EndResponse();
+            break;
+        default:
+            break;
+    }
+}
+
+inline void CsmaMacNetDevice::NotifyRxStart() {
+    if (IsMediumBusy()) {
+        FreezeBackoff();
+    }
+}
+
+inline void CsmaMacNetDevice::HandleFrame(Ptr<MiRadioDevice> sender, Ptr<const Packet> frame, CoilID txCoil,
+                                          CoilID rxCoil, double rssi) {
+    CsmaMacHeader header;
+    frame->PeekHeader(header);
+    Mac16Address from = sender->GetMacAddress();
+    Time now = Simulator::Now();
+
+    if (header.GetReceiver() != m_address.ConvertToInt()) {
+        if (header.HasDuration()) {
+            SetNav(now + header.GetDuration());
+        }
+        return;
+    }
+    bool available = (m_phase == PHASE_NONE && m_state == STATE_IDLE) || m_phase == PHASE_CONTEND;
+
+    switch (header.GetPacketType()) {
+        case RTS_PACKET:
+            // A reservation heard from a third party takes precedence.
+            if (!available || now < m_navEnd) {
+                return;
+            }
+            m_macRxTrace(m_node->GetId(), frame, txCoil, rxCoil, rssi);
+            m_peer = from;
+            m_ctsDuration = header.GetDuration() - m_sifs - GetAirtime(GetCsmaFrameSize(CTS_PACKET));
+            m_phase = PHASE_SEND_CTS;
+            SetState(STATE_RECEIVE, "RTS received");
+            m_stateEvent = Simulator::Schedule(m_sifs, &CsmaMacNetDevice::SendCts, this);
+            break;
+        case CTS_PACKET:
+            if (m_phase != PHASE_WAIT_CTS || from != m_queue.front().dest) {
+                return;
+            }
+            m_macRxTrace(m_node->GetId(), frame, txCoil, rxCoil, rssi);
+            m_timeoutEvent.Cancel();
+            m_stateEvent = Simulator::Schedule(m_sifs, &CsmaMacNetDevice::SendData, this);
+            break;
+        case DATA_PACKET: {
+            bool expected = m_phase == PHASE_WAIT_DATA && from == m_peer;
+            if (!expected && (m_rtsCts || !available)) {
+                return;
+            }
+            m_macRxTrace(m_node->GetId(), frame, txCoil, rxCoil, rssi);
+            m_timeoutEvent.Cancel();
+            m_peer = from;
+            m_phase = PHASE_SEND_ACK;
+            SetState(STATE_RECEIVE, "Data received");
+            m_stateEvent = Simulator::Schedule(m_sifs, &CsmaMacNetDevice::SendAck, this);
+            // A retransmission after a lost ACK is acknowledged again but
+            // delivered only once.
+            auto last = m_lastSequence.find(from.ConvertToInt());
+            if (last != m_lastSequence.end() && last->second == header.GetSequence()) {
+                return;
+            }
+            m_lastSequence[from.ConvertToInt()] = header.GetSequence();
+            m_counters.dataReceived++;
+            if (!m_rxCallback.IsNull()) {
+                Ptr<Packet> payload = frame->Copy();
+                payload->RemoveHeader(header);
+                MiMacTrailer trailer;
+                payload->RemoveTrailer(trailer);
+                m_rxCallback(this, payload, 0, from);
+            }
+            break;
+        }
+        case ACK_PACKET:
+            if (m_phase != PHASE_WAIT_ACK || from != m_queue.front().dest) {
+                return;
+            }
+            m_macRxTrace(m_node->GetId(), frame, txCoil, rxCoil, rssi);
+            m_timeoutEvent.Cancel();
+            m_counters.dataSent++;
+            m_counters.accessDelay += (now - m_accessStart).GetSeconds();
+            m_queue.pop_front();
+            m_pending = false;
+            ReturnToIdle("Transmission complete");
+            break;
+        default:
+            break;
+    }
+}
+
+// No CTS or ACK: double the window and contend again, or give up.
+inline void CsmaMacNetDevice::ExchangeTimeout() {
+    m_counters.ackTimeouts++;
+    m_cw = std::min(m_cw * 2, m_cwMax);
+    if (++m_retries > m_retryLimit) {
+        m_counters.dataDropped++;
+        m_macTxDropTrace(m_node->GetId(), m_queue.front().packet);
+        m_queue.pop_front();
+        m_pending = false;
+        ReturnToIdle("Retries exhausted");
+        return;
+    }
+    m_counters.retries++;
+    StartContention(m_phase == PHASE_WAIT_CTS ? "CTS timeout, retrying" : "ACK timeout, retrying");
+}
+
+// No DATA after our CTS.
+inline void CsmaMacNetDevice::DataTimeout() {
+    m_counters.dataTimeouts++;
+    EndResponse();
+}
+
+// The destination side of an exchange is over; a reading of our own that
+// was contending picks up its frozen backoff.
+inline void CsmaMacNetDevice::EndResponse() {
+    if (!m_pending) {
+        ReturnToIdle("Exchange complete");
+        return;
+    }
+    m_phase = PHASE_CONTEND;
+    SetState(STATE_CHANNEL_SENSING, "Exchange complete, resuming backoff");
+    ResumeBackoff();
+}
+
+inline void CsmaMacNetDevice::ReturnToIdle(const char* reason) {
+    m_phase = PHASE_NONE;
+    SetState(STATE_IDLE, reason);
+    ServiceQueue();
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_CSMA_H
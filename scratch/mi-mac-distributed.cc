@@ -0,0 +1,235 @@
+// Distributed MI MAC run: a jittered lattice of randomly oriented nodes,
+// split spatially over the MPI processes it is started with (see
+// mi-mac-distributed.h), each node sending Poisson sensor readings to a
+// lattice neighbour.  A single process runs the sequential engine, so that
+// row is the baseline.  Strong scaling keeps the node count fixed as
+// processes are added; weak scaling keeps the node count per process fixed.
+// Every run appends a row to --csv and prints the scaling table of the rows
+// that match its configuration: events/s, speed-up and efficiency against
+// the single-process row.  Needs ns-3 configured with --enable-mpi; without
+// it the program only says so.
+//
+//   for np in 1 2 4 8; do
+//       ./ns3 run scratch/mi-mac-distributed --command-template="mpiexec -np $np %s --nodes=20000"
+//   done
+
+#include "mi-mac-distributed.h"
+#include "mi-mac-scenario.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+using namespace ns3;
+
+#ifdef NS3_MPI
+
+#include "ns3/mpi-module.h"
+
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mpi.h>
+
+// Totals over all processes, indexed by the enum below.
+enum DistributedCount {
+    COUNT_EVENTS,
+    COUNT_ENQUEUED,
+    COUNT_SENT,
+    COUNT_RECEIVED,
+    COUNT_COLLISIONS,
+    COUNT_TIMEOUTS,
+    COUNT_REMOTE,
+    NUM_COUNTS
+};
+
+struct ScalingRow {
+    std::string scaling;
+    uint32_t ranks = 0;
+    uint32_t nodes = 0;
+    double simTime = 0.0;
+    double eventsPerSec = 0.0;
+};
+
+const char* const CSV_HEADER =
+    "scaling,ranks,nodes,sim_time,boundary_nodes,events,wall_sec,events_per_sec,remote_frames";
+
+// Last row per process count with this scaling mode, node count per process
+// and simulated time.
+std::map<uint32_t, ScalingRow> ReadScaling(const std::string& path, const std::string& scaling, double nodesPerRank,
+                                           double simTime) {
+    std::map<uint32_t, ScalingRow> rows;
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        ScalingRow row;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        uint64_t boundary, events;
+        double wallSec;
+        if (!(fields >> row.scaling >> row.ranks >> row.nodes >> row.simTime >> boundary >> events >> wallSec >>
+              row.eventsPerSec)) {
+            continue;
+        }
+        double perRank = scaling == "weak" ? static_cast<double>(row.nodes) / row.ranks : row.nodes;
+        if (row.scaling == scaling && perRank == nodesPerRank && row.simTime == simTime) {
+            rows[row.ranks] = row;
+        }
+    }
+    return rows;
+}
+
+int main(int argc, char *argv[]) {
+    MPI_Init(&argc, &argv);
+    int rank = 0;
+    int ranks = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    std::string scaling = "strong";
+    uint32_t nodes = 20000;
+    uint32_t layers = 1;
+    double spacing = 2.0;
+    double range = 4.0;
+    double interval = 30.0;
+    uint32_t payload = 10;
+    double simTime = 60.0;
+    double lookahead = 0.8;
+    std::string csv = "mi-mac-distributed.csv";
+    uint32_t seed = 1;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("scaling", "strong: --nodes in total; weak: --nodes per process", scaling);
+    cmd.AddValue("nodes", "Number of MI nodes (see --scaling)", nodes);
+    cmd.AddValue("layers", "Lattice layers along Z", layers);
+    cmd.AddValue("spacing", "Lattice spacing between nodes (m)", spacing);
+    cmd.AddValue("range", "Coupling evaluation radius (m)", range);
+    cmd.AddValue("interval", "Mean time between sensor readings per node (s)", interval);
+    cmd.AddValue("payload", "DATA payload size (1-16 bytes)", payload);
+    cmd.AddValue("simTime", "Simulated time (s)", simTime);
+    cmd.AddValue("lookahead", "Channel delay and synchronisation lookahead (ms); default one byte at 10 kbit/s",
+                 lookahead);
+    cmd.AddValue("csv", "File the result row is appended to and the scaling table read from", csv);
+    cmd.AddValue("seed", "RNG seed", seed);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(scaling != "strong" && scaling != "weak", "--scaling must be strong or weak");
+
+    RngSeedManager::SetSeed(seed);
+    if (ranks > 1) {
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DistributedSimulatorImpl"));
+        MpiInterface::Enable(MPI_COMM_WORLD);
+    }
+    uint32_t totalNodes = scaling == "weak" ? nodes * ranks : nodes;
+
+    // Every process builds the same geometry from the same RNG stream.
+    auto setupStart = std::chrono::steady_clock::now();
+    MiTopology topology = MiTopology::Lattice(totalNodes, std::max(layers, 1u), spacing, interval, payload);
+    MiPartition partition = MiPartition::Bisect(topology, ranks);
+    NodeContainer nodeContainer;
+    for (uint32_t i = 0; i < totalNodes; i++) {
+        nodeContainer.Add(CreateObject<Node>(partition.owner[i]));
+    }
+    MiMacHelper mac;
+    mac.SetChannelAttribute("Range", DoubleValue(range));
+    mac.SetChannelAttribute("Delay", TimeValue(MicroSeconds(lookahead * 1000.0)));
+    NetDeviceContainer devices = mac.Install(nodeContainer);
+    Ptr<MiMacChannel> channel = DynamicCast<MiMacChannel>(devices.Get(0)->GetChannel());
+    MiScenarioTopology(topology, nodeContainer, devices, rank);
+    MiMpiBridge bridge;
+    if (ranks > 1) {
+        bridge.Install(channel);
+    }
+    Simulator::Stop(Seconds(simTime));
+
+    auto runStart = std::chrono::steady_clock::now();
+    Simulator::Run();
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    double setupSec = std::chrono::duration<double>(runStart - setupStart).count();
+
+    MiMacCounters local;
+    for (uint32_t i = 0; i < totalNodes; i++) {
+        if (partition.owner[i] == static_cast<uint32_t>(rank)) {
+            local += DynamicCast<MiRadioDevice>(devices.Get(i))->GetCounters();
+        }
+    }
+    uint64_t counts[NUM_COUNTS] = {Simulator::GetEventCount(), local.dataEnqueued, local.dataSent,
+                                   local.dataReceived, local.collisions, local.ackTimeouts, bridge.GetSent()};
+    uint64_t totals[NUM_COUNTS];
+    MPI_Reduce(counts, totals, NUM_COUNTS, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    double slowestSec;
+    MPI_Reduce(&wallSec, &slowestSec, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    Simulator::Destroy();
+
+    if (rank == 0) {
+        uint32_t boundary = partition.CountBoundary(topology, range);
+        double eventsPerSec = totals[COUNT_EVENTS] / slowestSec;
+
+        std::cout << "\n" << std::string(70, '=') << std::endl;
+        std::cout << "   DISTRIBUTED MI MAC RUN (" << scaling << " scaling)" << std::endl;
+        std::cout << std::string(70, '=') << std::endl;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "\n  Processes:               " << ranks << (ranks == 1 ? " (sequential engine)" : "")
+                  << std::endl;
+        std::cout << "  Nodes:                   " << totalNodes << " (" << totalNodes / ranks << " per process)"
+                  << std::endl;
+        std::cout << "  Boundary nodes:          " << boundary << " ("
+                  << 100.0 * boundary / std::max(totalNodes, 1u) << "%)" << std::endl;
+        std::cout << "  Lookahead:               " << lookahead << " ms" << std::endl;
+        std::cout << "  Simulated time:          " << simTime << " s" << std::endl;
+        std::cout << "  Setup time:              " << setupSec << " s" << std::endl;
+        std::cout << "  Run time:                " << slowestSec << " s (slowest process)" << std::endl;
+        std::cout << "  Events executed:         " << totals[COUNT_EVENTS] << std::endl;
+        std::cout << "  Events per second:       " << eventsPerSec << std::endl;
+        std::cout << "  Cross-process frames:    " << totals[COUNT_REMOTE] << std::endl;
+        std::cout << "\n  Readings queued:         " << totals[COUNT_ENQUEUED] << std::endl;
+        std::cout << "  DATA sent / delivered:   " << totals[COUNT_SENT] << " / " << totals[COUNT_RECEIVED]
+                  << std::endl;
+        std::cout << "  ACK timeouts:            " << totals[COUNT_TIMEOUTS] << std::endl;
+        std::cout << "  Collisions:              " << totals[COUNT_COLLISIONS] << std::endl;
+
+        bool fresh = !std::ifstream(csv).good();
+        std::ofstream out(csv, std::ios::app);
+        out << std::setprecision(10);
+        if (fresh) {
+            out << CSV_HEADER << "\n";
+        }
+        out << scaling << "," << ranks << "," << totalNodes << "," << simTime << "," << boundary << ","
+            << totals[COUNT_EVENTS] << "," << slowestSec << "," << eventsPerSec << "," << totals[COUNT_REMOTE]
+            << "\n";
+        out.close();
+
+        double perRank = scaling == "weak" ? nodes : totalNodes;
+        std::map<uint32_t, ScalingRow> rows = ReadScaling(csv, scaling, perRank, simTime);
+        auto baseline = rows.find(1);
+        std::cout << "\n  " << (scaling == "weak" ? "Weak" : "Strong") << " scaling (" << csv << "):" << std::endl;
+        std::cout << std::setw(12) << "Processes" << std::setw(10) << "Nodes" << std::setw(16) << "Events/s"
+                  << std::setw(12) << "Speed-up" << std::setw(14) << "Efficiency" << std::endl;
+        for (const auto& [count, row] : rows) {
+            std::cout << std::setw(12) << count << std::setw(10) << row.nodes << std::setw(16) << row.eventsPerSec;
+            if (baseline != rows.end()) {
+                double speedup = row.eventsPerSec / baseline->second.eventsPerSec;
+                std::cout << std::setw(11) << speedup << "x" << std::setw(13) << 100.0 * speedup / count << "%";
+            }
+            std::cout << std::endl;
+        }
+        if (baseline == rows.end()) {
+            std::cout << "  (run with one process for the baseline)" << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    if (ranks > 1) {
+        MpiInterface::Disable();
+    }
+    MPI_Finalize();
+    return 0;
+}
+
+#else // NS3_MPI
+
+int main(int argc, char *argv[]) {
+    std::cout << "mi-mac-distributed needs ns-3 configured with --enable-mpi" << std::endl;
+    return 0;
+}
+
+#endif // NS3_MPI
@@ -0,0 +1,221 @@
+#ifndef MI_MAC_DISTRIBUTED_H
+#define MI_MAC_DISTRIBUTED_H
+
+// Distributed runs under ns-3's MPI simulator (configure with --enable-mpi).
+//
+// As usual with ns-3's distributed engine every process creates every node,
+// device and the full channel geometry, but a node belongs to one process
+// through its system id and only that process simulates it.  MiPartition
+// assigns the system ids by recursive coordinate bisection.  The channel
+// evaluates coupling only within Range, so frames cross between processes
+// only over links that span a cut; MiMpiBridge carries those as MPI
+// packets.  Remote frames arrive the channel's Delay after they start, which
+// is the lookahead of the conservative synchronisation, so every run of a
+// distributed scenario, the single-process baseline included, uses the same
+// non-zero Delay.  MiMpiBridge needs ns-3 built with MPI (NS3_MPI); the
+// partitioning builds without it.
+
+#include "mi-mac-grid.h"
+#include "mi-mac-net-device.h"
+#include "mi-mac-topology.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#ifdef NS3_MPI
+#include "ns3/mpi-module.h"
+#endif
+
+#include <algorithm>
+#include <numeric>
+
+namespace ns3 {
+
+// Prepended to a frame sent to another process: what MiMacChannel passes to
+// StartRx() besides the frame.  Devices are named by channel index, which
+// is the same in every process.
+class MiRemoteRxHeader : public Header {
+  public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::MiRemoteRxHeader")
+                                .SetParent<Header>()
+                                .SetGroupName("MiMac")
+                                .AddConstructor<MiRemoteRxHeader>();
+        return tid;
+    }
+    TypeId GetInstanceTypeId() const override { return GetTypeId(); }
+
+    uint32_t receiver = 0;
+    uint32_t sender = 0;
+    CoilID txCoil = COIL_X;
+    MiCoilPower power;
+    Time duration;
+
+    uint32_t GetSerializedSize() const override { return 4 + 4 + 1 + NUM_COILS * 8 + 8; }
+
+    void Serialize(Buffer::Iterator start) const override {
+        start.WriteHtonU32(receiver);
+        start.WriteHtonU32(sender);
+        start.WriteU8(txCoil);
+        for (int c = 0; c < NUM_COILS; c++) {
+            uint64_t bits;
+            std::memcpy(&bits, &power.mw[c], sizeof(bits));
+            start.WriteHtonU64(bits);
+        }
+        start.WriteHtonU64(duration.GetNanoSeconds());
+    }
+
+    uint32_t Deserialize(Buffer::Iterator start) override {
+        receiver = start.ReadNtohU32();
+        sender = start.ReadNtohU32();
+        txCoil = static_cast<CoilID>(start.ReadU8());
+        for (int c = 0; c < NUM_COILS; c++) {
+            uint64_t bits = start.ReadNtohU64();
+            std::memcpy(&power.mw[c], &bits, sizeof(bits));
+        }
+        duration = NanoSeconds(static_cast<int64_t>(start.ReadNtohU64()));
+        return GetSerializedSize();
+    }
+
+    void Print(std::ostream& os) const override { os << "remote rx " << sender << " -> " << receiver; }
+};
+
+// Node -> process assignment.  Each cut halves the process set and splits
+// the nodes in proportion across the longest axis of their bounding box,
+// so parts hold equal node counts and stay compact.
+struct MiPartition {
+    std::vector<uint32_t> owner;  // system id per node
+
+    static MiPartition Bisect(const MiTopology& topology, uint32_t parts);
+    // Nodes with a neighbour within range in another part.
+    uint32_t CountBoundary(const MiTopology& topology, double range) const;
+
+  private:
+    static void Split(const MiTopology& topology, std::vector<uint32_t>::iterator first,
+                      std::vector<uint32_t>::iterator last, uint32_t firstPart, uint32_t parts,
+                      std::vector<uint32_t>& owner);
+};
+
+inline MiPartition MiPartition::Bisect(const MiTopology& topology, uint32_t parts) {
+    MiPartition partition;
+    partition.owner.resize(topology.GetN());
+    std::vector<uint32_t> order(topology.GetN());
+    std::iota(order.begin(), order.end(), 0);
+    Split(topology, order.begin(), order.end(), 0, std::max(parts, 1u), partition.owner);
+    return partition;
+}
+
+inline void MiPartition::Split(const MiTopology& topology, std::vector<uint32_t>::iterator first,
+                               std::vector<uint32_t>::iterator last, uint32_t firstPart, uint32_t parts,
+                               std::vector<uint32_t>& owner) {
+    if (parts == 1 || first == last) {
+        for (auto it = first; it != last; ++it) {
+            owner[*it] = firstPart;
+        }
+        return;
+    }
+    const std::vector<double>* axes[3] = {&topology.x, &topology.y, &topology.z};
+    const std::vector<double>* longest = axes[0];
+    double longestExtent = -1.0;
+    for (const std::vector<double>* axis : axes) {
+        auto [lo, hi] = std::minmax_element(first, last, [axis](uint32_t a, uint32_t b) {
+            return (*axis)[a] < (*axis)[b];
+        });
+        double extent = (*axis)[*hi] - (*axis)[*lo];
+        if (extent > longestExtent) {
+            longestExtent = extent;
+            longest = axis;
+        }
+    }
+    uint32_t lowParts = parts / 2;
+    auto middle = first + (last - first) * lowParts / parts;
+    std::nth_element(first, middle, last, [longest](uint32_t a, uint32_t b) { return (*longest)[a] < (*longest)[b]; });
+    Split(topology, first, middle, firstPart, lowParts, owner);
+    Split(topology, middle, last, firstPart + lowParts, parts - lowParts, owner);
+}
+
+inline uint32_t MiPartition::CountBoundary(const MiTopology& topology, double range) const {
+    MiSpatialGrid grid;
+    grid.Build(topology.x, topology.y, topology.z, range);
+    double rangeSq = range * range;
+    uint32_t boundary = 0;
+    for (uint32_t i = 0; i < topology.GetN(); i++) {
+        bool crosses = false;
+        grid.ForEachCandidate(topology.x[i], topology.y[i], topology.z[i], [&](uint32_t j) {
+            double dx = topology.x[j] - topology.x[i];
+            double dy = topology.y[j] - topology.y[i];
+            double dz = topology.z[j] - topology.z[i];
+            crosses = crosses || (owner[j] != owner[i] && dx * dx + dy * dy + dz * dz <= rangeSq);
+        });
+        boundary += crosses;
+    }
+    return boundary;
+}
+
+#ifdef NS3_MPI
+
+// Connects a channel's devices across processes: frames for devices simulated
+// elsewhere leave through MpiInterface::SendPacket(), and those arriving
+// for local devices are handed to StartRx().  Install() before Run().
+class MiMpiBridge {
+  public:
+    void Install(Ptr<MiMacChannel> channel);
+
+    uint64_t GetSent() const { return m_sent; }
+    uint64_t GetReceived() const { return m_received; }
+
+  private:
+    void Send(Ptr<MiRadioDevice> receiver, Ptr<MiRadioDevice> sender, Ptr<const Packet> frame, CoilID txCoil,
+              MiCoilPower power, Time duration);
+    void Receive(Ptr<Packet> packet);
+
+    Ptr<MiMacChannel> m_channel;
+    uint64_t m_sent = 0;
+    uint64_t m_received = 0;
+};
+
+inline void MiMpiBridge::Install(Ptr<MiMacChannel> channel) {
+    NS_ABORT_MSG_IF(!channel->GetDelay().IsStrictlyPositive(), "distributed runs need a non-zero channel Delay");
+    m_channel = channel;
+    uint32_t systemId = MpiInterface::GetSystemId();
+    for (size_t i = 0; i < channel->GetNDevices(); i++) {
+        Ptr<NetDevice> device = channel->GetDevice(i);
+        if (device->GetNode()->GetSystemId() == systemId) {
+            Ptr<MpiReceiver> receiver = CreateObject<MpiReceiver>();
+            receiver->SetReceiveCallback(MakeCallback(&MiMpiBridge::Receive, this));
+            device->AggregateObject(receiver);
+        }
+    }
+    channel->SetRemoteRxCallback(systemId, MakeCallback(&MiMpiBridge::Send, this));
+    DynamicCast<DistributedSimulatorImpl>(Simulator::GetImplementation())->BoundLookAhead(channel->GetDelay());
+}
+
+inline void MiMpiBridge::Send(Ptr<MiRadioDevice> receiver, Ptr<MiRadioDevice> sender, Ptr<const Packet> frame,
+                              CoilID txCoil, MiCoilPower power, Time duration) {
+    MiRemoteRxHeader header;
+    header.receiver = receiver->GetChannelIndex();
+    header.sender = sender->GetChannelIndex();
+    header.txCoil = txCoil;
+    header.power = power;
+    header.duration = duration;
+    Ptr<Packet> packet = frame->Copy();
+    packet->AddHeader(header);
+    MpiInterface::SendPacket(packet, Simulator::Now() + m_channel->GetDelay(), receiver->GetNode()->GetId(),
+                             receiver->GetIfIndex());
+    m_sent++;
+}
+
+inline void MiMpiBridge::Receive(Ptr<Packet> packet) {
+    MiRemoteRxHeader header;
+    packet->RemoveHeader(header);
+    Ptr<MiRadioDevice> receiver = DynamicCast<MiRadioDevice>(m_channel->GetDevice(header.receiver));
+    Ptr<MiRadioDevice> sender = DynamicCast<MiRadioDevice>(m_channel->GetDevice(header.sender));
+    receiver->StartRx(sender, packet, header.txCoil, header.power, header.duration);
+    m_received++;
+}
+
+#endif // NS3_MPI
+
+} // namespace ns3
+
+#endif // MI_MAC_DISTRIBUTED_H
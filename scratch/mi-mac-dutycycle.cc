@@ -0,0 +1,103 @@
+// Duty-cycled receivers against the always-on MAC on the lattice scenario.
+//
+// Every wake interval is run at the same offered load as the always-on
+// receiver (wake interval 0).  An idle node sleeps at
+// SleepCurrent and listens for ListenTime once per interval; each REV round
+// pays a carrier preamble of one interval so the destination is awake for
+// it.  Longer intervals cut the idle draw but add about half an interval of
+// latency per handshake and a full interval of transmit current, so the
+// lifetime peaks at an interval that depends on the load.  The table
+// reports, per interval: delivery, mean access delay (reading ready to DATA
+// done), average current, share of time asleep, wake-ups per node-second
+// and the mean and shortest battery lifetime.  --results appends every run
+// to a columnar results file (see mi-mac-results.h).
+//
+//   ./ns3 run "scratch/mi-mac-dutycycle --nodes=400 --interval=60 --wake=0,0.05,0.1,0.2,0.5,1"
+
+#include "mi-mac-results.h"
+#include "mi-mac-scenario.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+using namespace ns3;
+
+int main(int argc, char *argv[]) {
+    MiScenarioConfig config;
+    std::string wakeList = "0,0.05,0.1,0.2,0.5,1";
+    uint32_t seed = 1;
+    std::string resultsFile;
+
+    config.nodes = 400;
+    config.simTime = 600.0;
+    config.meanInterval = 60.0;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nodes", "Number of nodes on the lattice", config.nodes);
+    cmd.AddValue("spacing", "Lattice spacing between nodes (m)", config.spacing);
+    cmd.AddValue("range", "Coupling evaluation radius (m)", config.range);
+    cmd.AddValue("simTime", "Simulated time per run (s)", config.simTime);
+    cmd.AddValue("interval", "Mean time between sensor readings per node (s)", config.meanInterval);
+    cmd.AddValue("payload", "Sensor reading size (bytes)", config.payloadSize);
+    cmd.AddValue("wake", "Comma-separated wake intervals (s); 0 is the always-on receiver", wakeList);
+    cmd.AddValue("listenTime", "Time a wake-up listens for a preamble (s)", config.listenTime);
+    cmd.AddValue("sleepCurrent", "Current of a sleeping idle node (µA)", config.sleepCurrent);
+    cmd.AddValue("seed", "RNG seed", seed);
+    cmd.AddValue("results", "Append every run to this columnar results file", resultsFile);
+    cmd.Parse(argc, argv);
+
+    RngSeedManager::SetSeed(seed);
+    std::vector<double> wakeIntervals = MiParseList<double>(wakeList);
+    NS_ABORT_MSG_IF(wakeIntervals.empty(), "no wake intervals");
+    NS_ABORT_MSG_IF(config.listenTime <= 0.0, "listenTime must be positive");
+
+    std::cout << "\n" << std::string(70, '=') << std::endl;
+    std::cout << "   MI MAC DUTY-CYCLED RECEIVER" << std::endl;
+    std::cout << std::string(70, '=') << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n  Nodes:                   " << config.nodes << std::endl;
+    std::cout << "  Simulated time:          " << config.simTime << " s" << std::endl;
+    std::cout << "  Offered load:            one " << config.payloadSize << " B reading per node every "
+              << config.meanInterval << " s (mean)" << std::endl;
+    std::cout << "  Listen / sleep current:  " << 1e3 * config.listenTime << " ms per wake-up, "
+              << config.sleepCurrent << " µA asleep" << std::endl;
+
+    std::cout << "\n" << std::setw(8) << "Wake s" << std::setw(11) << "Delivery" << std::setw(13) << "Latency ms"
+              << std::setw(10) << "Avg µA" << std::setw(9) << "Asleep" << std::setw(13) << "Wakeups/s"
+              << std::setw(13) << "Mean days" << std::setw(13) << "Min days" << std::setw(11) << "vs on"
+              << std::endl;
+    MiResultWriter writer;
+    if (!resultsFile.empty()) {
+        writer.Open(resultsFile, MiRunRecord::Columns());
+    }
+    double alwaysOnDays = 0.0;
+    for (double wake : wakeIntervals) {
+        config.wakeInterval = wake;
+        MiMacStats stats;
+        MiScenarioResult result = RunMiScenario(config, nullptr, writer.IsOpen() ? &stats : nullptr);
+        if (writer.IsOpen()) {
+            MiMakeRunRecord(config, result, &stats).Append(writer, "dutycycle");
+        }
+        double meanDays = result.meanLifetime.GetSeconds() / 86400.0;
+        if (wake == 0.0) {
+            alwaysOnDays = meanDays;
+        }
+        std::cout << std::setw(8) << wake << std::setw(11) << result.DeliveryRatio() << std::setw(13)
+                  << 1e3 * result.MeanAccessDelay() << std::setw(10) << result.meanCurrent << std::setw(8)
+                  << 100.0 * result.sleepShare << "%" << std::setw(13)
+                  << result.counters.wakeups / (config.simTime * result.nodes) << std::setw(13) << meanDays
+                  << std::setw(13) << result.shortestLifetime.GetSeconds() / 86400.0;
+        if (alwaysOnDays > 0.0) {
+            std::cout << std::setw(10) << meanDays / alwaysOnDays << "x";
+        } else {
+            std::cout << std::setw(11) << "-";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::endl;
+    if (writer.IsOpen()) {
+        writer.Close();
+        std::cout << "  Runs appended to " << resultsFile << "\n" << std::endl;
+    }
+    return 0;
+}
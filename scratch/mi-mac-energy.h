@@ -0,0 +1,243 @@
+#ifndef MI_MAC_ENERGY_H
+#define MI_MAC_ENERGY_H
+
+// Time-integrated energy accounting for MiMacNetDevice nodes.
+//
+// Every node draws the Table II current of its NodeState for as long as it
+// stays there.  The model keeps one row per node in structure-of-arrays form
+// (state, time of the last transition, accumulated charge, dwell time per
+// state) and touches a row only when that node changes state, so the cost
+// is one update per transition regardless of node count.  Frame airtime,
+// and with it transmit energy, follows from the frame's real size and the
+// device bit rate because TRANSMIT lasts exactly as long as the frame.
+//
+// Queries include the time spent in the current state up to Simulator::Now(),
+// so energy and projected battery lifetime can be read mid-run.
+//
+// A duty-cycled MiMacNetDevice sleeps inside IDLE (RadioSleep trace); that
+// time draws SleepCurrent instead of the IDLE current and is also reported
+// on its own by GetSleepTime().
+
+#include "mi-mac-net-device.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <vector>
+
+namespace ns3 {
+
+class MiEnergyModel : public Object {
+  public:
+    static TypeId GetTypeId();
+
+    MiEnergyModel();
+
+    // Starts accounting for the given devices, all in IDLE from now on.
+    void Install(const NetDeviceContainer& devices);
+
+    uint32_t GetN() const { return m_state.size(); }
+    // Row of a node, or GetN() if the node is not accounted.
+    uint32_t GetIndex(uint32_t nodeId) const;
+
+    double GetEnergy(uint32_t index) const;     // µJ
+    double GetCharge(uint32_t index) const;     // µC (µA x s)
+    double GetStateTime(uint32_t index, NodeState state) const;  // s
+    double GetStateEnergy(uint32_t index, NodeState state) const;  // µJ
+    double GetSleepTime(uint32_t index) const;  // s, part of the IDLE time
+    double GetAverageCurrent(uint32_t index) const;  // µA since Install()
+    uint32_t GetTransitions(uint32_t index) const { return m_transitions[index]; }
+    double GetTotalEnergy() const;  // µJ over all nodes
+
+    // Battery left after the charge drawn so far (mAh, never below zero).
+    double GetRemainingCapacity(uint32_t index) const;
+    // Time until the battery is empty if the node keeps drawing its average
+    // current so far, measured from Install().
+    Time GetLifetime(uint32_t index) const;
+
+    // Totals in the EnergyMetrics form used by the comparison programs.
+    EnergyMetrics GetMetrics() const;
+
+    const EnergyMetrics& GetCurrents() const { return m_currents; }
+
+  private:
+    static void StateTransition(MiEnergyModel* model, uint32_t nodeId, NodeState from, NodeState to,
+                                const char* reason);
+    static void RadioSleep(MiEnergyModel* model, uint32_t nodeId, bool asleep);
+    // Books the time since the last change of a row at its current draw.
+    void Accrue(uint32_t index);
+    double Current(uint32_t index) const;  // µA
+    double PendingSeconds(uint32_t index) const;
+
+    EnergyMetrics m_currents;  // Table II currents
+    double m_supplyVoltage;    // V
+    double m_batteryCapacity;  // mAh
+    double m_sleepCurrent;     // µA
+    Time m_start;
+
+    std::vector<uint32_t> m_indexOfNode;
+    std::vector<uint8_t> m_state;
+    std::vector<uint8_t> m_asleep;
+    std::vector<int64_t> m_since;  // time step of the last transition or sleep change
+    std::vector<double> m_charge;  // µA x s, up to m_since
+    std::vector<double> m_dwell[NUM_STATES];  // s, up to m_since
+    std::vector<double> m_sleep;   // s, up to m_since
+    std::vector<uint32_t> m_transitions;
+};
+
+inline TypeId MiEnergyModel::GetTypeId() {
+    static TypeId tid = TypeId("ns3::MiEnergyModel")
+                            .SetParent<Object>()
+                            .SetGroupName("MiMac")
+                            .AddConstructor<MiEnergyModel>()
+                            .AddAttribute("SupplyVoltage",
+                                          "Supply voltage the Table II currents are drawn at (V).",
+                                          DoubleValue(3.0),
+                                          MakeDoubleAccessor(&MiEnergyModel::m_supplyVoltage),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddAttribute("BatteryCapacity",
+                                          "Usable battery capacity of each node (mAh).",
+                                          DoubleValue(230.0),
+                                          MakeDoubleAccessor(&MiEnergyModel::m_batteryCapacity),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddAttribute("SleepCurrent",
+                                          "Current of an idle node whose receiver is duty-cycled off (µA).",
+                                          DoubleValue(1.0),
+                                          MakeDoubleAccessor(&MiEnergyModel::m_sleepCurrent),
+                                          MakeDoubleChecker<double>(0.0));
+    return tid;
+}
+
+inline MiEnergyModel::MiEnergyModel()
+    : m_supplyVoltage(3.0),
+      m_batteryCapacity(230.0),
+      m_sleepCurrent(1.0) {}
+
+inline void MiEnergyModel::Install(const NetDeviceContainer& devices) {
+    m_start = Simulator::Now();
+    uint32_t n = devices.GetN();
+    m_state.assign(n, STATE_IDLE);
+    m_asleep.assign(n, 0);
+    m_since.assign(n, m_start.GetTimeStep());
+    m_charge.assign(n, 0.0);
+    for (int s = 0; s < NUM_STATES; s++) {
+        m_dwell[s].assign(n, 0.0);
+    }
+    m_sleep.assign(n, 0.0);
+    m_transitions.assign(n, 0);
+    m_indexOfNode.clear();
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t nodeId = devices.Get(i)->GetNode()->GetId();
+        if (nodeId >= m_indexOfNode.size()) {
+            m_indexOfNode.resize(nodeId + 1, n);
+        }
+        m_indexOfNode[nodeId] = i;
+        devices.Get(i)->TraceConnectWithoutContext("StateTransition",
+                                                   MakeBoundCallback(&MiEnergyModel::StateTransition, this));
+        Ptr<MiMacNetDevice> mac = DynamicCast<MiMacNetDevice>(devices.Get(i));
+        if (mac) {
+            m_asleep[i] = mac->IsAsleep();
+            mac->TraceConnectWithoutContext("RadioSleep", MakeBoundCallback(&MiEnergyModel::RadioSleep, this));
+        }
+    }
+}
+
+inline uint32_t MiEnergyModel::GetIndex(uint32_t nodeId) const {
+    return nodeId < m_indexOfNode.size() ? m_indexOfNode[nodeId] : GetN();
+}
+
+inline void MiEnergyModel::StateTransition(MiEnergyModel* model, uint32_t nodeId, NodeState from, NodeState to,
+                                           const char* reason) {
+    uint32_t i = model->m_indexOfNode[nodeId];
+    model->Accrue(i);
+    model->m_state[i] = to;
+    model->m_transitions[i]++;
+}
+
+inline void MiEnergyModel::RadioSleep(MiEnergyModel* model, uint32_t nodeId, bool asleep) {
+    uint32_t i = model->m_indexOfNode[nodeId];
+    model->Accrue(i);
+    model->m_asleep[i] = asleep;
+}
+
+inline void MiEnergyModel::Accrue(uint32_t index) {
+    int64_t now = Simulator::Now().GetTimeStep();
+    double seconds = TimeStep(now - m_since[index]).GetSeconds();
+    m_charge[index] += Current(index) * seconds;
+    m_dwell[m_state[index]][index] += seconds;
+    if (m_asleep[index]) {
+        m_sleep[index] += seconds;
+    }
+    m_since[index] = now;
+}
+
+inline double MiEnergyModel::Current(uint32_t index) const {
+    if (m_asleep[index] && m_state[index] == STATE_IDLE) {
+        return m_sleepCurrent;
+    }
+    return m_currents.CurrentFor(static_cast<NodeState>(m_state[index]));
+}
+
+inline double MiEnergyModel::PendingSeconds(uint32_t index) const {
+    return TimeStep(Simulator::Now().GetTimeStep() - m_since[index]).GetSeconds();
+}
+
+inline double MiEnergyModel::GetCharge(uint32_t index) const {
+    return m_charge[index] + Current(index) * PendingSeconds(index);
+}
+
+inline double MiEnergyModel::GetEnergy(uint32_t index) const {
+    return GetCharge(index) * m_supplyVoltage;
+}
+
+inline double MiEnergyModel::GetStateTime(uint32_t index, NodeState state) const {
+    return m_dwell[state][index] + (m_state[index] == state ? PendingSeconds(index) : 0.0);
+}
+
+inline double MiEnergyModel::GetSleepTime(uint32_t index) const {
+    return m_sleep[index] + (m_asleep[index] ? PendingSeconds(index) : 0.0);
+}
+
+inline double MiEnergyModel::GetStateEnergy(uint32_t index, NodeState state) const {
+    double charge = GetStateTime(index, state) * m_currents.CurrentFor(state);
+    if (state == STATE_IDLE) {
+        double sleep = GetSleepTime(index);
+        charge += sleep * (m_sleepCurrent - m_currents.CurrentFor(STATE_IDLE));
+    }
+    return charge * m_supplyVoltage;
+}
+
+inline double MiEnergyModel::GetAverageCurrent(uint32_t index) const {
+    double elapsed = (Simulator::Now() - m_start).GetSeconds();
+    return elapsed > 0.0 ? GetCharge(index) / elapsed : m_currents.CurrentFor(STATE_IDLE);
+}
+
+inline double MiEnergyModel::GetTotalEnergy() const {
+    double total = 0.0;
+    for (uint32_t i = 0; i < GetN(); i++) {
+        total += GetEnergy(i);
+    }
+    return total;
+}
+
+inline double MiEnergyModel::GetRemainingCapacity(uint32_t index) const {
+    // mAh = µA x s / 3.6e6
+    return std::max(0.0, m_batteryCapacity - GetCharge(index) / 3.6e6);
+}
+
+inline Time MiEnergyModel::GetLifetime(uint32_t index) const {
+    return Seconds(m_batteryCapacity * 3.6e6 / GetAverageCurrent(index));
+}
+
+inline EnergyMetrics MiEnergyModel::GetMetrics() const {
+    EnergyMetrics metrics = m_currents;
+    metrics.totalEnergy = GetTotalEnergy();
+    for (uint32_t i = 0; i < GetN(); i++) {
+        metrics.stateTransitions += m_transitions[i];
+    }
+    return metrics;
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_ENERGY_H
@@ -0,0 +1,83 @@
+// Neighbour-search benchmark: brute force versus the uniform-grid index.
+//
+// Nodes are spread uniformly over a square whose size keeps the mean number
+// of neighbours within range constant, so the grid's work per query stays
+// flat while brute force grows with N.
+//
+//   ./ns3 run "scratch/mi-mac-grid-bench --queries=2000 --neighbours=8"
+
+#include "mi-mac-grid.h"
+
+#include "ns3/core-module.h"
+
+#include <chrono>
+
+using namespace ns3;
+
+int main(int argc, char *argv[]) {
+    uint32_t queries = 2000;
+    double range = 4.0;
+    double neighbours = 8.0;
+    uint32_t maxNodes = 100000;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("queries", "Range queries timed per node count", queries);
+    cmd.AddValue("range", "Query radius (m)", range);
+    cmd.AddValue("neighbours", "Mean number of nodes within range", neighbours);
+    cmd.AddValue("maxNodes", "Largest node count (1k, 10k, 100k, ... up to this)", maxNodes);
+    cmd.Parse(argc, argv);
+
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+
+    std::cout << "\n" << std::string(70, '=') << std::endl;
+    std::cout << "   NEIGHBOUR SEARCH: BRUTE FORCE vs GRID" << std::endl;
+    std::cout << std::string(70, '=') << std::endl;
+    std::cout << "\n" << std::setw(10) << "Nodes" << std::setw(14) << "Build (ms)" << std::setw(16) << "Brute (q/s)"
+              << std::setw(16) << "Grid (q/s)" << std::setw(12) << "Speed-up" << std::setw(10) << "Match" << std::endl;
+
+    for (uint32_t n = 1000; n <= maxNodes; n *= 10) {
+        double side = std::sqrt(n * M_PI * range * range / neighbours);
+        std::vector<double> x(n), y(n), z(n, 0.0);
+        for (uint32_t i = 0; i < n; i++) {
+            x[i] = random->GetValue(0, side);
+            y[i] = random->GetValue(0, side);
+        }
+        std::vector<uint32_t> origin(queries);
+        for (uint32_t q = 0; q < queries; q++) {
+            origin[q] = random->GetInteger(0, n - 1);
+        }
+        double rangeSq = range * range;
+        auto inRange = [&](uint32_t s, uint32_t i) {
+            double dx = x[i] - x[s], dy = y[i] - y[s], dz = z[i] - z[s];
+            return i != s && dx * dx + dy * dy + dz * dz <= rangeSq;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t bruteFound = 0;
+        for (uint32_t s : origin) {
+            for (uint32_t i = 0; i < n; i++) {
+                bruteFound += inRange(s, i);
+            }
+        }
+        double bruteSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        MiSpatialGrid grid;
+        grid.Build(x, y, z, range);
+        double buildSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        uint64_t gridFound = 0;
+        for (uint32_t s : origin) {
+            grid.ForEachCandidate(x[s], y[s], z[s], [&](uint32_t i) { gridFound += inRange(s, i); });
+        }
+        double gridSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::fixed << std::setprecision(1) << std::setw(10) << n << std::setw(14) << buildSec * 1e3
+                  << std::setw(16) << std::setprecision(0) << queries / bruteSec << std::setw(16) << queries / gridSec
+                  << std::setw(11) << std::setprecision(1) << bruteSec / gridSec << "x" << std::setw(10)
+                  << (bruteFound == gridFound ? "yes" : "NO") << std::endl;
+    }
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,204 @@
+#ifndef MI_MAC_GRID_H
+#define MI_MAC_GRID_H
+
+// Uniform-grid (cell list) index over node positions.
+//
+// Cells are at least one MI range wide, so every node within range of a
+// point lies in the 3x3x3 block of cells around it.  The grid is stored in
+// compressed form: cellStart[c] .. cellStart[c + 1] indexes into items, the
+// node indices sorted by cell.  Building is a counting sort, O(N).
+//
+// MiDynamicGrid is the same index for geometry that changes during a run:
+// occupied cells live in a hash map, so moving one node costs O(1) instead
+// of a rebuild.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class MiSpatialGrid {
+  public:
+    // Caps the number of cells relative to the node count so that sparse,
+    // widely spread deployments do not allocate huge empty grids.
+    static const uint32_t MAX_CELLS_PER_NODE = 4;
+
+    void Build(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+               double range) {
+        size_t n = x.size();
+        m_range = range;
+        m_cellStart.clear();
+        m_items.resize(n);
+        if (n == 0) {
+            return;
+        }
+
+        m_min[0] = *std::min_element(x.begin(), x.end());
+        m_min[1] = *std::min_element(y.begin(), y.end());
+        m_min[2] = *std::min_element(z.begin(), z.end());
+        double extent[3] = {*std::max_element(x.begin(), x.end()) - m_min[0],
+                            *std::max_element(y.begin(), y.end()) - m_min[1],
+                            *std::max_element(z.begin(), z.end()) - m_min[2]};
+        m_cellSize = std::max(range, 1e-9);
+        for (;;) {
+            uint64_t cells = 1;
+            for (int a = 0; a < 3; a++) {
+                m_dim[a] = static_cast<uint32_t>(extent[a] / m_cellSize) + 1;
+                cells *= m_dim[a];
+            }
+            if (cells <= MAX_CELLS_PER_NODE * n + 27) {
+                break;
+            }
+            m_cellSize *= 2.0;
+        }
+
+        uint32_t cellCount = m_dim[0] * m_dim[1] * m_dim[2];
+        m_cellStart.assign(cellCount + 1, 0);
+        std::vector<uint32_t> cellOf(n);
+        for (size_t i = 0; i < n; i++) {
+            cellOf[i] = CellIndex(x[i], y[i], z[i]);
+            m_cellStart[cellOf[i] + 1]++;
+        }
+        for (uint32_t c = 0; c < cellCount; c++) {
+            m_cellStart[c + 1] += m_cellStart[c];
+        }
+        std::vector<uint32_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+        for (size_t i = 0; i < n; i++) {
+            m_items[fill[cellOf[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    double GetRange() const { return m_range; }
+    double GetCellSize() const { return m_cellSize; }
+    uint32_t GetCellCount() const { return m_cellStart.empty() ? 0 : m_cellStart.size() - 1; }
+
+    // Calls f(index) for every node in the cells that can hold a node within
+    // range of (px, py, pz).  Callers apply the exact distance test.
+    template <typename F>
+    void ForEachCandidate(double px, double py, double pz, F f) const {
+        if (m_cellStart.empty()) {
+            return;
+        }
+        int32_t c[3];
+        Coordinates(px, py, pz, c);
+        for (int32_t k = std::max(c[2] - 1, 0); k <= std::min<int32_t>(c[2] + 1, m_dim[2] - 1); k++) {
+            for (int32_t j = std::max(c[1] - 1, 0); j <= std::min<int32_t>(c[1] + 1, m_dim[1] - 1); j++) {
+                uint32_t row = (k * m_dim[1] + j) * m_dim[0];
+                uint32_t first = row + std::max(c[0] - 1, 0);
+                uint32_t last = row + std::min<int32_t>(c[0] + 1, m_dim[0] - 1);
+                for (uint32_t idx = m_cellStart[first]; idx < m_cellStart[last + 1]; idx++) {
+                    f(m_items[idx]);
+                }
+            }
+        }
+    }
+
+  private:
+    void Coordinates(double px, double py, double pz, int32_t c[3]) const {
+        double p[3] = {px, py, pz};
+        for (int a = 0; a < 3; a++) {
+            double v = std::floor((p[a] - m_min[a]) / m_cellSize);
+            c[a] = static_cast<int32_t>(std::clamp(v, 0.0, static_cast<double>(m_dim[a] - 1)));
+        }
+    }
+
+    uint32_t CellIndex(double px, double py, double pz) const {
+        int32_t c[3];
+        Coordinates(px, py, pz, c);
+        return (c[2] * m_dim[1] + c[1]) * m_dim[0] + c[0];
+    }
+
+    double m_range = 0.0;
+    double m_cellSize = 1.0;
+    double m_min[3] = {0.0, 0.0, 0.0};
+    uint32_t m_dim[3] = {1, 1, 1};
+    std::vector<uint32_t> m_cellStart;
+    std::vector<uint32_t> m_items;
+};
+
+class MiDynamicGrid {
+  public:
+    static constexpr uint64_t ABSENT = UINT64_MAX;
+
+    void Reset(double range) {
+        m_range = range;
+        m_cellSize = std::max(range, 1e-9);
+        m_cells.clear();
+        m_cellOf.clear();
+    }
+
+    double GetRange() const { return m_range; }
+
+    // Inserts index, or moves it if it is already in the grid.
+    void Move(uint32_t index, double px, double py, double pz) {
+        if (index >= m_cellOf.size()) {
+            m_cellOf.resize(index + 1, ABSENT);
+        }
+        int64_t c[3];
+        Coordinates(px, py, pz, c);
+        uint64_t key = Key(c[0], c[1], c[2]);
+        if (m_cellOf[index] == key) {
+            return;
+        }
+        Remove(index);
+        m_cells[key].push_back(index);
+        m_cellOf[index] = key;
+    }
+
+    void Remove(uint32_t index) {
+        if (index >= m_cellOf.size() || m_cellOf[index] == ABSENT) {
+            return;
+        }
+        auto cell = m_cells.find(m_cellOf[index]);
+        std::vector<uint32_t>& items = cell->second;
+        *std::find(items.begin(), items.end(), index) = items.back();
+        items.pop_back();
+        if (items.empty()) {
+            m_cells.erase(cell);
+        }
+        m_cellOf[index] = ABSENT;
+    }
+
+    // As MiSpatialGrid::ForEachCandidate().
+    template <typename F>
+    void ForEachCandidate(double px, double py, double pz, F f) const {
+        int64_t c[3];
+        Coordinates(px, py, pz, c);
+        for (int64_t k = c[2] - 1; k <= c[2] + 1; k++) {
+            for (int64_t j = c[1] - 1; j <= c[1] + 1; j++) {
+                for (int64_t i = c[0] - 1; i <= c[0] + 1; i++) {
+                    auto cell = m_cells.find(Key(i, j, k));
+                    if (cell == m_cells.end()) {
+                        continue;
+                    }
+                    for (uint32_t item : cell->second) {
+                        f(item);
+                    }
+                }
+            }
+        }
+    }
+
+  private:
+    void Coordinates(double px, double py, double pz, int64_t c[3]) const {
+        c[0] = static_cast<int64_t>(std::floor(px / m_cellSize));
+        c[1] = static_cast<int64_t>(std::floor(py / m_cellSize));
+        c[2] = static_cast<int64_t>(std::floor(pz / m_cellSize));
+    }
+
+    // 21 bits per axis, offset so that negative cells pack too.
+    static uint64_t Key(int64_t i, int64_t j, int64_t k) {
+        const int64_t offset = int64_t(1) << 20;
+        const uint64_t mask = (uint64_t(1) << 21) - 1;
+        return (uint64_t(i + offset) & mask) | (uint64_t(j + offset) & mask) << 21 |
+               (uint64_t(k + offset) & mask) << 42;
+    }
+
+    double m_range = 0.0;
+    double m_cellSize = 1.0;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+    std::vector<uint64_t> m_cellOf;  // key of each index's cell, ABSENT if not inserted
+};
+
+#endif // MI_MAC_GRID_H
@@ -0,0 +1,165 @@
+#ifndef MI_MAC_HEADER_H
+#define MI_MAC_HEADER_H
+
+#include "mi-mac-common.h"
+#include "mi-mac-layout.h"
+
+#include "ns3/network-module.h"
+
+namespace ns3 {
+
+// On-air frame formats from the paper:
+//   REV:  [Carrier|Preamble|TargetID|PacketID|TxCoilID|EOF]  13 bytes
+//   ACK:  [Carrier|PacketID|TxCoilID|RxCoilID|EOF]            5 bytes
+//   DATA: [Carrier|PacketID|Data|EOF]                         3-19 bytes
+// MiMacHeader carries everything up to the payload, MiMacTrailer the EOF.
+// Each format is a MiLayout, so header sizes are compile-time constants and
+// (de)serialization is the layout's unrolled field sequence.
+// The top bit of a REV's TxCoilID marks a single REV sent on a cached coil,
+// so the destination answers at once instead of waiting for the other coils.
+// The top bit of a DATA frame's PacketID marks that more DATA of the same
+// burst follows under the current reservation.
+class MiMacHeader : public Header {
+  public:
+    static const uint8_t CARRIER = MiLayout::CARRIER;
+    static const uint8_t PREAMBLE = MiLayout::PREAMBLE;
+    static const uint32_t PREAMBLE_LENGTH = MiLayout::PREAMBLE_LENGTH;
+    static const uint8_t SINGLE_REV_FLAG = 0x80;
+    static const uint8_t MORE_DATA_FLAG = 0x80;
+
+    MiMacHeader() : MiMacHeader(DATA_PACKET) {}
+    explicit MiMacHeader(PacketType type) { m_fields[MiLayout::SLOT_PACKET_ID] = type; }
+
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::MiMacHeader")
+                                .SetParent<Header>()
+                                .SetGroupName("MiMac")
+                                .AddConstructor<MiMacHeader>();
+        return tid;
+    }
+    TypeId GetInstanceTypeId() const override { return GetTypeId(); }
+
+    void SetPacketType(PacketType type) { SetBits(MiLayout::SLOT_PACKET_ID, type, MORE_DATA_FLAG); }
+    PacketType GetPacketType() const {
+        return static_cast<PacketType>(m_fields[MiLayout::SLOT_PACKET_ID] & ~MORE_DATA_FLAG);
+    }
+    void SetTargetId(uint16_t id) { m_fields[MiLayout::SLOT_TARGET_ID] = id; }
+    uint16_t GetTargetId() const { return m_fields[MiLayout::SLOT_TARGET_ID]; }
+    void SetTxCoil(CoilID coil) { SetBits(MiLayout::SLOT_TX_COIL, coil, SINGLE_REV_FLAG); }
+    CoilID GetTxCoil() const { return static_cast<CoilID>(m_fields[MiLayout::SLOT_TX_COIL] & ~SINGLE_REV_FLAG); }
+    void SetRxCoil(CoilID coil) { m_fields[MiLayout::SLOT_RX_COIL] = coil; }
+    CoilID GetRxCoil() const { return static_cast<CoilID>(m_fields[MiLayout::SLOT_RX_COIL]); }
+    void SetSingleRev(bool single) { SetFlag(MiLayout::SLOT_TX_COIL, SINGLE_REV_FLAG, single); }
+    bool IsSingleRev() const {
+        return GetPacketType() == REV_PACKET && (m_fields[MiLayout::SLOT_TX_COIL] & SINGLE_REV_FLAG) != 0;
+    }
+    void SetMoreData(bool more) { SetFlag(MiLayout::SLOT_PACKET_ID, MORE_DATA_FLAG, more); }
+    bool HasMoreData() const {
+        return GetPacketType() == DATA_PACKET && (m_fields[MiLayout::SLOT_PACKET_ID] & MORE_DATA_FLAG) != 0;
+    }
+
+    // Header bytes for a frame type, excluding payload and EOF.
+    static constexpr uint32_t GetHeaderSize(PacketType type) {
+        switch (type) {
+            case REV_PACKET: return MiLayout::MiRev::SIZE;
+            case ACK_PACKET: return MiLayout::MiAck::SIZE;
+            default: return MiLayout::MiData::SIZE;
+        }
+    }
+
+    // Field structure of a whole frame, e.g. "[Carrier|PacketID|Data|EOF]".
+    static std::string Describe(PacketType type) {
+        switch (type) {
+            case REV_PACKET: return MiLayout::MiRev::Describe() + "|EOF]";
+            case ACK_PACKET: return MiLayout::MiAck::Describe() + "|EOF]";
+            default: return MiLayout::MiData::Describe() + "|Data|EOF]";
+        }
+    }
+
+    uint32_t GetSerializedSize() const override { return GetHeaderSize(GetPacketType()); }
+
+    void Serialize(Buffer::Iterator start) const override {
+        switch (GetPacketType()) {
+            case REV_PACKET: MiLayout::MiRev::Write(start, m_fields); break;
+            case ACK_PACKET: MiLayout::MiAck::Write(start, m_fields); break;
+            default: MiLayout::MiData::Write(start, m_fields); break;
+        }
+    }
+
+    // Only REV carries a preamble, so the second byte tells the format.
+    uint32_t Deserialize(Buffer::Iterator start) override {
+        Buffer::Iterator probe = start;
+        probe.Next(1);
+        uint8_t next = probe.ReadU8();
+        if (next == PREAMBLE) {
+            MiLayout::MiRev::Read(start, m_fields);
+        } else if ((next & ~MORE_DATA_FLAG) == ACK_PACKET) {
+            MiLayout::MiAck::Read(start, m_fields);
+        } else {
+            MiLayout::MiData::Read(start, m_fields);
+        }
+        return GetSerializedSize();
+    }
+
+    void Print(std::ostream& os) const override {
+        PacketType type = GetPacketType();
+        os << packetNames[type];
+        if (type == REV_PACKET) {
+            os << " target=" << GetTargetId() << " txCoil=" << coilNames[GetTxCoil()]
+               << (IsSingleRev() ? " single" : "");
+        } else if (type == ACK_PACKET) {
+            os << " txCoil=" << coilNames[GetTxCoil()] << " rxCoil=" << coilNames[GetRxCoil()];
+        } else if (HasMoreData()) {
+            os << " more";
+        }
+    }
+
+  private:
+    // Replaces the value bits of a slot, keeping its flag bits.
+    void SetBits(MiLayout::Slot slot, uint16_t value, uint16_t flags) {
+        m_fields[slot] = (m_fields[slot] & flags) | value;
+    }
+    void SetFlag(MiLayout::Slot slot, uint16_t flag, bool on) {
+        m_fields[slot] = on ? (m_fields[slot] | flag) : (m_fields[slot] & ~flag);
+    }
+
+    uint16_t m_fields[MiLayout::NUM_SLOTS] = {};
+};
+
+class MiMacTrailer : public Trailer {
+  public:
+    static const uint8_t END_OF_FRAME = 0x7E;
+
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::MiMacTrailer")
+                                .SetParent<Trailer>()
+                                .SetGroupName("MiMac")
+                                .AddConstructor<MiMacTrailer>();
+        return tid;
+    }
+    TypeId GetInstanceTypeId() const override { return GetTypeId(); }
+
+    uint32_t GetSerializedSize() const override { return 1; }
+
+    void Serialize(Buffer::Iterator end) const override {
+        end.Prev(1);
+        end.WriteU8(END_OF_FRAME);
+    }
+
+    uint32_t Deserialize(Buffer::Iterator end) override {
+        end.Prev(1);
+        end.ReadU8();
+        return 1;
+    }
+
+    void Print(std::ostream& os) const override { os << "EOF"; }
+};
+
+// Total on-air size of a frame carrying payloadSize bytes of data.
+constexpr uint32_t GetFrameSize(PacketType type, uint32_t payloadSize = 0) {
+    return MiMacHeader::GetHeaderSize(type) + payloadSize + 1;
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_HEADER_H
@@ -0,0 +1,42 @@
+#ifndef MI_MAC_HELPER_H
+#define MI_MAC_HELPER_H
+
+#include "mi-mac-net-device.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+namespace ns3 {
+
+// Creates one MiMacNetDevice per node, all attached to a shared MiMacChannel.
+// SetDeviceType() installs another MiRadioDevice, e.g. ns3::CsmaMacNetDevice.
+class MiMacHelper {
+  public:
+    void SetDeviceType(std::string type) { m_deviceFactory.SetTypeId(type); }
+    void SetDeviceAttribute(std::string name, const AttributeValue& value) { m_deviceFactory.Set(name, value); }
+    void SetChannelAttribute(std::string name, const AttributeValue& value) { m_channelFactory.Set(name, value); }
+
+    NetDeviceContainer Install(const NodeContainer& nodes) const {
+        return Install(nodes, m_channelFactory.Create<MiMacChannel>());
+    }
+
+    NetDeviceContainer Install(const NodeContainer& nodes, Ptr<MiMacChannel> channel) const {
+        NetDeviceContainer devices;
+        for (uint32_t i = 0; i < nodes.GetN(); i++) {
+            Ptr<MiRadioDevice> device = m_deviceFactory.Create<MiRadioDevice>();
+            nodes.Get(i)->AddDevice(device);
+            device->SetChannel(channel);
+            devices.Add(device);
+        }
+        return devices;
+    }
+
+  private:
+    // GetTypeId() registers the header-only types before the factories look them up.
+    ObjectFactory m_deviceFactory{MiMacNetDevice::GetTypeId().GetName()};
+    ObjectFactory m_channelFactory{MiMacChannel::GetTypeId().GetName()};
+};
+
+} // namespace ns3
+
+#endif // MI_MAC_HELPER_H
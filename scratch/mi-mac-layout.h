@@ -0,0 +1,137 @@
+#ifndef MI_MAC_LAYOUT_H
+#define MI_MAC_LAYOUT_H
+
+// Compile-time frame layouts.
+//
+// A layout lists the header fields of one frame format in on-air order.
+// Constant fields (Carrier, Preamble) carry their bytes in the type; value
+// fields name a slot of the header's field array.  Size and field offsets
+// are constexpr, and Write()/Read() expand into straight-line code that
+// works directly on the packet buffer through Buffer::Iterator, with no
+// per-frame branching and no temporaries.
+
+#include "mi-mac-common.h"
+
+#include "ns3/network-module.h"
+
+#include <string>
+
+namespace ns3 {
+
+namespace MiLayout {
+
+// Value slots shared by every frame header; a layout uses a subset.
+enum Slot : uint8_t {
+    SLOT_PACKET_ID,
+    SLOT_TARGET_ID,
+    SLOT_TX_COIL,
+    SLOT_RX_COIL,
+    SLOT_RA,
+    SLOT_TA,
+    SLOT_DURATION,
+    SLOT_SEQUENCE,
+    NUM_SLOTS
+};
+
+inline const char* const slotNames[] = {"PacketID", "TargetID", "TxCoilID", "RxCoilID", "RA", "TA", "Duration",
+                                        "Seq"};
+
+constexpr uint8_t CARRIER = 0xAA;
+constexpr uint8_t PREAMBLE = 0x55;
+constexpr uint32_t PREAMBLE_LENGTH = 7;
+
+struct Carrier {
+    static constexpr Slot SLOT = NUM_SLOTS;
+    static constexpr uint32_t SIZE = 1;
+    static const char* Name() { return "Carrier"; }
+    static void Write(Buffer::Iterator& i, const uint16_t*) { i.WriteU8(CARRIER); }
+    static void Read(Buffer::Iterator& i, uint16_t*) { i.Next(SIZE); }
+};
+
+struct Preamble {
+    static constexpr Slot SLOT = NUM_SLOTS;
+    static constexpr uint32_t SIZE = PREAMBLE_LENGTH;
+    static const char* Name() { return "Preamble"; }
+    static void Write(Buffer::Iterator& i, const uint16_t*) { i.WriteU8(PREAMBLE, SIZE); }
+    static void Read(Buffer::Iterator& i, uint16_t*) { i.Next(SIZE); }
+};
+
+template <Slot S>
+struct U8 {
+    static constexpr Slot SLOT = S;
+    static constexpr uint32_t SIZE = 1;
+    static const char* Name() { return slotNames[S]; }
+    static void Write(Buffer::Iterator& i, const uint16_t* f) { i.WriteU8(static_cast<uint8_t>(f[S])); }
+    static void Read(Buffer::Iterator& i, uint16_t* f) { f[S] = i.ReadU8(); }
+};
+
+// Network byte order, like every multi-byte field of the MAC.
+template <Slot S>
+struct U16 {
+    static constexpr Slot SLOT = S;
+    static constexpr uint32_t SIZE = 2;
+    static const char* Name() { return slotNames[S]; }
+    static void Write(Buffer::Iterator& i, const uint16_t* f) { i.WriteHtonU16(f[S]); }
+    static void Read(Buffer::Iterator& i, uint16_t* f) { f[S] = i.ReadNtohU16(); }
+};
+
+template <typename... Fields>
+struct Layout {
+    static constexpr uint32_t SIZE = (0 + ... + Fields::SIZE);
+
+    // Byte offset of a slot from the Carrier, or SIZE if the layout lacks it.
+    template <Slot S>
+    static constexpr uint32_t OffsetOf() {
+        uint32_t offset = 0;
+        bool found = false;
+        auto step = [&](uint32_t size, bool match) {
+            found = found || match;
+            offset += found ? 0 : size;
+        };
+        (step(Fields::SIZE, Fields::SLOT == S), ...);
+        return offset;
+    }
+
+    template <Slot S>
+    static constexpr bool Has() {
+        return OffsetOf<S>() < SIZE;
+    }
+
+    static void Write(Buffer::Iterator start, const uint16_t* fields) { (Fields::Write(start, fields), ...); }
+    static void Read(Buffer::Iterator start, uint16_t* fields) { (Fields::Read(start, fields), ...); }
+
+    // "[Carrier|Preamble|...", left open for the payload and EOF.
+    static std::string Describe() {
+        std::string s;
+        ((s += (s.empty() ? "[" : "|"), s += Fields::Name()), ...);
+        return s;
+    }
+};
+
+// Multi-Coil MI frames (paper), header part up to the payload.
+using MiRev = Layout<Carrier, Preamble, U16<SLOT_TARGET_ID>, U8<SLOT_PACKET_ID>, U8<SLOT_TX_COIL>>;
+using MiAck = Layout<Carrier, U8<SLOT_PACKET_ID>, U8<SLOT_TX_COIL>, U8<SLOT_RX_COIL>>;
+using MiData = Layout<Carrier, U8<SLOT_PACKET_ID>>;
+
+// CSMA/CA frames.  The preamble variants put RA and PacketID where REV has
+// TargetID and PacketID, so a MiMacHeader reads their type correctly.
+using CsmaRts = Layout<Carrier, Preamble, U16<SLOT_RA>, U8<SLOT_PACKET_ID>, U16<SLOT_DURATION>, U16<SLOT_TA>>;
+using CsmaCts = Layout<Carrier, U8<SLOT_PACKET_ID>, U16<SLOT_RA>, U16<SLOT_DURATION>>;
+using CsmaData = Layout<Carrier, U8<SLOT_PACKET_ID>, U16<SLOT_RA>, U16<SLOT_DURATION>, U16<SLOT_TA>, U8<SLOT_SEQUENCE>>;
+using CsmaPreambleData =
+    Layout<Carrier, Preamble, U16<SLOT_RA>, U8<SLOT_PACKET_ID>, U16<SLOT_DURATION>, U16<SLOT_TA>, U8<SLOT_SEQUENCE>>;
+using CsmaAck = Layout<Carrier, U8<SLOT_PACKET_ID>, U16<SLOT_RA>>;
+
+// Frame sizes with the 1-byte EOF, as given in the paper.
+static_assert(MiRev::SIZE + 1 == 13, "REV is 13 bytes");
+static_assert(MiAck::SIZE + 1 == 5, "ACK is 5 bytes");
+static_assert(MiData::SIZE + 1 == 3, "DATA adds 3 bytes to the payload");
+static_assert(MiRev::OffsetOf<SLOT_PACKET_ID>() == CsmaRts::OffsetOf<SLOT_PACKET_ID>() &&
+                  MiRev::OffsetOf<SLOT_PACKET_ID>() == CsmaPreambleData::OffsetOf<SLOT_PACKET_ID>(),
+              "frames with a preamble carry PacketID at the same offset");
+
+} // namespace MiLayout
+
+} // namespace ns3
+
+#endif // MI_MAC_LAYOUT_H
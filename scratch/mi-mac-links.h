@@ -0,0 +1,245 @@
+#ifndef MI_MAC_LINKS_H
+#define MI_MAC_LINKS_H
+
+// Cache of the 3x3 coil coupling of every link within range, for channels
+// whose nodes drift and rotate during a run.
+//
+// Coupling is reciprocal: J is symmetric in the two coil axes and even in
+// the separation, so each unordered pair of nodes is one link whose gains
+// are stored as gain[lowCoil * 3 + highCoil], low being the smaller index.
+// Every node lists its links.
+//
+// A moved node is only queued.  Update() later moves it in a hashed grid,
+// drops its links and creates links to whatever is within range now.  A
+// rotated node keeps its links and just marks them dirty.  Dirty links are
+// recomputed in one kernel batch when a transmission needs them
+// (Refresh()), so a link nobody transmits over is never evaluated and a
+// link between two unchanged nodes is never evaluated twice.  The work per
+// step follows the changed nodes times their degree, not the network size.
+
+#include "mi-mac-coupling.h"
+#include "mi-mac-grid.h"
+
+#include <cstdint>
+#include <vector>
+
+class MiLinkTable {
+  public:
+    struct Link {
+        uint32_t peer;
+        uint32_t id;
+    };
+
+    struct Counters {
+        uint64_t moves = 0;         // node moves applied by Update()
+        uint64_t rotations = 0;     // rotations that dirtied existing links
+        uint64_t linksCreated = 0;
+        uint64_t linksRemoved = 0;
+        uint64_t linksDirtied = 0;  // existing links dirtied by a rotation
+        uint64_t linksComputed = 0;
+    };
+
+    // Forgets every link; all n nodes are placed by the next Update().
+    void Reset(uint32_t n, double range) {
+        m_grid.Reset(range);
+        m_links.assign(n, {});
+        m_queued.assign(n, 1);
+        m_queue.resize(n);
+        for (uint32_t i = 0; i < n; i++) {
+            m_queue[i] = i;
+        }
+        m_touched.assign(n, 0);
+        m_touchedList.clear();
+        m_low.clear();
+        m_high.clear();
+        m_dirty.clear();
+        m_gain.clear();
+        m_free.clear();
+    }
+
+    uint32_t GetN() const { return m_links.size(); }
+    double GetRange() const { return m_grid.GetRange(); }
+    size_t GetLinkCount() const { return m_low.size() - m_free.size(); }
+    const Counters& GetCounters() const { return m_counters; }
+
+    void MarkMoved(uint32_t index) {
+        if (index < m_queued.size() && !m_queued[index]) {
+            m_queued[index] = 1;
+            m_queue.push_back(index);
+        }
+    }
+
+    void MarkRotated(uint32_t index) {
+        if (index >= m_queued.size() || m_queued[index]) {
+            return;  // its links are rebuilt dirty anyway
+        }
+        m_counters.rotations++;
+        for (const Link& link : m_links[index]) {
+            if (!m_dirty[link.id]) {
+                m_dirty[link.id] = 1;
+                m_counters.linksDirtied++;
+            }
+        }
+        Touch(index);
+    }
+
+    // Applies the queued moves: positions are the channel's columns.
+    void Update(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z);
+
+    // Recomputes the dirty links of one node.  Update() must have run.
+    void Refresh(uint32_t index, const std::vector<double>& x, const std::vector<double>& y,
+                 const std::vector<double>& z, const std::vector<MiOrientation>& orientation, MiLinkBatch& batch);
+    // Recomputes every dirty link; returns how many.
+    uint64_t RefreshAll(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+                        const std::vector<MiOrientation>& orientation, MiLinkBatch& batch);
+
+    const std::vector<Link>& GetLinks(uint32_t index) const { return m_links[index]; }
+    // Normalised coupling from txCoil of index to rxCoil of link.peer.
+    float Gain(uint32_t index, const Link& link, int txCoil, int rxCoil) const {
+        const float* gain = &m_gain[size_t(link.id) * 9];
+        return index == m_low[link.id] ? gain[txCoil * 3 + rxCoil] : gain[rxCoil * 3 + txCoil];
+    }
+
+  private:
+    void Touch(uint32_t index) {
+        if (!m_touched[index]) {
+            m_touched[index] = 1;
+            m_touchedList.push_back(index);
+        }
+    }
+    void AddLink(uint32_t a, uint32_t b);
+    void RemoveLinks(uint32_t index);
+
+    MiDynamicGrid m_grid;
+    std::vector<std::vector<Link>> m_links;  // per node
+    std::vector<uint8_t> m_queued;
+    std::vector<uint32_t> m_queue;           // moved since the last Update()
+    std::vector<uint8_t> m_touched;
+    std::vector<uint32_t> m_touchedList;     // nodes that may have dirty links
+    // Per link id.
+    std::vector<uint32_t> m_low, m_high;
+    std::vector<uint8_t> m_dirty;
+    std::vector<float> m_gain;               // 9 per link
+    std::vector<uint32_t> m_free;            // ids of removed links
+    Counters m_counters;
+};
+
+inline void MiLinkTable::AddLink(uint32_t a, uint32_t b) {
+    uint32_t id;
+    if (!m_free.empty()) {
+        id = m_free.back();
+        m_free.pop_back();
+        m_low[id] = a;
+        m_high[id] = b;
+        m_dirty[id] = 1;
+    } else {
+        id = m_low.size();
+        m_low.push_back(a);
+        m_high.push_back(b);
+        m_dirty.push_back(1);
+        m_gain.resize(m_gain.size() + 9);
+    }
+    m_links[a].push_back({b, id});
+    m_links[b].push_back({a, id});
+    Touch(a);
+    Touch(b);
+    m_counters.linksCreated++;
+}
+
+inline void MiLinkTable::RemoveLinks(uint32_t index) {
+    for (const Link& link : m_links[index]) {
+        std::vector<Link>& other = m_links[link.peer];
+        for (size_t k = 0; k < other.size(); k++) {
+            if (other[k].id == link.id) {
+                other[k] = other.back();
+                other.pop_back();
+                break;
+            }
+        }
+        m_dirty[link.id] = 0;
+        m_free.push_back(link.id);
+        m_counters.linksRemoved++;
+    }
+    m_links[index].clear();
+}
+
+inline void MiLinkTable::Update(const std::vector<double>& x, const std::vector<double>& y,
+                                const std::vector<double>& z) {
+    if (m_queue.empty()) {
+        return;
+    }
+    for (uint32_t m : m_queue) {
+        RemoveLinks(m);
+        m_grid.Move(m, x[m], y[m], z[m]);
+    }
+    // Two queued nodes within range of each other get one link, created
+    // from the lower index.
+    double rangeSq = m_grid.GetRange() * m_grid.GetRange();
+    for (uint32_t m : m_queue) {
+        m_grid.ForEachCandidate(x[m], y[m], z[m], [&](uint32_t r) {
+            if (r == m || (m_queued[r] && r < m)) {
+                return;
+            }
+            double dx = x[r] - x[m];
+            double dy = y[r] - y[m];
+            double dz = z[r] - z[m];
+            if (dx * dx + dy * dy + dz * dz <= rangeSq) {
+                AddLink(std::min(m, r), std::max(m, r));
+            }
+        });
+    }
+    m_counters.moves += m_queue.size();
+    for (uint32_t m : m_queue) {
+        m_queued[m] = 0;
+    }
+    m_queue.clear();
+}
+
+inline void MiLinkTable::Refresh(uint32_t index, const std::vector<double>& x, const std::vector<double>& y,
+                                 const std::vector<double>& z, const std::vector<MiOrientation>& orientation,
+                                 MiLinkBatch& batch) {
+    const std::vector<Link>& links = m_links[index];
+    size_t count = 0;
+    for (const Link& link : links) {
+        count += m_dirty[link.id];
+    }
+    if (count == 0) {
+        return;
+    }
+    batch.Resize(count);
+    size_t k = 0;
+    for (const Link& link : links) {
+        if (m_dirty[link.id]) {
+            uint32_t a = m_low[link.id];
+            uint32_t b = m_high[link.id];
+            batch.Set(k++, x[b] - x[a], y[b] - y[a], z[b] - z[a], orientation[a], orientation[b]);
+        }
+    }
+    MiCoupling::ComputeGains(batch);
+    k = 0;
+    for (const Link& link : links) {
+        if (m_dirty[link.id]) {
+            float* gain = &m_gain[size_t(link.id) * 9];
+            for (int pair = 0; pair < NUM_COILS * NUM_COILS; pair++) {
+                gain[pair] = batch.gain[pair][k];
+            }
+            m_dirty[link.id] = 0;
+            k++;
+        }
+    }
+    m_counters.linksComputed += count;
+}
+
+inline uint64_t MiLinkTable::RefreshAll(const std::vector<double>& x, const std::vector<double>& y,
+                                        const std::vector<double>& z, const std::vector<MiOrientation>& orientation,
+                                        MiLinkBatch& batch) {
+    uint64_t before = m_counters.linksComputed;
+    for (uint32_t index : m_touchedList) {
+        Refresh(index, x, y, z, orientation, batch);
+        m_touched[index] = 0;
+    }
+    m_touchedList.clear();
+    return m_counters.linksComputed - before;
+}
+
+#endif // MI_MAC_LINKS_H
@@ -0,0 +1,242 @@
+// Analytical screening of MI MAC configurations with the semi-Markov model
+// of mi-mac-markov.h.  Every combination of density, reading interval and
+// DATA size is solved for state occupancy, energy per delivered bit and the
+// expected access and handshake delays, with contention estimated from the
+// density.  Solving takes microseconds, so thousands of points can be
+// screened before any of them is simulated.
+//
+// --validate also simulates every point on the lattice scenario and prints
+// the model next to the simulation, twice: with the estimated contention,
+// and with the collision, busy and cache-hit probabilities measured in that
+// simulation, which separates errors of the contention estimate from errors
+// of the chain itself.
+//
+//   ./ns3 run "scratch/mi-mac-markov --density=0.1,0.25,0.5,1 --interval=1,5,10,30,60 --payload=1,4,8,16"
+//   ./ns3 run "scratch/mi-mac-markov --density=0.25,1 --interval=5,30 --validate --nodes=1000"
+
+#include "mi-mac-markov.h"
+#include "mi-mac-scenario.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <fstream>
+
+using namespace ns3;
+
+struct MarkovPoint {
+    double density;
+    double interval;
+    uint32_t payload;
+};
+
+const char* const CSV_HEADER =
+    "density,interval_s,payload_B,collision_p,busy_p,idle,receive,sensing,acquire,transmit,avg_current_uA,"
+    "delivery,energy_per_bit_uJ,access_delay_us,handshake_delay_us";
+
+// Simulated counterparts of the model outputs and the contention it saw.
+struct MeasuredPoint {
+    MiMarkovResult result;
+    double collisionProbability = 0.0;
+    double busyProbability = 0.0;
+    double cacheHitProbability = 0.0;
+};
+
+MeasuredPoint Simulate(const MarkovPoint& point, const MiScenarioConfig& base) {
+    MiScenarioConfig config = base;
+    config.spacing = 1.0 / std::sqrt(point.density);
+    config.meanInterval = point.interval;
+    config.payloadSize = point.payload;
+    MiMacStats stats;
+    MiScenarioResult run = RunMiScenario(config, nullptr, &stats);
+    const MiMacCounters& c = run.counters;
+
+    MeasuredPoint measured;
+    double total = 0.0;
+    for (int s = 0; s < NUM_STATES; s++) {
+        for (uint32_t i = 0; i < stats.GetN(); i++) {
+            measured.result.occupancy[s] += stats.GetStateTime(i, static_cast<NodeState>(s));
+        }
+        total += measured.result.occupancy[s];
+    }
+    for (int s = 0; s < NUM_STATES; s++) {
+        measured.result.occupancy[s] /= total;
+        measured.result.averageCurrent +=
+            measured.result.occupancy[s] * run.energy.CurrentFor(static_cast<NodeState>(s));
+    }
+    double deliveredBits = c.dataReceived * point.payload * 8.0;
+    measured.result.deliveryProbability = run.DeliveryRatio();
+    measured.result.energyPerBit = deliveredBits > 0.0 ? run.energy.totalEnergy / deliveredBits : INFINITY;
+    measured.result.accessDelay = run.MeanAccessDelay() * 1e6;
+    measured.result.handshakeDelay = stats.GetRevToAck().Mean() * 1e6;
+
+    // A round fails if its REV or its ACK is lost.
+    double rounds = c.revSweeps + c.revSingles;
+    double failed = rounds > 0.0 ? c.ackTimeouts / rounds : 0.0;
+    measured.collisionProbability = 1.0 - std::sqrt(1.0 - failed);
+    double acks = c.framesSent - 3.0 * c.revSweeps - c.revSingles - c.dataSent;
+    double clear = rounds + acks + c.bursts;
+    measured.busyProbability = c.backoffs + clear > 0.0 ? c.backoffs / (c.backoffs + clear) : 0.0;
+    double firstRounds = rounds - c.retries;
+    measured.cacheHitProbability = firstRounds > 0.0 ? c.revSingles / firstRounds : 0.0;
+    return measured;
+}
+
+void PrintRow(const std::string& label, const MiMarkovResult& r) {
+    std::cout << "    " << std::left << std::setw(18) << label << std::right << std::setprecision(3);
+    for (int s = 0; s < NUM_STATES; s++) {
+        std::cout << std::setw(9) << 100.0 * r.occupancy[s];
+    }
+    std::cout << std::setprecision(2) << std::setw(10) << r.averageCurrent << std::setprecision(3) << std::setw(9)
+              << r.deliveryProbability << std::setprecision(2) << std::setw(11) << r.energyPerBit
+              << std::setprecision(0) << std::setw(11) << r.accessDelay << std::setw(11) << r.handshakeDelay
+              << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    std::string densityList = "0.1,0.25,0.5,1";
+    std::string intervalList = "1,5,10,30,60";
+    std::string payloadList = "1,4,10,16";
+    double range = 4.0;
+    uint32_t maxRetries = 3;
+    bool linkCache = true;
+    bool validate = false;
+    uint32_t nodes = 1000;
+    double simTime = 300.0;
+    uint32_t seed = 1;
+    std::string csvFile;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("density", "Comma-separated node densities (nodes/m²)", densityList);
+    cmd.AddValue("interval", "Comma-separated mean reading intervals per node (s)", intervalList);
+    cmd.AddValue("payload", "Comma-separated DATA payload sizes (1-16 bytes)", payloadList);
+    cmd.AddValue("range", "Coupling evaluation radius (m), the neighbourhood of the contention estimate", range);
+    cmd.AddValue("maxRetries", "REV rounds attempted after the first", maxRetries);
+    cmd.AddValue("linkCache", "Model the coil-pair cache (single REV rounds)", linkCache);
+    cmd.AddValue("validate", "Also simulate every point and compare", validate);
+    cmd.AddValue("nodes", "Lattice size of the validation runs", nodes);
+    cmd.AddValue("simTime", "Simulated time of the validation runs (s)", simTime);
+    cmd.AddValue("seed", "RNG seed of the validation runs", seed);
+    cmd.AddValue("csv", "Also write the model results to this CSV file", csvFile);
+    cmd.Parse(argc, argv);
+
+    std::vector<MarkovPoint> points;
+    for (double density : MiParseList<double>(densityList)) {
+        for (double interval : MiParseList<double>(intervalList)) {
+            for (uint32_t payload : MiParseList<uint32_t>(payloadList)) {
+                NS_ABORT_MSG_IF(density <= 0.0 || interval <= 0.0, "density and interval must be positive");
+                NS_ABORT_MSG_IF(payload < 1 || payload > MiMacNetDevice::MAX_PAYLOAD,
+                                "payload must be 1-" << MiMacNetDevice::MAX_PAYLOAD << " bytes");
+                points.push_back(MarkovPoint{density, interval, payload});
+            }
+        }
+    }
+    NS_ABORT_MSG_IF(points.empty(), "no configurations");
+
+    auto configFor = [&](const MarkovPoint& point) {
+        MiMarkovConfig config;
+        config.maxRetries = maxRetries;
+        config.linkCache = linkCache;
+        config.payloadSize = point.payload;
+        config.readingRate = 1.0 / point.interval;
+        config.EstimateContention(point.density, range);
+        return config;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<MiMarkovResult> results;
+    results.reserve(points.size());
+    for (const MarkovPoint& point : points) {
+        results.push_back(MiMarkovModel(configFor(point)).Solve());
+    }
+    double solveSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\n" << std::string(70, '=') << std::endl;
+    std::cout << "   MI MAC MARKOV MODEL" << std::endl;
+    std::cout << std::string(70, '=') << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n  Configurations:          " << points.size() << std::endl;
+    std::cout << "  Chain phases:            " << MiMarkovModel(configFor(points[0])).GetPhaseCount() << std::endl;
+    std::cout << "  Solve time:              " << solveSec * 1e3 << " ms (" << std::setprecision(1)
+              << solveSec * 1e6 / points.size() << " µs per configuration)" << std::endl;
+
+    std::cout << "\n" << std::setw(7) << "Dens" << std::setw(8) << "Int(s)" << std::setw(5) << "B" << std::setw(9)
+              << "p_coll" << std::setw(9) << "p_busy" << std::setw(9) << "Idle %" << std::setw(10) << "I (µA)"
+              << std::setw(10) << "Delivery" << std::setw(13) << "µJ/bit" << std::setw(13) << "Access µs"
+              << std::setw(15) << "Handshake µs" << std::endl;
+    std::ofstream csv;
+    if (!csvFile.empty()) {
+        csv.open(csvFile);
+        csv << CSV_HEADER << "\n" << std::setprecision(8);
+    }
+    for (size_t k = 0; k < points.size(); k++) {
+        const MarkovPoint& point = points[k];
+        const MiMarkovResult& r = results[k];
+        MiMarkovConfig config = configFor(point);
+        std::cout << std::setprecision(2) << std::setw(7) << point.density << std::setprecision(1) << std::setw(8)
+                  << point.interval << std::setw(5) << point.payload << std::setprecision(4) << std::setw(9)
+                  << config.collisionProbability << std::setw(9) << config.busyProbability << std::setprecision(2)
+                  << std::setw(9) << 100.0 * r.occupancy[STATE_IDLE] << std::setw(10) << r.averageCurrent
+                  << std::setprecision(4) << std::setw(10) << r.deliveryProbability << std::setprecision(3)
+                  << std::setw(13) << r.energyPerBit << std::setprecision(0) << std::setw(13) << r.accessDelay
+                  << std::setw(15) << r.handshakeDelay << std::endl;
+        if (csv.is_open()) {
+            csv << point.density << "," << point.interval << "," << point.payload << ","
+                << config.collisionProbability << "," << config.busyProbability;
+            for (int s = 0; s < NUM_STATES; s++) {
+                csv << "," << r.occupancy[s];
+            }
+            csv << "," << r.averageCurrent << "," << r.deliveryProbability << "," << r.energyPerBit << ","
+                << r.accessDelay << "," << r.handshakeDelay << "\n";
+        }
+    }
+    if (csv.is_open()) {
+        std::cout << "\n  Model results written to " << csvFile << std::endl;
+    }
+
+    if (validate) {
+        MiScenarioConfig base;
+        base.nodes = nodes;
+        base.range = range;
+        base.simTime = simTime;
+        std::cout << "\n  Validation against the simulator (" << nodes << " nodes, " << std::setprecision(0) << simTime
+                  << " s per point)" << std::endl;
+        double worstEnergy = 0.0;
+        double worstAccess = 0.0;
+        for (size_t k = 0; k < points.size(); k++) {
+            const MarkovPoint& point = points[k];
+            RngSeedManager::SetSeed(seed);
+            RngSeedManager::SetRun(1);
+            auto simStart = std::chrono::steady_clock::now();
+            MeasuredPoint measured = Simulate(point, base);
+            double simSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - simStart).count();
+
+            MiMarkovConfig config = configFor(point);
+            config.collisionProbability = measured.collisionProbability;
+            config.busyProbability = measured.busyProbability;
+            config.cacheHitProbability = measured.cacheHitProbability;
+            MiMarkovResult calibrated = MiMarkovModel(config).Solve();
+
+            std::cout << "\n  density " << std::setprecision(2) << point.density << ", interval "
+                      << std::setprecision(1) << point.interval << " s, payload " << point.payload << " B"
+                      << std::setprecision(4) << "  (measured p_coll " << measured.collisionProbability
+                      << ", p_busy " << measured.busyProbability << ", cache hit " << measured.cacheHitProbability
+                      << "; simulated in " << std::setprecision(2) << simSec << " s)" << std::endl;
+            std::cout << "    " << std::left << std::setw(18) << "" << std::right;
+            for (const char* name : {"Idle %", "Recv %", "Sense %", "Acq %", "Tx %"}) {
+                std::cout << std::setw(9) << name;
+            }
+            std::cout << std::setw(10) << "I (µA)" << std::setw(9) << "Deliv" << std::setw(11) << "µJ/bit"
+                      << std::setw(11) << "Access µs" << std::setw(11) << "Hshake µs" << std::endl;
+            PrintRow("model (estimate)", results[k]);
+            PrintRow("model (measured)", calibrated);
+            PrintRow("simulation", measured.result);
+            worstEnergy = std::max(worstEnergy, std::fabs(calibrated.energyPerBit / measured.result.energyPerBit - 1.0));
+            worstAccess = std::max(worstAccess, std::fabs(calibrated.accessDelay / measured.result.accessDelay - 1.0));
+        }
+        std::cout << "\n  Largest model (measured) error: " << std::setprecision(1) << 100.0 * worstEnergy
+                  << "% energy per bit, " << 100.0 * worstAccess << "% access delay" << std::endl;
+    }
+    std::cout << std::endl;
+    return 0;
+}
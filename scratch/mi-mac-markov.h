@@ -0,0 +1,329 @@
+#ifndef MI_MAC_MARKOV_H
+#define MI_MAC_MARKOV_H
+
+// Analytical model of one MiMacNetDevice as a semi-Markov chain.
+//
+// The chain follows the device's phases rather than its five NodeStates,
+// because the time spent in RECEIVE waiting for an ACK is a different
+// random variable from RECEIVE collecting REV copies.  Each phase has its
+// NodeState, and each transition a probability and a mean duration:
+//
+//   source:       IDLE -> ACQUIRE -> SENSE_REV(r) -> SEND_REV(r) -> WAIT_ACK(r)
+//                     -> SENSE_DATA -> SEND_DATA -> IDLE
+//                 WAIT_ACK(r) times out to SENSE_REV(r+1), or to IDLE (drop)
+//                 after MaxRetries retries; retry rounds always sweep.
+//   destination:  IDLE -> COLLECT_REV -> SENSE_ACK -> SEND_ACK -> WAIT_DATA -> IDLE
+//
+// Readings arrive at the traffic rate and REV rounds addressed to the node
+// at the incoming rate; IDLE ends at whichever comes first.  Every frame
+// (REV round, ACK, DATA) is lost independently with the collision
+// probability, and every sensing window is found busy independently with
+// the busy probability, which costs a uniform backoff and a new window.
+// Steady-state occupancy is the stationary distribution of the embedded
+// chain weighted by mean holding times; delays are first-passage times
+// conditioned on success.  Aggregation and queueing behind a busy device
+// are not modelled, so the model is meant for AggregationCount 1 at loads
+// where the device is mostly idle.
+
+#include "mi-mac-common.h"
+#include "mi-mac-header.h"
+
+#include <cmath>
+#include <vector>
+
+namespace ns3 {
+
+// Defaults are those of MiMacNetDevice, MiEnergyModel and the lattice scenario.
+struct MiMarkovConfig {
+    double bitRate = 10000.0;       // bit/s
+    double dataAcquireTime = 10e-3; // s
+    double sensingTime = 1e-3;      // s
+    double backoffSlot = 1e-3;      // s
+    uint32_t maxBackoffSlots = 8;
+    double ackTimeout = 40e-3;      // s
+    double dataTimeout = 60e-3;     // s
+    uint32_t maxRetries = 3;
+    bool linkCache = true;
+    double linkCacheLifetime = 30.0;  // s
+    uint32_t payloadSize = 10;        // bytes
+    double supplyVoltage = 3.0;       // V
+    EnergyMetrics currents;
+
+    double readingRate = 1.0 / 30.0;  // readings per second sent by the node
+    double incomingRate = -1.0;       // readings per second addressed to the node; < 0: readingRate
+    double collisionProbability = 0.0;  // per frame
+    double busyProbability = 0.0;       // per sensing window
+    double cacheHitProbability = -1.0;  // first rounds sent as a single REV; < 0: from the cache lifetime
+
+    // First-order contention for nodes at the given density (nodes/m²) that
+    // hear each other within range (m): a sensing window is busy if one of
+    // the neighbours' frames or sensing windows overlaps it, and a frame is
+    // lost if a neighbour started within a sensing window of it, too late
+    // to be heard.
+    void EstimateContention(double density, double range);
+};
+
+struct MiMarkovResult {
+    double occupancy[NUM_STATES] = {};  // fraction of time
+    double averageCurrent = 0.0;        // µA
+    double deliveryProbability = 0.0;   // reading -> DATA received
+    double dropProbability = 0.0;       // reading dropped after MaxRetries
+    double expectedRounds = 0.0;        // REV rounds per reading
+    double deliveredBitRate = 0.0;      // payload bit/s per node
+    double energyPerBit = 0.0;          // µJ per delivered payload bit
+    double accessDelay = 0.0;           // µs, data ready to DATA sent, over sent readings
+    double handshakeDelay = 0.0;        // µs, first REV to ACK received, over answered handshakes
+};
+
+class MiMarkovModel {
+  public:
+    explicit MiMarkovModel(const MiMarkovConfig& config);
+
+    MiMarkovResult Solve() const;
+    uint32_t GetPhaseCount() const { return m_state.size(); }
+
+  private:
+    struct Transition {
+        uint32_t to;
+        double probability;
+        double duration;  // s, mean
+    };
+
+    uint32_t AddPhase(NodeState state);
+    void Connect(uint32_t from, uint32_t to, double probability, double duration);
+    // Stationary distribution of the embedded chain.
+    std::vector<double> Stationary() const;
+    // Probability of entering target before IDLE from every phase, and the
+    // mean time it takes over the paths that do.
+    void FirstPassage(uint32_t target, std::vector<double>& success, std::vector<double>& time) const;
+
+    MiMarkovConfig m_config;
+    std::vector<NodeState> m_state;
+    std::vector<std::vector<Transition>> m_transitions;
+    uint32_t m_idle = 0;
+    uint32_t m_senseRev0 = 0;
+    uint32_t m_sendRev0 = 0;
+    uint32_t m_senseData = 0;
+    uint32_t m_sendData = 0;
+    double m_roundsPerReading = 0.0;
+    double m_sendProbability = 0.0;  // reading -> DATA sent
+};
+
+// Solves A x = b in place by Gaussian elimination with partial pivoting.
+inline std::vector<double> MiSolveLinear(std::vector<std::vector<double>> a, std::vector<double> b) {
+    size_t n = b.size();
+    for (size_t col = 0; col < n; col++) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; row++) {
+            if (std::fabs(a[row][col]) > std::fabs(a[pivot][col])) {
+                pivot = row;
+            }
+        }
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+        for (size_t row = col + 1; row < n; row++) {
+            double factor = a[row][col] / a[col][col];
+            for (size_t k = col; k < n; k++) {
+                a[row][k] -= factor * a[col][k];
+            }
+            b[row] -= factor * b[col];
+        }
+    }
+    std::vector<double> x(n);
+    for (size_t row = n; row-- > 0;) {
+        double sum = b[row];
+        for (size_t k = row + 1; k < n; k++) {
+            sum -= a[row][k] * x[k];
+        }
+        x[row] = sum / a[row][row];
+    }
+    return x;
+}
+
+inline void MiMarkovConfig::EstimateContention(double density, double range) {
+    double neighbours = std::max(0.0, density * M_PI * range * range - 1.0);
+    double rev = GetFrameSize(REV_PACKET) * 8.0 / bitRate;
+    double ack = GetFrameSize(ACK_PACKET) * 8.0 / bitRate;
+    double data = GetFrameSize(DATA_PACKET, payloadSize) * 8.0 / bitRate;
+    double hit = linkCache ? linkCacheLifetime / (linkCacheLifetime + 1.0 / readingRate) : 0.0;
+    double revFrames = hit + 3.0 * (1.0 - hit);
+    // Per reading, each neighbour transmits these frames after as many sensing windows.
+    double frames = revFrames + 2.0;
+    double airtime = revFrames * rev + ack + data;
+    busyProbability = 1.0 - std::exp(-neighbours * readingRate * (airtime + 3.0 * sensingTime));
+    collisionProbability = 1.0 - std::exp(-neighbours * readingRate * frames * sensingTime);
+}
+
+inline MiMarkovModel::MiMarkovModel(const MiMarkovConfig& config) : m_config(config) {
+    const MiMarkovConfig& c = m_config;
+    double rev = GetFrameSize(REV_PACKET) * 8.0 / c.bitRate;
+    double ack = GetFrameSize(ACK_PACKET) * 8.0 / c.bitRate;
+    double data = GetFrameSize(DATA_PACKET, c.payloadSize) * 8.0 / c.bitRate;
+    double p = c.collisionProbability;
+    double b = std::min(c.busyProbability, 0.999);
+    double hit = c.cacheHitProbability >= 0.0
+                     ? c.cacheHitProbability
+                     : (c.linkCache ? c.linkCacheLifetime / (c.linkCacheLifetime + 1.0 / c.readingRate) : 0.0);
+    double backoff = 0.5 * (1.0 + c.maxBackoffSlots) * c.backoffSlot;
+    // Sensing windows until one is clear, with a backoff after each busy one.
+    double sense = c.sensingTime / (1.0 - b) + b / (1.0 - b) * backoff;
+    // A round is answered if its REV and the ACK both get through.
+    double answered = (1.0 - p) * (1.0 - p);
+
+    m_idle = AddPhase(STATE_IDLE);
+    uint32_t acquire = AddPhase(STATE_DATA_ACQUIRE);
+    uint32_t rounds = c.maxRetries + 1;
+    std::vector<uint32_t> senseRev(rounds), sendRev(rounds), waitAck(rounds);
+    for (uint32_t r = 0; r < rounds; r++) {
+        senseRev[r] = AddPhase(STATE_CHANNEL_SENSING);
+        sendRev[r] = AddPhase(STATE_TRANSMIT);
+        waitAck[r] = AddPhase(STATE_RECEIVE);
+    }
+    m_senseRev0 = senseRev[0];
+    m_sendRev0 = sendRev[0];
+    m_senseData = AddPhase(STATE_CHANNEL_SENSING);
+    m_sendData = AddPhase(STATE_TRANSMIT);
+    uint32_t collectRev = AddPhase(STATE_RECEIVE);
+    uint32_t senseAck = AddPhase(STATE_CHANNEL_SENSING);
+    uint32_t sendAck = AddPhase(STATE_TRANSMIT);
+    uint32_t waitData = AddPhase(STATE_RECEIVE);
+
+    // Rounds and outcome per reading, to size the incoming REV rate.
+    double reach = 1.0;
+    m_roundsPerReading = 0.0;
+    for (uint32_t r = 0; r < rounds; r++) {
+        m_roundsPerReading += reach;
+        reach *= 1.0 - answered;
+    }
+    m_sendProbability = 1.0 - reach;
+    double singles = hit;  // only first rounds use the cache
+    double sweepShare = 1.0 - singles / m_roundsPerReading;
+
+    // The destination turns around with a sensed ACK; the source then senses and sends DATA.
+    double ackTurnaround = sense + ack;
+    double dataTurnaround = sense + data;
+
+    double incoming = (c.incomingRate < 0.0 ? c.readingRate : c.incomingRate) * m_roundsPerReading * (1.0 - p);
+    double leave = c.readingRate + incoming;
+    Connect(m_idle, acquire, c.readingRate / leave, 1.0 / leave);
+    Connect(m_idle, collectRev, incoming / leave, 1.0 / leave);
+    Connect(acquire, senseRev[0], 1.0, c.dataAcquireTime);
+
+    for (uint32_t r = 0; r < rounds; r++) {
+        double revTime = r == 0 ? hit * rev + (1.0 - hit) * 3.0 * rev : 3.0 * rev;
+        // AckTimeout() backs off before sensing again.
+        Connect(senseRev[r], sendRev[r], 1.0, r == 0 ? sense : backoff + sense);
+        Connect(sendRev[r], waitAck[r], 1.0, revTime);
+        Connect(waitAck[r], m_senseData, answered, ackTurnaround);
+        Connect(waitAck[r], r + 1 < rounds ? senseRev[r + 1] : m_idle, 1.0 - answered, c.ackTimeout);
+    }
+    Connect(m_senseData, m_sendData, 1.0, sense);
+    Connect(m_sendData, m_idle, 1.0, data);
+
+    // REV copies after the first arrive back to back; a single REV ends collection at once.
+    Connect(collectRev, senseAck, 1.0, sweepShare * 2.0 * rev);
+    Connect(senseAck, sendAck, 1.0, sense);
+    Connect(sendAck, waitData, 1.0, ack);
+    Connect(waitData, m_idle, answered, dataTurnaround);
+    Connect(waitData, m_idle, 1.0 - answered, c.dataTimeout);
+}
+
+inline uint32_t MiMarkovModel::AddPhase(NodeState state) {
+    m_state.push_back(state);
+    m_transitions.emplace_back();
+    return m_state.size() - 1;
+}
+
+inline void MiMarkovModel::Connect(uint32_t from, uint32_t to, double probability, double duration) {
+    m_transitions[from].push_back(Transition{to, probability, duration});
+}
+
+inline std::vector<double> MiMarkovModel::Stationary() const {
+    // nu (P - I) = 0 with the last equation replaced by sum(nu) = 1, transposed.
+    size_t n = m_state.size();
+    std::vector<std::vector<double>> a(n, std::vector<double>(n, 0.0));
+    std::vector<double> rhs(n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+        a[i][i] -= 1.0;
+        for (const Transition& t : m_transitions[i]) {
+            a[t.to][i] += t.probability;
+        }
+    }
+    std::fill(a[n - 1].begin(), a[n - 1].end(), 1.0);
+    rhs[n - 1] = 1.0;
+    return MiSolveLinear(a, rhs);
+}
+
+inline void MiMarkovModel::FirstPassage(uint32_t target, std::vector<double>& success,
+                                        std::vector<double>& time) const {
+    // success_i = sum_j P_ij s_j, and w_i = sum_j P_ij (d_ij s_j + w_j) with
+    // s = 1, w = 0 at the target and s = w = 0 at IDLE; time = w / s.
+    size_t n = m_state.size();
+    std::vector<std::vector<double>> a(n, std::vector<double>(n, 0.0));
+    std::vector<double> rhs(n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+        a[i][i] = 1.0;
+        if (i == target || i == m_idle) {
+            rhs[i] = i == target ? 1.0 : 0.0;
+            continue;
+        }
+        for (const Transition& t : m_transitions[i]) {
+            a[i][t.to] -= t.probability;
+        }
+    }
+    success = MiSolveLinear(a, rhs);
+    for (size_t i = 0; i < n; i++) {
+        rhs[i] = 0.0;
+        if (i == target || i == m_idle) {
+            continue;
+        }
+        for (const Transition& t : m_transitions[i]) {
+            rhs[i] += t.probability * t.duration * success[t.to];
+        }
+    }
+    std::vector<double> weighted = MiSolveLinear(a, rhs);
+    time.assign(n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+        time[i] = success[i] > 0.0 ? weighted[i] / success[i] : 0.0;
+    }
+}
+
+inline MiMarkovResult MiMarkovModel::Solve() const {
+    const MiMarkovConfig& c = m_config;
+    MiMarkovResult result;
+    std::vector<double> visits = Stationary();
+    double total = 0.0;
+    for (size_t i = 0; i < m_state.size(); i++) {
+        double holding = 0.0;
+        for (const Transition& t : m_transitions[i]) {
+            holding += t.probability * t.duration;
+        }
+        result.occupancy[m_state[i]] += visits[i] * holding;
+        total += visits[i] * holding;
+    }
+    for (int s = 0; s < NUM_STATES; s++) {
+        result.occupancy[s] /= total;
+        result.averageCurrent += result.occupancy[s] * c.currents.CurrentFor(static_cast<NodeState>(s));
+    }
+
+    result.expectedRounds = m_roundsPerReading;
+    result.dropProbability = 1.0 - m_sendProbability;
+    result.deliveryProbability = m_sendProbability * (1.0 - c.collisionProbability);
+    result.deliveredBitRate = c.readingRate * result.deliveryProbability * c.payloadSize * 8.0;
+    // µA x V = µW, over bit/s gives µJ per bit.
+    result.energyPerBit = result.deliveredBitRate > 0.0
+                              ? result.averageCurrent * c.supplyVoltage / result.deliveredBitRate
+                              : INFINITY;
+
+    std::vector<double> success, time;
+    FirstPassage(m_sendData, success, time);
+    double data = GetFrameSize(DATA_PACKET, c.payloadSize) * 8.0 / c.bitRate;
+    result.accessDelay = (time[m_senseRev0] + data) * 1e6;
+    FirstPassage(m_senseData, success, time);
+    result.handshakeDelay = time[m_sendRev0] * 1e6;
+    return result;
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_MARKOV_H
@@ -0,0 +1,170 @@
+// Drifting and rotating nodes (see mi-mac-mobility.h) over a channel that
+// caches link coupling (see mi-mac-links.h).
+//
+// The first table times the incremental update alone: a lattice of each
+// size has every link computed once, then a small share of the nodes
+// moves and rotates per step and only the links touching them are
+// recomputed.  The time per step follows the number of changed nodes, so
+// the time per change stays flat as the network grows, while recomputing
+// every link costs the whole network each step.
+//
+// The second table runs the MAC over the same drift, with and without the
+// cache, next to a static network: delivery, how often the MAC's cached
+// coil pair went stale (cache fallbacks), coupling links computed and
+// wall-clock time.
+//
+//   ./ns3 run "scratch/mi-mac-mobility --nodes=1000,10000,100000 --fraction=0.001,0.01,0.1"
+//   ./ns3 run "scratch/mi-mac-mobility --simNodes=2000 --simTime=300 --speed=0.02 --turnRate=0.5"
+
+#include "mi-mac-mobility.h"
+#include "mi-mac-scenario.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <chrono>
+
+using namespace ns3;
+
+struct UpdateCost {
+    uint64_t links = 0;          // links in range after placement
+    double fullMs = 0.0;         // computing all of them
+    double changesPerStep = 0.0;
+    double linksPerStep = 0.0;   // recomputed
+    double usPerStep = 0.0;
+};
+
+UpdateCost MeasureUpdates(uint32_t n, double fraction, uint32_t steps, const MiScenarioConfig& base,
+                          const MiDriftConfig& drift) {
+    MiScenarioConfig config = base;
+    config.nodes = n;
+    NodeContainer nodes;
+    nodes.Create(n);
+    MiMacHelper mac;
+    mac.SetChannelAttribute("Range", DoubleValue(config.range));
+    mac.SetChannelAttribute("CouplingCache", BooleanValue(true));
+    NetDeviceContainer devices = mac.Install(nodes);
+    // Placement only; the readings MiScenarioLattice() schedules never run.
+    MiScenarioLattice(config, nodes, devices);
+    Ptr<MiMacChannel> channel = DynamicCast<MiMacChannel>(devices.Get(0)->GetChannel());
+
+    UpdateCost cost;
+    auto start = std::chrono::steady_clock::now();
+    channel->RefreshCoupling();
+    cost.fullMs = 1e3 * std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cost.links = channel->GetLinkTable().GetLinkCount();
+
+    MiDriftConfig stepConfig = drift;
+    stepConfig.moveFraction = fraction;
+    stepConfig.turnFraction = fraction;
+    MiDriftMobility mobility(stepConfig);
+    mobility.Install(devices);
+    uint64_t computed = 0;
+    double seconds = 0.0;
+    for (uint32_t k = 0; k < steps; k++) {
+        mobility.Step();
+        start = std::chrono::steady_clock::now();
+        computed += channel->RefreshCoupling();
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    cost.changesPerStep = static_cast<double>(mobility.GetMoves() + mobility.GetTurns()) / steps;
+    cost.linksPerStep = static_cast<double>(computed) / steps;
+    cost.usPerStep = 1e6 * seconds / steps;
+    Simulator::Destroy();
+    return cost;
+}
+
+int main(int argc, char *argv[]) {
+    std::string nodeList = "1000,10000,100000";
+    std::string fractionList = "0.001,0.01,0.1";
+    uint32_t steps = 200;
+    MiScenarioConfig config;
+    MiDriftConfig drift;
+    uint32_t simNodes = 1000;
+    double simFraction = 0.05;
+    uint32_t seed = 1;
+
+    config.simTime = 300.0;
+    config.meanInterval = 10.0;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nodes", "Comma-separated network sizes for the update cost table", nodeList);
+    cmd.AddValue("fraction", "Comma-separated shares of nodes moved (and rotated) per step", fractionList);
+    cmd.AddValue("steps", "Mobility steps timed per point", steps);
+    cmd.AddValue("spacing", "Lattice spacing between nodes (m)", config.spacing);
+    cmd.AddValue("range", "Coupling evaluation radius (m)", config.range);
+    cmd.AddValue("speed", "Speed of a drifting node (m/s)", drift.speed);
+    cmd.AddValue("turnRate", "Largest turn rate of a rotating node (rad/s)", drift.turnRate);
+    cmd.AddValue("step", "Mobility step (s)", drift.step);
+    cmd.AddValue("simNodes", "Nodes in the MAC runs (0 to skip them)", simNodes);
+    cmd.AddValue("simFraction", "Share of nodes moved (and rotated) per step in the MAC runs", simFraction);
+    cmd.AddValue("simTime", "Simulated time of the MAC runs (s)", config.simTime);
+    cmd.AddValue("interval", "Mean time between sensor readings per node in the MAC runs (s)", config.meanInterval);
+    cmd.AddValue("seed", "RNG seed", seed);
+    cmd.Parse(argc, argv);
+
+    RngSeedManager::SetSeed(seed);
+    std::vector<uint32_t> sizes = MiParseList<uint32_t>(nodeList);
+    std::vector<double> fractions = MiParseList<double>(fractionList);
+
+    std::cout << "\n" << std::string(70, '=') << std::endl;
+    std::cout << "   MI MAC MOBILITY AND INCREMENTAL COUPLING" << std::endl;
+    std::cout << std::string(70, '=') << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n  Drift:                   " << drift.speed << " m/s, turns up to " << drift.turnRate
+              << " rad/s, step " << drift.step << " s" << std::endl;
+
+    if (!sizes.empty() && !fractions.empty() && steps > 0) {
+        std::cout << "\n  Coupling update per step (" << steps << " steps; a share of nodes moves, another rotates)"
+                  << std::endl;
+        std::cout << std::setw(9) << "Nodes" << std::setw(10) << "Share" << std::setw(11) << "Links"
+                  << std::setw(11) << "Full ms" << std::setw(12) << "Changes" << std::setw(12) << "Recomputed"
+                  << std::setw(11) << "us/step" << std::setw(12) << "us/change" << std::setw(10) << "vs full"
+                  << std::endl;
+        for (uint32_t n : sizes) {
+            for (double fraction : fractions) {
+                UpdateCost cost = MeasureUpdates(n, fraction, steps, config, drift);
+                std::cout << std::setw(9) << n << std::setw(9) << 100.0 * fraction << "%" << std::setw(11)
+                          << cost.links << std::setw(11) << cost.fullMs << std::setw(12) << cost.changesPerStep
+                          << std::setw(12) << cost.linksPerStep << std::setw(11) << cost.usPerStep << std::setw(12)
+                          << (cost.changesPerStep > 0.0 ? cost.usPerStep / cost.changesPerStep : 0.0)
+                          << std::setw(9) << (cost.usPerStep > 0.0 ? 1e3 * cost.fullMs / cost.usPerStep : 0.0)
+                          << "x" << std::endl;
+            }
+        }
+    }
+
+    if (simNodes > 0) {
+        config.nodes = simNodes;
+        drift.moveFraction = simFraction;
+        drift.turnFraction = simFraction;
+        config.drift = drift;
+        std::cout << "\n  MAC runs (" << simNodes << " nodes, " << config.simTime << " s, "
+                  << 100.0 * simFraction << "% of nodes moved and rotated per step)" << std::endl;
+        std::cout << std::setw(24) << "" << std::setw(11) << "Delivery" << std::setw(11) << "Fallbacks"
+                  << std::setw(12) << "Collisions" << std::setw(10) << "Changes" << std::setw(14) << "Links comp."
+                  << std::setw(10) << "Wall s" << std::endl;
+        struct Variant {
+            const char* name;
+            bool mobility;
+            bool cache;
+        };
+        for (const Variant& v : {Variant{"Static", false, false}, Variant{"Drift, no cache", true, false},
+                                 Variant{"Drift, coupling cache", true, true}}) {
+            config.mobility = v.mobility;
+            config.couplingCache = v.cache;
+            MiScenarioResult result = RunMiScenario(config);
+            std::cout << "  " << std::left << std::setw(22) << v.name << std::right << std::setw(11)
+                      << result.DeliveryRatio() << std::setw(11) << result.counters.cacheFallbacks << std::setw(12)
+                      << result.counters.collisions << std::setw(10) << result.moves + result.turns;
+            if (v.cache) {
+                std::cout << std::setw(14) << result.coupling.linksComputed;
+            } else {
+                std::cout << std::setw(14) << "per frame";
+            }
+            std::cout << std::setw(10) << result.wallSec << std::endl;
+        }
+    }
+    std::cout << std::endl;
+    return 0;
+}
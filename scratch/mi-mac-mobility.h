@@ -0,0 +1,131 @@
+#ifndef MI_MAC_MOBILITY_H
+#define MI_MAC_MOBILITY_H
+
+// Drift and rotation of MI nodes, e.g. moored sensors swinging in a
+// current.  Every step a random subset of the nodes moves and another
+// rotates.  A moving node is displaced along a random direction, plus the
+// common current.  A rotating node turns by up to TurnRate x Step about a
+// random axis, which changes which coil pair couples best.  Geometry goes
+// through MiRadioDevice::SetPosition/SetOrientation, so a channel with
+// CouplingCache recomputes only the links touching the nodes a step
+// changed.
+
+#include "mi-mac-net-device.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <cmath>
+#include <vector>
+
+namespace ns3 {
+
+struct MiDriftConfig {
+    double step = 1.0;            // s between steps
+    double moveFraction = 0.01;   // expected share of nodes displaced per step
+    double turnFraction = 0.01;   // expected share of nodes rotated per step
+    double speed = 0.05;          // m/s of a displaced node
+    double turnRate = 0.2;        // rad/s, largest turn of a rotated node
+    Vector current = Vector(0.0, 0.0, 0.0);  // m/s added to every displacement
+};
+
+// Rotation by angle about the unit axis (ax, ay, az), applied in the world frame.
+inline MiOrientation MiRotate(const MiOrientation& o, double ax, double ay, double az, double angle) {
+    double c = std::cos(angle);
+    double s = std::sin(angle);
+    double t = 1.0 - c;
+    double r[9] = {t * ax * ax + c,      t * ax * ay - s * az, t * ax * az + s * ay,
+                   t * ax * ay + s * az, t * ay * ay + c,      t * ay * az - s * ax,
+                   t * ax * az - s * ay, t * ay * az + s * ax, t * az * az + c};
+    MiOrientation rotated;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            rotated.m[i * 3 + j] = r[i * 3] * o.m[j] + r[i * 3 + 1] * o.m[3 + j] + r[i * 3 + 2] * o.m[6 + j];
+        }
+    }
+    return rotated;
+}
+
+class MiDriftMobility {
+  public:
+    explicit MiDriftMobility(const MiDriftConfig& config = MiDriftConfig())
+        : m_config(config) {}
+
+    void Install(const NetDeviceContainer& devices) {
+        m_random = CreateObject<UniformRandomVariable>();
+        m_devices.resize(devices.GetN());
+        for (uint32_t i = 0; i < devices.GetN(); i++) {
+            m_devices[i] = DynamicCast<MiRadioDevice>(devices.Get(i));
+        }
+    }
+    // Steps every config.step seconds of simulated time from now.
+    void Start() { m_event = Simulator::Schedule(Seconds(m_config.step), &MiDriftMobility::ScheduledStep, this); }
+    void Stop() { m_event.Cancel(); }
+
+    // One step, without the simulator.
+    void Step();
+
+    uint64_t GetSteps() const { return m_steps; }
+    uint64_t GetMoves() const { return m_moves; }
+    uint64_t GetTurns() const { return m_turns; }
+
+  private:
+    void ScheduledStep() {
+        Step();
+        Start();
+    }
+    // fraction of the nodes, rounded up or down at random to keep the mean.
+    uint32_t Count(double fraction) {
+        double expected = fraction * m_devices.size();
+        uint32_t count = static_cast<uint32_t>(expected);
+        return count + (m_random->GetValue() < expected - count ? 1 : 0);
+    }
+    // Uniform random unit vector.
+    void Direction(double& x, double& y, double& z) {
+        z = m_random->GetValue(-1.0, 1.0);
+        double phi = m_random->GetValue(0.0, 2 * M_PI);
+        double r = std::sqrt(1.0 - z * z);
+        x = r * std::cos(phi);
+        y = r * std::sin(phi);
+    }
+
+    MiDriftConfig m_config;
+    Ptr<UniformRandomVariable> m_random;
+    std::vector<Ptr<MiRadioDevice>> m_devices;
+    EventId m_event;
+    uint64_t m_steps = 0;
+    uint64_t m_moves = 0;
+    uint64_t m_turns = 0;
+};
+
+inline void MiDriftMobility::Step() {
+    uint32_t n = m_devices.size();
+    if (n == 0) {
+        return;
+    }
+    m_steps++;
+    double ux, uy, uz;
+    uint32_t moves = Count(m_config.moveFraction);
+    for (uint32_t k = 0; k < moves; k++) {
+        Ptr<MiRadioDevice> device = m_devices[m_random->GetInteger(0, n - 1)];
+        Direction(ux, uy, uz);
+        double d = m_config.speed * m_config.step;
+        Vector p = device->GetPosition();
+        device->SetPosition(Vector(p.x + d * ux + m_config.current.x * m_config.step,
+                                   p.y + d * uy + m_config.current.y * m_config.step,
+                                   p.z + d * uz + m_config.current.z * m_config.step));
+    }
+    uint32_t turns = Count(m_config.turnFraction);
+    for (uint32_t k = 0; k < turns; k++) {
+        Ptr<MiRadioDevice> device = m_devices[m_random->GetInteger(0, n - 1)];
+        Direction(ux, uy, uz);
+        double angle = m_random->GetValue(-1.0, 1.0) * m_config.turnRate * m_config.step;
+        device->SetOrientation(MiRotate(device->GetOrientation(), ux, uy, uz, angle));
+    }
+    m_moves += moves;
+    m_turns += turns;
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_MOBILITY_H
@@ -0,0 +1,1395 @@
+#ifndef MI_MAC_NET_DEVICE_H
+#define MI_MAC_NET_DEVICE_H
+
+// Event-driven Multi-Coil MI MAC.
+//
+// MiMacChannel is the shared MI medium, MiRadioDevice the interface every
+// MAC attached to it implements, and MiMacNetDevice runs the five-state
+// machine of the paper (Fig. 4) for one node.  Every state is
+// entered from a scheduled event or a frame reception, so a single
+// Simulator::Run() can drive thousands of independent handshakes.
+//
+// Handshake, source side:
+//   IDLE -> DATA_ACQUIRE -> CHANNEL_SENSING -> TRANSMIT (REV on X, Y, Z)
+//        -> RECEIVE (wait ACK) -> CHANNEL_SENSING -> TRANSMIT (DATA) -> IDLE
+// Destination side:
+//   IDLE -> RECEIVE (collect REVs) -> CHANNEL_SENSING -> TRANSMIT (ACK)
+//        -> RECEIVE (wait DATA) -> IDLE
+//
+// Sources cache the coil pair and ACK RSSI of each destination after a full
+// three-coil REV sweep.  While the entry is younger than LinkCacheLifetime
+// the next round sends a single REV on the cached coil; a missing ACK or an
+// ACK more than LinkCacheHysteresis dB below the sweep RSSI drops the entry,
+// so the retry or next transfer sweeps all coils again.
+//
+// The three coils are cross-coupled receive branches, not orthogonal
+// channels.  A frame arrives on each receive coil with its own coupled
+// power, and a receiver decodes it on the coil with the best SINR against
+// everything else coupled onto that coil, so two transfers on weakly
+// cross-coupled coil pairs can overlap without loss.
+// Carrier sensing before ACK and DATA listens only on the coil the frame
+// will use.
+//
+// Readings are acquired one by one (DATA_ACQUIRE) as they arrive and then
+// buffered until a flush policy fires: AggregationCount readings for the
+// destination, AggregationBytes of payload, or the oldest reading waiting
+// AggregationDeadline.  The buffered readings then go out as a burst of
+// DATA frames after one REV/ACK handshake.  The defaults send every reading
+// on its own.
+//
+// With WakeInterval set, an idle MiMacNetDevice keeps its receiver off and
+// wakes on a fixed per-node schedule to listen for ListenTime.  Each wake-up
+// is a single event; nothing polls while the node sleeps.  Every REV round
+// starts with a carrier of PreambleExtension (one WakeInterval by default),
+// so each receiver wakes at least once during it; a receiver that hears it
+// stays up and decodes the REVs behind it.  A node with a reading or a handshake wakes at
+// once.  Sleep is a mode inside IDLE, reported through the RadioSleep trace,
+// so the five states of the paper stay as they are.
+//
+// By default every transmission evaluates the 3x3 coupling to each node in
+// range.  With CouplingCache the channel keeps those gains per link (see
+// mi-mac-links.h) and recomputes only links whose ends moved or rotated
+// since, which suits long runs over slowly drifting nodes.
+
+#include "mi-mac-common.h"
+#include "mi-mac-coupling.h"
+#include "mi-mac-grid.h"
+#include "mi-mac-header.h"
+#include "mi-mac-links.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <deque>
+#include <unordered_map>
+
+namespace ns3 {
+
+class MiRadioDevice;
+
+// Power a frame arrives with on each coil of one receiver (mW).
+struct MiCoilPower {
+    double mw[NUM_COILS];
+};
+
+class MiMacChannel : public Channel {
+  public:
+    static TypeId GetTypeId();
+
+    MiMacChannel();
+
+    // Returns the index the device's geometry is stored under.
+    uint32_t Add(Ptr<MiRadioDevice> device);
+    std::size_t GetNDevices() const override;
+    Ptr<NetDevice> GetDevice(std::size_t i) const override;
+
+    void SetPosition(uint32_t index, const Vector& position);
+    Vector GetPosition(uint32_t index) const;
+    void SetOrientation(uint32_t index, const MiOrientation& orientation);
+    const MiOrientation& GetOrientation(uint32_t index) const { return m_orientation[index]; }
+
+    // RSSI (dBm) of all nine coil pairs of the link from -> to.
+    void GetPairRssi(uint32_t from, uint32_t to, double rssi[NUM_COILS * NUM_COILS]);
+
+    // Starts a frame on the medium.  Every device that couples above the
+    // interference floor on one of its coils sees the signal for duration.
+    void Transmit(Ptr<MiRadioDevice> sender, Ptr<const Packet> frame, CoilID txCoil, Time duration);
+
+    // With CouplingCache: applies pending moves and recomputes every dirty
+    // link now instead of at the next transmission.  Returns the links
+    // computed.
+    uint64_t RefreshCoupling();
+    const MiLinkTable& GetLinkTable() const { return m_links; }
+
+    double GetRange() const { return m_range; }
+    double GetSensitivity() const { return m_sensitivity; }
+    double GetNoiseFloor() const { return m_noiseFloor; }
+    double GetSinrThreshold() const { return m_sinrThreshold; }
+    Time GetDelay() const { return m_delay; }
+
+    // Receiver, sender, frame, transmit coil, received power, airtime.
+    typedef Callback<void, Ptr<MiRadioDevice>, Ptr<MiRadioDevice>, Ptr<const Packet>, CoilID, MiCoilPower, Time>
+        RemoteRxCallback;
+    // In a distributed run every process holds every device, but only those
+    // whose node has systemId are simulated here.  Frames for the others go
+    // to callback instead of being scheduled locally.
+    void SetRemoteRxCallback(uint32_t systemId, RemoteRxCallback callback);
+
+  private:
+    // Brings the link table up to date with the node count, range and moves.
+    void UpdateLinks();
+    // Hands the frame to one receiver if it couples above floorMw on some coil.
+    void Deliver(const Ptr<MiRadioDevice>& sender, uint32_t receiver, Ptr<const Packet> frame, CoilID txCoil,
+                 const MiCoilPower& power, double floorMw, Time duration);
+
+    std::vector<Ptr<MiRadioDevice>> m_devices;
+    std::vector<bool> m_remote;  // indexed like m_devices, set by SetRemoteRxCallback()
+    RemoteRxCallback m_remoteRx;
+    // Node geometry, indexed like m_devices.
+    std::vector<double> m_posX, m_posY, m_posZ;
+    std::vector<MiOrientation> m_orientation;
+    // Cell list over the positions above, rebuilt lazily after they change.
+    MiSpatialGrid m_grid;
+    bool m_gridDirty;
+    // Scratch space reused by every Transmit().
+    std::vector<uint32_t> m_candidates;
+    MiLinkBatch m_batch;
+
+    double m_range;  // m, candidate search radius
+    double m_txPower;  // dBm
+    double m_referenceLoss;  // dB, coaxial pair at 1 m
+    double m_sensitivity;  // dBm
+    double m_interferenceFloor;  // dBm
+    double m_noiseFloor;  // dBm
+    double m_sinrThreshold;  // dB
+    Time m_delay;
+    // Per-link coupling kept between transmissions, if enabled.
+    bool m_couplingCache;
+    MiLinkTable m_links;
+};
+
+// Per-device counters, summed by the scratch programs for reporting.
+struct MiMacCounters {
+    uint64_t stateTransitions = 0;
+    uint64_t framesSent = 0;
+    uint64_t dataEnqueued = 0;
+    uint64_t dataSent = 0;
+    uint64_t dataReceived = 0;
+    uint64_t dataDropped = 0;
+    uint64_t ackTimeouts = 0;
+    uint64_t dataTimeouts = 0;    // destination gave up waiting for DATA
+    uint64_t retries = 0;         // handshakes restarted after a timeout
+    uint64_t collisions = 0;
+    uint64_t backoffs = 0;
+    uint64_t revSweeps = 0;       // REV rounds on all three coils
+    uint64_t revSingles = 0;      // REV rounds on a cached coil only
+    uint64_t cacheFallbacks = 0;  // cached pairs dropped after a miss or RSSI drop
+    uint64_t bursts = 0;          // handshakes that carried DATA
+    uint64_t wakeups = 0;         // scheduled receiver wake-ups (duty cycling)
+    uint64_t preambles = 0;       // REV rounds led by a wake-up preamble
+    double accessDelay = 0.0;     // s, summed over dataSent: transfer ready to DATA done (sent or ACKed)
+
+    MiMacCounters& operator+=(const MiMacCounters& o) {
+        stateTransitions += o.stateTransitions;
+        framesSent += o.framesSent;
+        dataEnqueued += o.dataEnqueued;
+        dataSent += o.dataSent;
+        dataReceived += o.dataReceived;
+        dataDropped += o.dataDropped;
+        ackTimeouts += o.ackTimeouts;
+        dataTimeouts += o.dataTimeouts;
+        retries += o.retries;
+        collisions += o.collisions;
+        backoffs += o.backoffs;
+        revSweeps += o.revSweeps;
+        revSingles += o.revSingles;
+        cacheFallbacks += o.cacheFallbacks;
+        bursts += o.bursts;
+        wakeups += o.wakeups;
+        preambles += o.preambles;
+        accessDelay += o.accessDelay;
+        return *this;
+    }
+};
+
+// A MAC on the MI medium.  The channel stores the geometry of every attached
+// device and delivers each frame that couples above the interference floor
+// through StartRx(), in the receiver's context.  The device tracks the power
+// on each of its coils, locks onto a frame that is above the sensitivity with
+// enough SINR on some coil, and hands it to HandleFrame() if no later signal
+// pushed the SINR on that coil below the threshold.
+class MiRadioDevice : public NetDevice {
+  public:
+    static TypeId GetTypeId();
+
+    void SetChannel(Ptr<MiMacChannel> channel);
+    uint32_t GetChannelIndex() const { return m_channelIndex; }
+    // Geometry lives in the channel; the device must be attached first.
+    void SetPosition(const Vector& position) { m_channel->SetPosition(m_channelIndex, position); }
+    Vector GetPosition() const { return m_channel->GetPosition(m_channelIndex); }
+    void SetOrientation(const MiOrientation& orientation) { m_channel->SetOrientation(m_channelIndex, orientation); }
+    const MiOrientation& GetOrientation() const { return m_channel->GetOrientation(m_channelIndex); }
+
+    virtual Mac16Address GetMacAddress() const = 0;
+    const MiMacCounters& GetCounters() const { return m_counters; }
+
+    void StartRx(Ptr<MiRadioDevice> sender, Ptr<const Packet> frame, CoilID txCoil, const MiCoilPower& power,
+                 Time duration);
+
+    // Total power heard on a coil reaches the sensitivity.
+    bool IsCoilBusy(CoilID coil) const;
+    bool IsMediumBusy() const;
+    // Receiver switched off by duty cycling.
+    bool IsAsleep() const { return m_asleep; }
+
+    // NetDevice
+    Ptr<Channel> GetChannel() const override { return m_channel; }
+    bool IsLinkUp() const override { return m_channel != nullptr; }
+
+  protected:
+    void DoDispose() override;
+
+    // A frame decoded on rxCoil at rssi (dBm).
+    virtual void HandleFrame(Ptr<MiRadioDevice> sender, Ptr<const Packet> frame, CoilID txCoil, CoilID rxCoil,
+                             double rssi) = 0;
+    // Called after every signal start and end, once the coil powers are updated.
+    virtual void NotifyRxStart() {}
+    virtual void NotifyRxEnd() {}
+
+    // Puts a frame on the medium on one coil.  Half duplex: whatever was
+    // being decoded is lost.  The caller clears m_transmitting after airtime.
+    void TransmitFrame(Ptr<const Packet> frame, CoilID coil, Time airtime);
+    // Puts an unmodulated carrier (an empty frame nobody decodes) on the
+    // medium, e.g. a wake-up preamble.  Not counted as a frame.
+    void TransmitCarrier(CoilID coil, Time duration);
+    // A sleeping receiver still adds up the power it is exposed to but
+    // decodes nothing; going to sleep abandons the frame being decoded.
+    void SetAsleep(bool asleep);
+    // Start of the last signal at or above the sensitivity on a coil.
+    Time GetLastBusyStart(CoilID coil) const { return m_lastBusyStart[coil]; }
+
+    Ptr<MiMacChannel> m_channel;
+    uint32_t m_channelIndex = 0;
+    bool m_transmitting = false;
+    MiMacCounters m_counters;
+
+  private:
+    void EndRx(uint64_t rxId, MiCoilPower power, Ptr<MiRadioDevice> sender, Ptr<const Packet> frame,
+               CoilID txCoil);
+    double GetSinr(int coil, double signalMw) const;  // dB
+
+    bool m_asleep = false;
+    uint32_t m_rxSignals = 0;
+    uint64_t m_rxSerial = 0;
+    double m_coilMw[NUM_COILS] = {};  // total power of the signals in flight
+    Time m_lastBusyStart[NUM_COILS] = {Time::Min(), Time::Min(), Time::Min()};
+    uint64_t m_lockedRx = 0;
+    int m_lockedCoil = COIL_X;
+    double m_lockedMw = 0.0;
+    bool m_lockedCorrupt = false;
+};
+
+class MiMacNetDevice : public MiRadioDevice {
+  public:
+    static const uint16_t MAX_PAYLOAD = 16;
+
+    static TypeId GetTypeId();
+
+    typedef void (*StateTracedCallback)(uint32_t nodeId, NodeState from, NodeState to, const char* reason);
+    typedef void (*FrameTracedCallback)(uint32_t nodeId, Ptr<const Packet> frame, CoilID coil);
+    typedef void (*RxTracedCallback)(uint32_t nodeId, Ptr<const Packet> frame, CoilID txCoil, CoilID rxCoil,
+                                     double rssi);
+    typedef void (*DropTracedCallback)(uint32_t nodeId, Ptr<const Packet> packet);
+    typedef void (*CoilSelectionTracedCallback)(uint32_t nodeId, const double* rssi, const CoilID* rxCoil,
+                                                CoilID best);
+    typedef void (*SleepTracedCallback)(uint32_t nodeId, bool asleep);
+
+    MiMacNetDevice();
+
+    Mac16Address GetMacAddress() const override { return m_address; }
+    // Forgets every cached coil pair, forcing full REV sweeps.
+    void FlushLinkCache() { m_linkCache.clear(); }
+    NodeState GetState() const { return m_state; }
+
+    // Frame airtime at the configured bit rate.
+    Time GetAirtime(uint32_t bytes) const { return Seconds(bytes * 8.0 / m_bitRate); }
+    bool IsDutyCycled() const { return !m_wakeInterval.IsZero(); }
+    // Carrier sent ahead of the first REV of a round.
+    Time GetRevPreamble() const {
+        return !m_preambleExtension.IsZero() ? m_preambleExtension : m_wakeInterval;
+    }
+
+    // NetDevice
+    void SetIfIndex(const uint32_t index) override { m_ifIndex = index; }
+    uint32_t GetIfIndex() const override { return m_ifIndex; }
+    void SetAddress(Address address) override { m_address = Mac16Address::ConvertFrom(address); }
+    Address GetAddress() const override { return m_address; }
+    bool SetMtu(const uint16_t mtu) override;
+    uint16_t GetMtu() const override { return m_mtu; }
+    void AddLinkChangeCallback(Callback<void> callback) override {}
+    bool IsBroadcast() const override { return false; }
+    Address GetBroadcast() const override { return Mac16Address::GetBroadcast(); }
+    bool IsMulticast() const override { return false; }
+    Address GetMulticast(Ipv4Address multicastGroup) const override { return Mac16Address::GetBroadcast(); }
+    Address GetMulticast(Ipv6Address addr) const override { return Mac16Address::GetBroadcast(); }
+    bool IsBridge() const override { return false; }
+    bool IsPointToPoint() const override { return false; }
+    bool Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) override;
+    bool SendFrom(Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber) override {
+        return Send(packet, dest, protocolNumber);
+    }
+    Ptr<Node> GetNode() const override { return m_node; }
+    void SetNode(Ptr<Node> node) override { m_node = node; }
+    bool NeedsArp() const override { return false; }
+    void SetReceiveCallback(ReceiveCallback cb) override { m_rxCallback = cb; }
+    void SetPromiscReceiveCallback(PromiscReceiveCallback cb) override { m_promiscRxCallback = cb; }
+    bool SupportsSendFrom() const override { return false; }
+
+  protected:
+    void DoInitialize() override;
+    void DoDispose() override;
+    void HandleFrame(Ptr<MiRadioDevice> sender, Ptr<const Packet> frame, CoilID txCoil, CoilID rxCoil,
+                     double rssi) override;
+    void NotifyRxStart() override;
+    void NotifyRxEnd() override;
+
+  private:
+    // What the device is doing inside its current NodeState.
+    enum MacPhase {
+        PHASE_NONE,
+        PHASE_ACQUIRE,
+        PHASE_SENSING,
+        PHASE_SEND_REV,
+        PHASE_WAIT_ACK,
+        PHASE_SEND_DATA,
+        PHASE_COLLECT_REV,
+        PHASE_SEND_ACK,
+        PHASE_WAIT_DATA
+    };
+
+    struct TxItem {
+        Ptr<Packet> packet;
+        Mac16Address dest;
+        Time enqueued;
+        bool acquired;
+    };
+
+    // Coil pair chosen by the last full REV sweep towards a destination.
+    struct LinkCacheEntry {
+        CoilID txCoil;
+        CoilID rxCoil;
+        double rssi;  // dBm, ACK received after the sweep
+        Time sweepTime;
+    };
+
+    void SetState(NodeState to, const char* reason);
+    void ServiceQueue();
+    bool ReadyToFlush() const;
+    void FlushDeadline();
+    void EndDataAcquire();
+    void StartSensing(MacPhase next, const char* reason);
+    void RestartSensing();
+    void EndSensing();
+    bool SensedBusy(CoilID coil) const;
+    void SendFrame(Ptr<Packet> frame, CoilID coil);
+    void StartRevRound();
+    void SendRev(CoilID coil);
+    void SendData();
+    void UpdateLinkCache(double ackRssi);
+    void EndTx();
+    void FinishRevCollection();
+    void AckTimeout();
+    void DataTimeout();
+    void ReturnToIdle(const char* reason);
+    // Duty cycling: receiver off until the next scheduled wake-up.
+    void Sleep();
+    void Wake();
+    void WakeRadio();
+
+    Ptr<Node> m_node;
+    Mac16Address m_address;
+    uint32_t m_ifIndex;
+    uint16_t m_mtu;
+    ReceiveCallback m_rxCallback;
+    PromiscReceiveCallback m_promiscRxCallback;
+    Ptr<UniformRandomVariable> m_random;
+
+    double m_bitRate;  // bit/s
+    Time m_dataAcquireTime;
+    Time m_sensingTime;
+    Time m_backoffSlot;
+    uint32_t m_maxBackoffSlots;
+    Time m_ackTimeout;
+    Time m_dataTimeout;
+    Time m_revGuard;
+    uint32_t m_maxRetries;
+    uint32_t m_queueLimit;
+    bool m_linkCacheEnabled;
+    Time m_linkCacheLifetime;
+    double m_linkCacheHysteresis;  // dB
+    uint32_t m_aggregationCount;
+    uint32_t m_aggregationBytes;
+    Time m_aggregationDeadline;
+    Time m_wakeInterval;
+    Time m_listenTime;
+    Time m_preambleExtension;
+    Time m_wakePhase;  // offset of this node's wake-ups within the interval
+
+    NodeState m_state;
+    MacPhase m_phase;
+    MacPhase m_nextPhase;
+    EventId m_stateEvent;
+    EventId m_timeoutEvent;
+    EventId m_flushEvent;
+    EventId m_wakeEvent;
+    EventId m_sleepEvent;
+    std::deque<TxItem> m_queue;
+    uint32_t m_retries;
+    uint32_t m_burstRemaining;  // DATA frames of the current burst not yet sent
+    Time m_accessStart;         // when the current burst was ready to go
+
+    // Handshake partner and coil pair for the transfer in progress.  The
+    // REV arrays are indexed by the source's transmit coil.
+    Mac16Address m_peer;
+    CoilID m_linkTxCoil;
+    CoilID m_linkRxCoil;
+    double m_revRssi[NUM_COILS];
+    CoilID m_revRxCoil[NUM_COILS];
+    CoilID m_revCoil;
+    bool m_singleRev;
+    std::unordered_map<uint16_t, LinkCacheEntry> m_linkCache;
+
+    Time m_senseStart;
+
+    TracedCallback<uint32_t, NodeState, NodeState, const char*> m_stateTrace;
+    TracedCallback<uint32_t, Ptr<const Packet>, CoilID> m_macTxTrace;
+    TracedCallback<uint32_t, Ptr<const Packet>, CoilID, CoilID, double> m_macRxTrace;
+    TracedCallback<uint32_t, Ptr<const Packet>> m_macTxDropTrace;
+    TracedCallback<uint32_t, const double*, const CoilID*, CoilID> m_coilSelectionTrace;
+    TracedCallback<uint32_t, bool> m_sleepTrace;
+};
+
+// ---------------------------------------------------------------------------
+// MiMacChannel
+// ---------------------------------------------------------------------------
+
+inline TypeId MiMacChannel::GetTypeId() {
+    static TypeId tid = TypeId("ns3::MiMacChannel")
+                            .SetParent<Channel>()
+                            .SetGroupName("MiMac")
+                            .AddConstructor<MiMacChannel>()
+                            .AddAttribute("Range",
+                                          "Distance (m) beyond which coupling is not evaluated.",
+                                          DoubleValue(4.0),
+                                          MakeDoubleAccessor(&MiMacChannel::m_range),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddAttribute("TxPower",
+                                          "Transmit power of each coil (dBm).",
+                                          DoubleValue(0.0),
+                                          MakeDoubleAccessor(&MiMacChannel::m_txPower),
+                                          MakeDoubleChecker<double>())
+                            .AddAttribute("ReferenceLoss",
+                                          "Path loss of a coaxial coil pair 1 m apart (dB).",
+                                          DoubleValue(45.0),
+                                          MakeDoubleAccessor(&MiMacChannel::m_referenceLoss),
+                                          MakeDoubleChecker<double>())
+                            .AddAttribute("Sensitivity",
+                                          "Weakest RSSI (dBm) that is detected and decoded.",
+                                          DoubleValue(-80.0),
+                                          MakeDoubleAccessor(&MiMacChannel::m_sensitivity),
+                                          MakeDoubleChecker<double>())
+                            .AddAttribute("InterferenceFloor",
+                                          "Weakest coil power (dBm) still delivered as interference.",
+                                          DoubleValue(-90.0),
+                                          MakeDoubleAccessor(&MiMacChannel::m_interferenceFloor),
+                                          MakeDoubleChecker<double>())
+                            .AddAttribute("NoiseFloor",
+                                          "Receiver noise power on each coil (dBm).",
+                                          DoubleValue(-110.0),
+                                          MakeDoubleAccessor(&MiMacChannel::m_noiseFloor),
+                                          MakeDoubleChecker<double>())
+                            .AddAttribute("SinrThreshold",
+                                          "SINR (dB) a frame needs on its receive coil for its whole airtime.",
+                                          DoubleValue(10.0),
+                                          MakeDoubleAccessor(&MiMacChannel::m_sinrThreshold),
+                                          MakeDoubleChecker<double>())
+                            .AddAttribute("Delay",
+                                          "Propagation delay of the near-field MI link.",
+                                          TimeValue(NanoSeconds(0)),
+                                          MakeTimeAccessor(&MiMacChannel::m_delay),
+                                          MakeTimeChecker())
+                            .AddAttribute("CouplingCache",
+                                          "Keep each link's coil coupling between transmissions and recompute "
+                                          "it only after either end moved or rotated.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&MiMacChannel::m_couplingCache),
+                                          MakeBooleanChecker());
+    return tid;
+}
+
+inline MiMacChannel::MiMacChannel()
+    : m_gridDirty(true),
+      m_range(4.0),
+      m_txPower(0.0),
+      m_referenceLoss(45.0),
+      m_sensitivity(-80.0),
+      m_interferenceFloor(-90.0),
+      m_noiseFloor(-110.0),
+      m_sinrThreshold(10.0),
+      m_delay(NanoSeconds(0)),
+      m_couplingCache(false) {}
+
+inline uint32_t MiMacChannel::Add(Ptr<MiRadioDevice> device) {
+    m_devices.push_back(device);
+    m_posX.push_back(0.0);
+    m_posY.push_back(0.0);
+    m_posZ.push_back(0.0);
+    m_orientation.push_back(MiOrientation());
+    m_gridDirty = true;
+    return m_devices.size() - 1;
+}
+
+inline std::size_t MiMacChannel::GetNDevices() const {
+    return m_devices.size();
+}
+
+inline Ptr<NetDevice> MiMacChannel::GetDevice(std::size_t i) const {
+    return m_devices[i];
+}
+
+inline void MiMacChannel::SetPosition(uint32_t index, const Vector& position) {
+    m_posX[index] = position.x;
+    m_posY[index] = position.y;
+    m_posZ[index] = position.z;
+    m_gridDirty = true;
+    if (m_couplingCache) {
+        m_links.MarkMoved(index);
+    }
+}
+
+inline void MiMacChannel::SetOrientation(uint32_t index, const MiOrientation& orientation) {
+    m_orientation[index] = orientation;
+    if (m_couplingCache) {
+        m_links.MarkRotated(index);
+    }
+}
+
+inline Vector MiMacChannel::GetPosition(uint32_t index) const {
+    return Vector(m_posX[index], m_posY[index], m_posZ[index]);
+}
+
+inline void MiMacChannel::GetPairRssi(uint32_t from, uint32_t to, double rssi[NUM_COILS * NUM_COILS]) {
+    m_batch.Resize(1);
+    m_batch.Set(0, m_posX[to] - m_posX[from], m_posY[to] - m_posY[from], m_posZ[to] - m_posZ[from],
+                m_orientation[from], m_orientation[to]);
+    MiCoupling::ComputeGains(m_batch);
+    for (int pair = 0; pair < NUM_COILS * NUM_COILS; pair++) {
+        rssi[pair] = MiCoupling::ToRssi(m_batch.gain[pair][0], m_txPower, m_referenceLoss);
+    }
+}
+
+inline void MiMacChannel::SetRemoteRxCallback(uint32_t systemId, RemoteRxCallback callback) {
+    m_remoteRx = callback;
+    m_remote.resize(m_devices.size());
+    for (size_t i = 0; i < m_devices.size(); i++) {
+        m_remote[i] = m_devices[i]->GetNode()->GetSystemId() != systemId;
+    }
+}
+
+inline void MiMacChannel::UpdateLinks() {
+    if (m_links.GetN() != m_devices.size() || m_links.GetRange() != m_range) {
+        m_links.Reset(m_devices.size(), m_range);
+    }
+    m_links.Update(m_posX, m_posY, m_posZ);
+}
+
+inline uint64_t MiMacChannel::RefreshCoupling() {
+    if (!m_couplingCache) {
+        return 0;
+    }
+    UpdateLinks();
+    return m_links.RefreshAll(m_posX, m_posY, m_posZ, m_orientation, m_batch);
+}
+
+inline void MiMacChannel::Transmit(Ptr<MiRadioDevice> sender, Ptr<const Packet> frame, CoilID txCoil,
+                                   Time duration) {
+    uint32_t s = sender->GetChannelIndex();
+    double coaxialMw = MiCoupling::DbmToMw(m_txPower - m_referenceLoss);
+    double floorMw = MiCoupling::DbmToMw(m_interferenceFloor);
+    MiCoilPower power;
+
+    if (m_couplingCache) {
+        UpdateLinks();
+        m_links.Refresh(s, m_posX, m_posY, m_posZ, m_orientation, m_batch);
+        for (const MiLinkTable::Link& link : m_links.GetLinks(s)) {
+            for (int c = 0; c < NUM_COILS; c++) {
+                power.mw[c] = coaxialMw * m_links.Gain(s, link, txCoil, c);
+            }
+            Deliver(sender, link.peer, frame, txCoil, power, floorMw, duration);
+        }
+        return;
+    }
+
+    if (m_gridDirty || m_grid.GetRange() != m_range) {
+        m_grid.Build(m_posX, m_posY, m_posZ, m_range);
+        m_gridDirty = false;
+    }
+    double rangeSq = m_range * m_range;
+    m_candidates.clear();
+    m_grid.ForEachCandidate(m_posX[s], m_posY[s], m_posZ[s], [&](uint32_t i) {
+        double dx = m_posX[i] - m_posX[s];
+        double dy = m_posY[i] - m_posY[s];
+        double dz = m_posZ[i] - m_posZ[s];
+        if (i != s && dx * dx + dy * dy + dz * dz <= rangeSq) {
+            m_candidates.push_back(i);
+        }
+    });
+
+    m_batch.Resize(m_candidates.size());
+    for (size_t k = 0; k < m_candidates.size(); k++) {
+        uint32_t r = m_candidates[k];
+        m_batch.Set(k, m_posX[r] - m_posX[s], m_posY[r] - m_posY[s], m_posZ[r] - m_posZ[s], m_orientation[s],
+                    m_orientation[r]);
+    }
+    MiCoupling::ComputeGains(m_batch);
+
+    for (size_t k = 0; k < m_candidates.size(); k++) {
+        for (int c = 0; c < NUM_COILS; c++) {
+            power.mw[c] = coaxialMw * m_batch.Gain(k, txCoil, c);
+        }
+        Deliver(sender, m_candidates[k], frame, txCoil, power, floorMw, duration);
+    }
+}
+
+inline void MiMacChannel::Deliver(const Ptr<MiRadioDevice>& sender, uint32_t receiver, Ptr<const Packet> frame,
+                                  CoilID txCoil, const MiCoilPower& power, double floorMw, Time duration) {
+    double strongest = std::max(power.mw[0], std::max(power.mw[1], power.mw[2]));
+    if (strongest < floorMw) {
+        return;
+    }
+    const Ptr<MiRadioDevice>& device = m_devices[receiver];
+    if (!m_remote.empty() && m_remote[receiver]) {
+        m_remoteRx(device, sender, frame, txCoil, power, duration);
+        return;
+    }
+    Simulator::ScheduleWithContext(device->GetNode()->GetId(), m_delay, &MiRadioDevice::StartRx, device, sender,
+                                   frame, txCoil, power, duration);
+}
+
+// ---------------------------------------------------------------------------
+// MiRadioDevice
+// ---------------------------------------------------------------------------
+
+inline TypeId MiRadioDevice::GetTypeId() {
+    static TypeId tid = TypeId("ns3::MiRadioDevice").SetParent<NetDevice>().SetGroupName("MiMac");
+    return tid;
+}
+
+inline void MiRadioDevice::SetChannel(Ptr<MiMacChannel> channel) {
+    m_channel = channel;
+    m_channelIndex = m_channel->Add(this);
+}
+
+inline void MiRadioDevice::DoDispose() {
+    m_channel = nullptr;
+    NetDevice::DoDispose();
+}
+
+inline double MiRadioDevice::GetSinr(int coil, double signalMw) const {
+    double interferenceMw = std::max(0.0, m_coilMw[coil] - signalMw);
+    return 10.0 * std::log10(signalMw / (MiCoupling::DbmToMw(m_channel->GetNoiseFloor()) + interferenceMw));
+}
+
+inline bool MiRadioDevice::IsCoilBusy(CoilID coil) const {
+    return m_coilMw[coil] >= MiCoupling::DbmToMw(m_channel->GetSensitivity());
+}
+
+inline bool MiRadioDevice::IsMediumBusy() const {
+    double sensitivityMw = MiCoupling::DbmToMw(m_channel->GetSensitivity());
+    return m_coilMw[COIL_X] >= sensitivityMw || m_coilMw[COIL_Y] >= sensitivityMw || m_coilMw[COIL_Z] >= sensitivityMw;
+}
+
+inline void MiRadioDevice::TransmitFrame(Ptr<const Packet> frame, CoilID coil, Time airtime) {
+    if (m_lockedRx != 0) {
+        m_lockedCorrupt = true;
+    }
+    m_transmitting = true;
+    m_counters.framesSent++;
+    m_channel->Transmit(this, frame, coil, airtime);
+}
+
+inline void MiRadioDevice::TransmitCarrier(CoilID coil, Time duration) {
+    if (m_lockedRx != 0) {
+        m_lockedCorrupt = true;
+    }
+    m_transmitting = true;
+    m_channel->Transmit(this, Create<Packet>(), coil, duration);
+}
+
+inline void MiRadioDevice::SetAsleep(bool asleep) {
+    m_asleep = asleep;
+    if (asleep) {
+        m_lockedRx = 0;
+    }
+}
+
+inline void MiRadioDevice::StartRx(Ptr<MiRadioDevice> sender, Ptr<const Packet> frame, CoilID txCoil,
+                                   const MiCoilPower& power, Time duration) {
+    uint64_t rxId = ++m_rxSerial;
+    double sensitivityMw = MiCoupling::DbmToMw(m_channel->GetSensitivity());
+    for (int c = 0; c < NUM_COILS; c++) {
+        m_coilMw[c] += power.mw[c];
+        if (power.mw[c] >= sensitivityMw) {
+            m_lastBusyStart[c] = Simulator::Now();
+        }
+    }
+    m_rxSignals++;
+
+    double threshold = m_channel->GetSinrThreshold();
+    if (m_transmitting || m_asleep) {
+        rxId = 0;
+    } else if (m_lockedRx != 0) {
+        // The frame being decoded survives a signal that leaves its coil clear enough.
+        if (!m_lockedCorrupt && GetSinr(m_lockedCoil, m_lockedMw) < threshold) {
+            m_counters.collisions++;
+            m_lockedCorrupt = true;
+        }
+        rxId = 0;
+    } else if (frame->GetSize() == 0) {
+        rxId = 0;  // carrier only
+    } else {
+        int best = COIL_X;
+        for (int c = 1; c < NUM_COILS; c++) {
+            if (GetSinr(c, power.mw[c]) > GetSinr(best, power.mw[best])) {
+                best = c;
+            }
+        }
+        if (power.mw[best] >= sensitivityMw && GetSinr(best, power.mw[best]) >= threshold) {
+            m_lockedRx = rxId;
+            m_lockedCoil = best;
+            m_lockedMw = power.mw[best];
+            m_lockedCorrupt = false;
+        } else {
+            rxId = 0;
+        }
+    }
+    Simulator::Schedule(duration, &MiRadioDevice::EndRx, this, rxId, power, sender, frame, txCoil);
+    NotifyRxStart();
+}
+
+inline void MiRadioDevice::EndRx(uint64_t rxId, MiCoilPower power, Ptr<MiRadioDevice> sender,
+                                 Ptr<const Packet> frame, CoilID txCoil) {
+    // Reset on the last signal so rounding cannot leave a residue.
+    m_rxSignals--;
+    for (int c = 0; c < NUM_COILS; c++) {
+        m_coilMw[c] = m_rxSignals == 0 ? 0.0 : std::max(0.0, m_coilMw[c] - power.mw[c]);
+    }
+    if (rxId != 0 && rxId == m_lockedRx) {
+        m_lockedRx = 0;
+        if (!m_lockedCorrupt) {
+            HandleFrame(sender, frame, txCoil, static_cast<CoilID>(m_lockedCoil),
+                        MiCoupling::MwToDbm(power.mw[m_lockedCoil]));
+        }
+    }
+    NotifyRxEnd();
+}
+
+// ---------------------------------------------------------------------------
+// MiMacNetDevice
+// ---------------------------------------------------------------------------
+
+inline TypeId MiMacNetDevice::GetTypeId() {
+    static TypeId tid =
+        TypeId("ns3::MiMacNetDevice")
+            .SetParent<MiRadioDevice>()
+            .SetGroupName("MiMac")
+            .AddConstructor<MiMacNetDevice>()
+            .AddAttribute("BitRate",
+                          "MI link bit rate (bit/s).",
+                          DoubleValue(10000.0),
+                          MakeDoubleAccessor(&MiMacNetDevice::m_bitRate),
+                          MakeDoubleChecker<double>(1.0))
+            .AddAttribute("DataAcquireTime",
+                          "Time spent in DATA_ACQUIRE reading the sensor.",
+                          TimeValue(MilliSeconds(10)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_dataAcquireTime),
+                          MakeTimeChecker())
+            .AddAttribute("SensingTime",
+                          "Carrier sensing window in CHANNEL_SENSING.",
+                          TimeValue(MilliSeconds(1)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_sensingTime),
+                          MakeTimeChecker())
+            .AddAttribute("BackoffSlot",
+                          "Backoff slot used when the channel is sensed busy.",
+                          TimeValue(MilliSeconds(1)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_backoffSlot),
+                          MakeTimeChecker())
+            .AddAttribute("MaxBackoffSlots",
+                          "Upper bound of the uniform backoff, in slots.",
+                          UintegerValue(8),
+                          MakeUintegerAccessor(&MiMacNetDevice::m_maxBackoffSlots),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("AckTimeout",
+                          "How long the source waits in RECEIVE for an ACK after the last REV.",
+                          TimeValue(MilliSeconds(40)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_ackTimeout),
+                          MakeTimeChecker())
+            .AddAttribute("DataTimeout",
+                          "How long the destination waits in RECEIVE for DATA after its ACK.",
+                          TimeValue(MilliSeconds(60)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_dataTimeout),
+                          MakeTimeChecker())
+            .AddAttribute("RevGuard",
+                          "Extra wait for a missing REV copy before selecting the coil.",
+                          TimeValue(MilliSeconds(1)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_revGuard),
+                          MakeTimeChecker())
+            .AddAttribute("MaxRetries",
+                          "REV rounds attempted after the first before DATA is dropped.",
+                          UintegerValue(3),
+                          MakeUintegerAccessor(&MiMacNetDevice::m_maxRetries),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("QueueLimit",
+                          "Maximum number of sensor readings waiting to be sent.",
+                          UintegerValue(16),
+                          MakeUintegerAccessor(&MiMacNetDevice::m_queueLimit),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("LinkCache",
+                          "Reuse the last selected coil pair per destination and send a single REV.",
+                          BooleanValue(true),
+                          MakeBooleanAccessor(&MiMacNetDevice::m_linkCacheEnabled),
+                          MakeBooleanChecker())
+            .AddAttribute("LinkCacheLifetime",
+                          "Age after which a cached coil pair is re-checked with a full REV sweep.",
+                          TimeValue(Seconds(30)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_linkCacheLifetime),
+                          MakeTimeChecker())
+            .AddAttribute("LinkCacheHysteresis",
+                          "ACK RSSI drop below the sweep RSSI (dB) that invalidates a cached pair.",
+                          DoubleValue(6.0),
+                          MakeDoubleAccessor(&MiMacNetDevice::m_linkCacheHysteresis),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("AggregationCount",
+                          "Buffered readings for one destination that trigger a DATA burst.",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&MiMacNetDevice::m_aggregationCount),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("AggregationBytes",
+                          "Buffered payload bytes that trigger a DATA burst (0: no byte limit).",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&MiMacNetDevice::m_aggregationBytes),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("AggregationDeadline",
+                          "Longest a reading waits in the buffer before a burst is sent (0: no deadline).",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_aggregationDeadline),
+                          MakeTimeChecker())
+            .AddAttribute("WakeInterval",
+                          "Period of the receiver wake-ups while idle (0: receiver always on).",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_wakeInterval),
+                          MakeTimeChecker())
+            .AddAttribute("ListenTime",
+                          "How long a wake-up listens for a REV preamble before sleeping again.",
+                          TimeValue(MilliSeconds(2)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_listenTime),
+                          MakeTimeChecker())
+            .AddAttribute("PreambleExtension",
+                          "Carrier sent ahead of every REV so a sleeping receiver wakes during it "
+                          "(0: one WakeInterval).",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&MiMacNetDevice::m_preambleExtension),
+                          MakeTimeChecker())
+            .AddTraceSource("StateTransition",
+                            "NodeState change with its reason.",
+                            MakeTraceSourceAccessor(&MiMacNetDevice::m_stateTrace),
+                            "ns3::MiMacNetDevice::StateTracedCallback")
+            .AddTraceSource("MacTx",
+                            "A frame was put on the medium.",
+                            MakeTraceSourceAccessor(&MiMacNetDevice::m_macTxTrace),
+                            "ns3::MiMacNetDevice::FrameTracedCallback")
+            .AddTraceSource("MacRx",
+                            "A frame was received without collision, with its coil pair and RSSI.",
+                            MakeTraceSourceAccessor(&MiMacNetDevice::m_macRxTrace),
+                            "ns3::MiMacNetDevice::RxTracedCallback")
+            .AddTraceSource("MacTxDrop",
+                            "DATA dropped because the queue was full or retries ran out.",
+                            MakeTraceSourceAccessor(&MiMacNetDevice::m_macTxDropTrace),
+                            "ns3::MiMacNetDevice::DropTracedCallback")
+            .AddTraceSource("CoilSelection",
+                            "REV RSSI per coil and the coil chosen for the ACK.",
+                            MakeTraceSourceAccessor(&MiMacNetDevice::m_coilSelectionTrace),
+                            "ns3::MiMacNetDevice::CoilSelectionTracedCallback")
+            .AddTraceSource("RadioSleep",
+                            "The receiver was switched off (true) or on (false) while idle.",
+                            MakeTraceSourceAccessor(&MiMacNetDevice::m_sleepTrace),
+                            "ns3::MiMacNetDevice::SleepTracedCallback");
+    return tid;
+}
+
+inline MiMacNetDevice::MiMacNetDevice()
+    : m_address(Mac16Address::Allocate()),
+      m_ifIndex(0),
+      m_mtu(MAX_PAYLOAD),
+      m_bitRate(10000.0),
+      m_maxBackoffSlots(8),
+      m_maxRetries(3),
+      m_queueLimit(16),
+      m_linkCacheEnabled(true),
+      m_linkCacheLifetime(Seconds(30)),
+      m_linkCacheHysteresis(6.0),
+      m_aggregationCount(1),
+      m_aggregationBytes(0),
+      m_listenTime(MilliSeconds(2)),
+      m_state(STATE_IDLE),
+      m_phase(PHASE_NONE),
+      m_nextPhase(PHASE_NONE),
+      m_retries(0),
+      m_burstRemaining(0),
+      m_linkTxCoil(COIL_X),
+      m_linkRxCoil(COIL_X),
+      m_revRssi{},
+      m_revRxCoil{},
+      m_revCoil(COIL_X),
+      m_singleRev(false) {
+    m_random = CreateObject<UniformRandomVariable>();
+}
+
+inline void MiMacNetDevice::DoInitialize() {
+    if (IsDutyCycled()) {
+        // A double draw: GetInteger() takes uint32_t and would wrap intervals above ~4.29 s.
+        m_wakePhase = TimeStep(static_cast<int64_t>(m_random->GetValue(0.0, m_wakeInterval.GetTimeStep())));
+        Sleep();
+    }
+    MiRadioDevice::DoInitialize();
+}
+
+inline void MiMacNetDevice::DoDispose() {
+    m_stateEvent.Cancel();
+    m_timeoutEvent.Cancel();
+    m_flushEvent.Cancel();
+    m_wakeEvent.Cancel();
+    m_sleepEvent.Cancel();
+    m_queue.clear();
+    m_node = nullptr;
+    m_random = nullptr;
+    MiRadioDevice::DoDispose();
+}
+
+inline bool MiMacNetDevice::SetMtu(const uint16_t mtu) {
+    if (mtu == 0 || mtu > MAX_PAYLOAD) {
+        return false;
+    }
+    m_mtu = mtu;
+    return true;
+}
+
+inline bool MiMacNetDevice::Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) {
+    if (packet->GetSize() == 0 || packet->GetSize() > m_mtu || m_queue.size() >= m_queueLimit) {
+        m_counters.dataDropped++;
+        m_macTxDropTrace(m_node->GetId(), packet);
+        return false;
+    }
+    m_queue.push_back(TxItem{packet, Mac16Address::ConvertFrom(dest), Simulator::Now(), false});
+    m_counters.dataEnqueued++;
+    if (m_state == STATE_IDLE && m_phase == PHASE_NONE) {
+        ServiceQueue();
+    }
+    return true;
+}
+
+inline void MiMacNetDevice::SetState(NodeState to, const char* reason) {
+    if (to == m_state) {
+        return;
+    }
+    if (m_state == STATE_IDLE) {
+        WakeRadio();
+    }
+    m_stateTrace(m_node->GetId(), m_state, to, reason);
+    m_counters.stateTransitions++;
+    m_state = to;
+}
+
+// Called whenever the device is idle: acquires the next new reading, starts
+// a transfer if the buffer is ready to flush, or waits for the deadline.
+inline void MiMacNetDevice::ServiceQueue() {
+    for (TxItem& item : m_queue) {
+        if (!item.acquired) {
+            m_phase = PHASE_ACQUIRE;
+            SetState(STATE_DATA_ACQUIRE, "Sensor interrupt");
+            m_stateEvent = Simulator::Schedule(m_dataAcquireTime, &MiMacNetDevice::EndDataAcquire, this);
+            return;
+        }
+    }
+    if (m_queue.empty()) {
+        return;
+    }
+    if (ReadyToFlush()) {
+        m_flushEvent.Cancel();
+        m_peer = m_queue.front().dest;
+        m_retries = 0;
+        m_accessStart = Simulator::Now();
+        StartSensing(PHASE_SEND_REV, "Data ready");
+    } else if (!m_aggregationDeadline.IsZero() && !m_flushEvent.IsPending()) {
+        Time due = m_queue.front().enqueued + m_aggregationDeadline;
+        m_flushEvent = Simulator::Schedule(due - Simulator::Now(), &MiMacNetDevice::FlushDeadline, this);
+    }
+}
+
+// The acquired readings at the head of the queue that share its destination
+// form the next burst.
+inline bool MiMacNetDevice::ReadyToFlush() const {
+    const TxItem& front = m_queue.front();
+    if (!front.acquired) {
+        return false;
+    }
+    if (m_queue.size() >= m_queueLimit ||
+        (!m_aggregationDeadline.IsZero() && Simulator::Now() - front.enqueued >= m_aggregationDeadline)) {
+        return true;
+    }
+    uint32_t count = 0;
+    uint32_t bytes = 0;
+    for (const TxItem& item : m_queue) {
+        if (!item.acquired) {
+            break;
+        }
+        if (item.dest != front.dest) {
+            return true;  // the burst cannot grow any more
+        }
+        count++;
+        bytes += item.packet->GetSize();
+    }
+    return count >= m_aggregationCount || (m_aggregationBytes > 0 && bytes >= m_aggregationBytes);
+}
+
+inline void MiMacNetDevice::FlushDeadline() {
+    if (m_state == STATE_IDLE && m_phase == PHASE_NONE) {
+        ServiceQueue();
+    }
+}
+
+inline void MiMacNetDevice::EndDataAcquire() {
+    for (TxItem& item : m_queue) {
+        if (!item.acquired) {
+            item.acquired = true;
+            break;
+        }
+    }
+    if (ReadyToFlush()) {
+        m_peer = m_queue.front().dest;
+        m_retries = 0;
+        m_accessStart = Simulator::Now();
+        m_flushEvent.Cancel();
+        StartSensing(PHASE_SEND_REV, "Data ready");
+    } else {
+        ReturnToIdle("Reading buffered");
+    }
+}
+
+inline void MiMacNetDevice::StartSensing(MacPhase next, const char* reason) {
+    m_phase = PHASE_SENSING;
+    m_nextPhase = next;
+    SetState(STATE_CHANNEL_SENSING, reason);
+    RestartSensing();
+}
+
+inline void MiMacNetDevice::RestartSensing() {
+    m_senseStart = Simulator::Now();
+    m_stateEvent = Simulator::Schedule(m_sensingTime, &MiMacNetDevice::EndSensing, this);
+}
+
+// A coil is busy if it hears a carrier now or heard one start during the
+// sensing window.
+inline bool MiMacNetDevice::SensedBusy(CoilID coil) const {
+    return IsCoilBusy(coil) || GetLastBusyStart(coil) >= m_senseStart;
+}
+
+inline void MiMacNetDevice::EndSensing() {
+    // REV goes out on every coil; ACK and DATA only on their side of the selected pair.
+    bool busy;
+    if (m_nextPhase == PHASE_SEND_REV) {
+        busy = SensedBusy(COIL_X) || SensedBusy(COIL_Y) || SensedBusy(COIL_Z);
+    } else {
+        busy = SensedBusy(m_nextPhase == PHASE_SEND_ACK ? m_linkRxCoil : m_linkTxCoil);
+    }
+    if (busy) {
+        m_counters.backoffs++;
+        uint32_t slots = m_random->GetInteger(1, m_maxBackoffSlots);
+        m_stateEvent = Simulator::Schedule(m_backoffSlot * slots, &MiMacNetDevice::RestartSensing, this);
+        return;
+    }
+    SetState(STATE_TRANSMIT, "Channel clear");
+    m_phase = m_nextPhase;
+    if (m_phase == PHASE_SEND_REV) {
+        StartRevRound();
+    } else if (m_phase == PHASE_SEND_ACK) {
+        // The ACK goes back over the selected pair, so it leaves on our receive coil.
+        MiMacHeader header(ACK_PACKET);
+        header.SetTxCoil(m_linkTxCoil);
+        header.SetRxCoil(m_linkRxCoil);
+        Ptr<Packet> frame = Create<Packet>();
+        frame->AddHeader(header);
+        frame->AddTrailer(MiMacTrailer());
+        SendFrame(frame, m_linkRxCoil);
+    } else if (m_phase == PHASE_SEND_DATA) {
+        m_burstRemaining = 0;
+        for (const TxItem& item : m_queue) {
+            if (!item.acquired || item.dest != m_peer) {
+                break;
+            }
+            m_burstRemaining++;
+        }
+        m_counters.bursts++;
+        SendData();
+    }
+}
+
+inline void MiMacNetDevice::StartRevRound() {
+    auto entry = m_linkCache.find(m_peer.ConvertToInt());
+    if (entry != m_linkCache.end() && Simulator::Now() - entry->second.sweepTime >= m_linkCacheLifetime) {
+        m_linkCache.erase(entry);
+        entry = m_linkCache.end();
+    }
+    m_singleRev = m_linkCacheEnabled && entry != m_linkCache.end();
+    CoilID coil = COIL_X;
+    if (m_singleRev) {
+        m_counters.revSingles++;
+        coil = entry->second.txCoil;
+    } else {
+        m_counters.revSweeps++;
+    }
+    // A receiver that wakes during the preamble stays up for the whole round.
+    Time preamble = GetRevPreamble();
+    if (preamble.IsZero()) {
+        SendRev(coil);
+        return;
+    }
+    m_counters.preambles++;
+    TransmitCarrier(coil, preamble);
+    m_stateEvent = Simulator::Schedule(preamble, &MiMacNetDevice::SendRev, this, coil);
+}
+
+inline void MiMacNetDevice::SendRev(CoilID coil) {
+    m_revCoil = coil;
+    MiMacHeader header(REV_PACKET);
+    header.SetSingleRev(m_singleRev);
+    header.SetTargetId(m_peer.ConvertToInt());
+    header.SetTxCoil(coil);
+    Ptr<Packet> frame = Create<Packet>();
+    frame->AddHeader(header);
+    frame->AddTrailer(MiMacTrailer());
+    SendFrame(frame, coil);
+}
+
+inline void MiMacNetDevice::SendFrame(Ptr<Packet> frame, CoilID coil) {
+    Time airtime = GetAirtime(frame->GetSize());
+    m_macTxTrace(m_node->GetId(), frame, coil);
+    TransmitFrame(frame, coil, airtime);
+    m_stateEvent = Simulator::Schedule(airtime, &MiMacNetDevice::EndTx, this);
+}
+
+inline void MiMacNetDevice::EndTx() {
+    m_transmitting = false;
+    switch (m_phase) {
+        case PHASE_SEND_REV:
+            if (!m_singleRev && m_revCoil != COIL_Z) {
+                SendRev(static_cast<CoilID>(m_revCoil + 1));
+                return;
+            }
+            m_phase = PHASE_WAIT_ACK;
+            SetState(STATE_RECEIVE, "Waiting for ACK");
+            m_timeoutEvent = Simulator::Schedule(m_ackTimeout, &MiMacNetDevice::AckTimeout, this);
+            break;
+        case PHASE_SEND_ACK:
+            m_phase = PHASE_WAIT_DATA;
+            SetState(STATE_RECEIVE, "Waiting for data");
+            m_timeoutEvent = Simulator::Schedule(m_dataTimeout, &MiMacNetDevice::DataTimeout, this);
+            break;
+        case PHASE_SEND_DATA:
+            m_queue.pop_front();
+            m_counters.dataSent++;
+            m_counters.accessDelay += (Simulator::Now() - m_accessStart).GetSeconds();
+            if (--m_burstRemaining > 0) {
+                SendData();
+                return;
+            }
+            ReturnToIdle("Transmission complete");
+            break;
+        default:
+            break;
+    }
+}
+
+inline void MiMacNetDevice::HandleFrame(Ptr<MiRadioDevice> sender, Ptr<const Packet> frame, CoilID txCoil,
+                                        CoilID rxCoil, double rssi) {
+    MiMacHeader header;
+    frame->PeekHeader(header);
+    Mac16Address from = sender->GetMacAddress();
+
+    switch (header.GetPacketType()) {
+        case REV_PACKET:
+            if (header.GetTargetId() != m_address.ConvertToInt()) {
+                return;
+            }
+            if (m_state == STATE_IDLE && m_phase == PHASE_NONE) {
+                m_peer = from;
+                m_phase = PHASE_COLLECT_REV;
+                std::fill(m_revRssi, m_revRssi + NUM_COILS, -1000.0);
+                SetState(STATE_RECEIVE, "Packet received with correct ID");
+            } else if (m_phase != PHASE_COLLECT_REV || from != m_peer) {
+                return;
+            }
+            m_macRxTrace(m_node->GetId(), frame, txCoil, rxCoil, rssi);
+            m_revRssi[header.GetTxCoil()] = rssi;
+            m_revRxCoil[header.GetTxCoil()] = rxCoil;
+            m_timeoutEvent.Cancel();
+            if (header.GetTxCoil() == COIL_Z || header.IsSingleRev()) {
+                FinishRevCollection();
+            } else {
+                // Wait for the remaining REV copies, then decide with what arrived.
+                uint32_t remaining = COIL_Z - header.GetTxCoil();
+                Time wait = GetAirtime(GetFrameSize(REV_PACKET)) * remaining + m_revGuard;
+                m_timeoutEvent = Simulator::Schedule(wait, &MiMacNetDevice::FinishRevCollection, this);
+            }
+            break;
+        case ACK_PACKET:
+            if (m_phase != PHASE_WAIT_ACK || from != m_peer) {
+                return;
+            }
+            m_macRxTrace(m_node->GetId(), frame, txCoil, rxCoil, rssi);
+            m_timeoutEvent.Cancel();
+            m_linkTxCoil = header.GetTxCoil();
+            m_linkRxCoil = header.GetRxCoil();
+            UpdateLinkCache(rssi);
+            StartSensing(PHASE_SEND_DATA, "Ready to send data");
+            break;
+        case DATA_PACKET: {
+            if (m_phase != PHASE_WAIT_DATA || from != m_peer) {
+                return;
+            }
+            m_macRxTrace(m_node->GetId(), frame, txCoil, rxCoil, rssi);
+            m_timeoutEvent.Cancel();
+            m_counters.dataReceived++;
+            Ptr<Packet> payload = frame->Copy();
+            payload->RemoveHeader(header);
+            MiMacTrailer trailer;
+            payload->RemoveTrailer(trailer);
+            if (header.HasMoreData()) {
+                m_timeoutEvent = Simulator::Schedule(m_dataTimeout, &MiMacNetDevice::DataTimeout, this);
+            } else {
+                ReturnToIdle("Data received completely");
+            }
+            if (!m_rxCallback.IsNull()) {
+                m_rxCallback(this, payload, 0, from);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+inline void MiMacNetDevice::FinishRevCollection() {
+    CoilID best = COIL_X;
+    for (int coil = 1; coil < NUM_COILS; coil++) {
+        if (m_revRssi[coil] > m_revRssi[best]) {
+            best = static_cast<CoilID>(coil);
+        }
+    }
+    m_coilSelectionTrace(m_node->GetId(), m_revRssi, m_revRxCoil, best);
+    m_linkTxCoil = best;
+    m_linkRxCoil = m_revRxCoil[best];
+    StartSensing(PHASE_SEND_ACK, "REV received, sending ACK");
+}
+
+inline void MiMacNetDevice::SendData() {
+    MiMacHeader header(DATA_PACKET);
+    header.SetMoreData(m_burstRemaining > 1);
+    Ptr<Packet> frame = m_queue.front().packet->Copy();
+    frame->AddHeader(header);
+    frame->AddTrailer(MiMacTrailer());
+    SendFrame(frame, m_linkTxCoil);
+}
+
+inline void MiMacNetDevice::UpdateLinkCache(double ackRssi) {
+    if (!m_linkCacheEnabled) {
+        return;
+    }
+    uint16_t key = m_peer.ConvertToInt();
+    if (!m_singleRev) {
+        m_linkCache[key] = LinkCacheEntry{m_linkTxCoil, m_linkRxCoil, ackRssi, Simulator::Now()};
+        return;
+    }
+    auto entry = m_linkCache.find(key);
+    if (entry != m_linkCache.end() && ackRssi < entry->second.rssi - m_linkCacheHysteresis) {
+        // This transfer still uses the pair; the next one sweeps again.
+        m_linkCache.erase(entry);
+        m_counters.cacheFallbacks++;
+    }
+}
+
+inline void MiMacNetDevice::AckTimeout() {
+    m_counters.ackTimeouts++;
+    if (m_singleRev && m_linkCache.erase(m_peer.ConvertToInt()) > 0) {
+        m_counters.cacheFallbacks++;
+    }
+    if (++m_retries > m_maxRetries) {
+        m_counters.dataDropped++;
+        m_macTxDropTrace(m_node->GetId(), m_queue.front().packet);
+        m_queue.pop_front();
+        ReturnToIdle("Retries exhausted");
+        return;
+    }
+    // Back off before the next REV round so competing sources desynchronise.
+    m_counters.retries++;
+    m_phase = PHASE_SENSING;
+    m_nextPhase = PHASE_SEND_REV;
+    SetState(STATE_CHANNEL_SENSING, "ACK timeout, retrying");
+    uint32_t slots = m_random->GetInteger(1, m_maxBackoffSlots);
+    m_stateEvent = Simulator::Schedule(m_backoffSlot * slots, &MiMacNetDevice::RestartSensing, this);
+}
+
+inline void MiMacNetDevice::DataTimeout() {
+    m_counters.dataTimeouts++;
+    ReturnToIdle("Data timeout");
+}
+
+inline void MiMacNetDevice::ReturnToIdle(const char* reason) {
+    m_phase = PHASE_NONE;
+    SetState(STATE_IDLE, reason);
+    ServiceQueue();
+    if (IsDutyCycled() && m_state == STATE_IDLE) {
+        Sleep();
+    }
+}
+
+inline void MiMacNetDevice::Sleep() {
+    m_sleepEvent.Cancel();
+    if (IsAsleep()) {
+        return;
+    }
+    SetAsleep(true);
+    m_sleepTrace(m_node->GetId(), true);
+    // Next point of this node's fixed schedule after now.
+    int64_t interval = m_wakeInterval.GetTimeStep();
+    int64_t since = Simulator::Now().GetTimeStep() - m_wakePhase.GetTimeStep();
+    int64_t next = m_wakePhase.GetTimeStep() + (since < 0 ? 0 : (since / interval + 1) * interval);
+    m_wakeEvent = Simulator::Schedule(TimeStep(next - Simulator::Now().GetTimeStep()), &MiMacNetDevice::Wake, this);
+}
+
+inline void MiMacNetDevice::Wake() {
+    m_counters.wakeups++;
+    WakeRadio();
+    // Stay up while a preamble is on the air; NotifyRxEnd() schedules the
+    // sleep once the medium is clear.
+    if (!IsMediumBusy()) {
+        m_sleepEvent = Simulator::Schedule(m_listenTime, &MiMacNetDevice::Sleep, this);
+    }
+}
+
+inline void MiMacNetDevice::WakeRadio() {
+    m_wakeEvent.Cancel();
+    m_sleepEvent.Cancel();
+    if (IsAsleep()) {
+        SetAsleep(false);
+        m_sleepTrace(m_node->GetId(), false);
+    }
+}
+
+// An idle node that woke up keeps listening while it hears a carrier.
+inline void MiMacNetDevice::NotifyRxStart() {
+    if (IsDutyCycled() && !IsAsleep() && m_state == STATE_IDLE && IsMediumBusy()) {
+        m_sleepEvent.Cancel();
+    }
+}
+
+inline void MiMacNetDevice::NotifyRxEnd() {
+    if (IsDutyCycled() && !IsAsleep() && m_state == STATE_IDLE && m_phase == PHASE_NONE && !IsMediumBusy() &&
+        !m_sleepEvent.IsPending()) {
+        m_sleepEvent = Simulator::Schedule(m_listenTime, &MiMacNetDevice::Sleep, this);
+    }
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_NET_DEVICE_H
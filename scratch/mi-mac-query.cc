@@ -0,0 +1,474 @@
+// Group-by aggregates over a results file (see mi-mac-results.h).
+//
+// The file is streamed one chunk at a time and only the columns the query
+// names are read, so memory follows the chunk size and the number of groups,
+// not the number of rows.  A --where condition on a numeric column also
+// skips every chunk whose min/max rules it out, without reading its data.
+// Aggregates are count, sum, mean, min, max and sd (sample standard
+// deviation, Welford).
+//
+// --describe lists the columns with their storage per row, --compact
+// rewrites small appended chunks into full ones and --generate appends
+// synthetic sweep rows, e.g. to time queries over millions of rows.
+//
+//   ./ns3 run "scratch/mi-mac-query --file=results.mires --group=mac,nodes --agg=count,mean:delivery,max:latency_p95_ms"
+//   ./ns3 run "scratch/mi-mac-query --file=results.mires --where=mac=mi,interval_s<=5 --group=payload_B"
+//   ./ns3 run "scratch/mi-mac-query --file=big.mires --generate=5000000 --describe"
+
+#include "mi-mac-results.h"
+
+#include "ns3/core-module.h"
+
+#include <array>
+#include <chrono>
+#include <map>
+
+using namespace ns3;
+
+enum AggregateFunction { AGG_COUNT, AGG_SUM, AGG_MEAN, AGG_MIN, AGG_MAX, AGG_SD };
+
+const char* aggregateNames[] = {"count", "sum", "mean", "min", "max", "sd"};
+
+struct Aggregate {
+    AggregateFunction function;
+    uint32_t column;  // unused for count
+    uint32_t slot;    // accumulator of the column within a group
+};
+
+struct Condition {
+    uint32_t column;
+    std::string op;
+    double number = 0.0;
+    std::string text;
+};
+
+// One aggregated column of one group.
+struct Accumulator {
+    uint64_t n = 0;
+    double sum = 0.0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void Add(double v) {
+        n++;
+        sum += v;
+        double delta = v - mean;
+        mean += delta / n;
+        m2 += delta * (v - mean);
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+};
+
+struct Group {
+    uint64_t rows = 0;
+    std::vector<Accumulator> columns;
+};
+
+// Group key part: a number, or the text of a string column.
+struct KeyPart {
+    double number = 0.0;
+    std::string text;
+
+    bool operator<(const KeyPart& o) const { return number != o.number ? number < o.number : text < o.text; }
+    bool operator==(const KeyPart& o) const { return number == o.number && text == o.text; }
+};
+
+template <typename T>
+bool Compare(const T& a, const std::string& op, const T& b) {
+    if (op == "=") {
+        return a == b;
+    } else if (op == "!=") {
+        return a != b;
+    } else if (op == "<") {
+        return a < b;
+    } else if (op == "<=") {
+        return a <= b;
+    } else if (op == ">") {
+        return a > b;
+    }
+    return a >= b;
+}
+
+// False if no value in [min, max] can satisfy the condition.
+bool MaySatisfy(const Condition& c, double min, double max) {
+    if (std::isnan(min)) {
+        return true;
+    }
+    if (c.op == "=") {
+        return c.number >= min && c.number <= max;
+    } else if (c.op == "!=") {
+        return !(min == max && min == c.number);
+    } else if (c.op == "<") {
+        return min < c.number;
+    } else if (c.op == "<=") {
+        return min <= c.number;
+    } else if (c.op == ">") {
+        return max > c.number;
+    }
+    return max >= c.number;
+}
+
+uint32_t RequireColumn(const MiResultReader& reader, const std::string& name) {
+    uint32_t column = reader.FindColumn(name);
+    NS_ABORT_MSG_IF(column == reader.GetColumns().size(), "no column '" << name << "'");
+    return column;
+}
+
+Condition ParseCondition(const MiResultReader& reader, const std::string& text) {
+    // Two-character operators first, so "<=" is not read as "<".
+    for (const char* op : {"<=", ">=", "!=", "=", "<", ">"}) {
+        size_t at = text.find(op);
+        if (at == std::string::npos || at == 0) {
+            continue;
+        }
+        Condition c;
+        c.column = RequireColumn(reader, text.substr(0, at));
+        c.op = op;
+        c.text = text.substr(at + std::strlen(op));
+        if (reader.GetColumns()[c.column].type != MI_COLUMN_STRING) {
+            std::stringstream field(c.text);
+            NS_ABORT_MSG_IF(!(field >> c.number), "'" << c.text << "' is not a number in '" << text << "'");
+        }
+        return c;
+    }
+    NS_ABORT_MSG("cannot read condition '" << text << "' (column, one of = != < <= > >=, value)");
+    return Condition();
+}
+
+// Appends rows of synthetic sweep results: configuration points of 100
+// replications each, with noisy metrics.
+void Generate(const std::string& path, uint64_t rows, uint32_t chunkRows) {
+    const uint32_t nodeCounts[] = {100, 400, 1000, 4000};
+    const double densities[] = {0.25, 1.0};
+    const double intervals[] = {1.0, 5.0, 30.0};
+    const uint32_t payloads[] = {1, 8, 16};
+    const uint32_t replications = 100;
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+    MiResultWriter writer;
+    writer.Open(path, MiRunRecord::Columns(), chunkRows);
+    MiRunRecord record;
+    record.simTime = 60.0;
+    record.seed = 1;
+    for (uint64_t k = 0; k < rows; k++) {
+        uint64_t point = k / replications;
+        record.csma = point % 2 == 1;
+        record.nodes = nodeCounts[point / 2 % 4];
+        record.density = densities[point / 8 % 2];
+        record.interval = intervals[point / 16 % 3];
+        record.payload = payloads[point / 48 % 3];
+        record.run = k % replications + 1;
+        double load = record.nodes * record.density / record.interval;
+        record.delivery = std::min(1.0, (record.csma ? 0.97 : 0.99) - 1e-4 * load + random->GetValue(-0.01, 0.01));
+        record.dataSent = static_cast<uint64_t>(record.nodes * record.simTime / record.interval);
+        record.dataReceived = static_cast<uint64_t>(record.dataSent * record.delivery);
+        record.throughput = record.dataReceived * record.payload * 8.0 / record.simTime;
+        record.collisions = static_cast<uint64_t>(load * random->GetValue(0.5, 1.5) * (record.csma ? 3 : 1));
+        record.nodeEnergyMean = 1e4 * random->GetValue(0.9, 1.1) * (record.csma ? 1.4 : 1.0);
+        record.nodeEnergyMax = record.nodeEnergyMean * random->GetValue(1.2, 2.0);
+        record.energy = record.nodeEnergyMean * record.nodes;
+        record.minLifetimeDays = 150.0 / random->GetValue(1.0, 1.3);
+        record.meanLifetimeDays = record.minLifetimeDays * 1.2;
+        record.accessDelayMs = 40.0 + load * random->GetValue(0.5, 1.5);
+        record.latencyP50Ms = record.accessDelayMs * 0.8;
+        record.latencyP95Ms = record.accessDelayMs * 2.0;
+        record.latencyP99Ms = record.accessDelayMs * 3.0;
+        record.events = record.nodes * 180;
+        record.wallSec = record.events / 3e6;
+        record.Append(writer, "synthetic");
+    }
+    writer.Close();
+}
+
+void Describe(const std::string& path) {
+    MiResultReader reader;
+    reader.Open(path);
+    const std::vector<MiResultColumn>& columns = reader.GetColumns();
+    std::vector<uint64_t> bytes(columns.size(), 0);
+    std::vector<std::array<uint64_t, 3>> encodings(columns.size(), {0, 0, 0});  // chunks per encoding
+    uint64_t rows = 0;
+    uint64_t chunks = 0;
+    while (reader.NextChunk()) {
+        rows += reader.GetChunkRows();
+        chunks++;
+        for (uint32_t c = 0; c < columns.size(); c++) {
+            bytes[c] += reader.GetChunkColumn(c).bytes;
+            encodings[c][reader.GetChunkColumn(c).encoding]++;
+        }
+    }
+    struct stat info;
+    stat(path.c_str(), &info);
+    std::cout << "\n  File:                    " << path << std::endl;
+    std::cout << "  Rows / chunks:           " << rows << " / " << chunks << std::endl;
+    std::cout << "  Size:                    " << info.st_size << " B ("
+              << (rows > 0 ? info.st_size / double(rows) : 0.0) << " B/row)" << std::endl;
+    if (reader.IsTruncated()) {
+        std::cout << "  (ends in a partly written or corrupt chunk, ignored)" << std::endl;
+    }
+    std::cout << "\n  " << std::left << std::setw(24) << "Column" << std::setw(8) << "Type" << std::right
+              << std::setw(12) << "B/row";
+    for (const char* name : MiEncodingNames) {
+        std::cout << std::setw(10) << name;
+    }
+    std::cout << "  (chunks)" << std::endl;
+    for (uint32_t c = 0; c < columns.size(); c++) {
+        std::cout << "  " << std::left << std::setw(24) << columns[c].name << std::setw(8)
+                  << MiColumnTypeNames[columns[c].type] << std::right << std::setw(12)
+                  << (rows > 0 ? bytes[c] / double(rows) : 0.0);
+        for (uint64_t count : encodings[c]) {
+            std::cout << std::setw(10) << count;
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string file;
+    std::string groupList;
+    std::string aggList = "count,mean:delivery,mean:throughput_bps,mean:latency_p95_ms,mean:node_energy_mean_uJ";
+    std::string whereList;
+    bool describe = false;
+    std::string compactFile;
+    uint64_t generate = 0;
+    uint32_t chunkRows = MiResultWriter::DEFAULT_CHUNK_ROWS;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("file", "Results file", file);
+    cmd.AddValue("group", "Comma-separated columns to group by (none: one group)", groupList);
+    cmd.AddValue("agg", "Comma-separated aggregates: count, or function:column with sum, mean, min, max, sd",
+                 aggList);
+    cmd.AddValue("where", "Comma-separated conditions that must all hold, e.g. mac=mi,nodes>=400", whereList);
+    cmd.AddValue("describe", "List the columns and their storage", describe);
+    cmd.AddValue("compact", "Rewrite the file into full chunks in this file", compactFile);
+    cmd.AddValue("generate", "First append this many synthetic sweep rows to the file", generate);
+    cmd.AddValue("chunkRows", "Rows per chunk written by --generate and --compact", chunkRows);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(file.empty(), "--file is required");
+
+    std::cout << "\n" << std::string(70, '=') << std::endl;
+    std::cout << "   MI MAC RESULTS QUERY" << std::endl;
+    std::cout << std::string(70, '=') << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    if (generate > 0) {
+        auto start = std::chrono::steady_clock::now();
+        Generate(file, generate, chunkRows);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "\n  Generated:               " << generate << " rows in " << seconds << " s ("
+                  << generate / seconds << " rows/s)" << std::endl;
+    }
+    if (!compactFile.empty()) {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t rows = MiCompactResults(file, compactFile, chunkRows);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "\n  Compacted:               " << rows << " rows into " << compactFile << " in " << seconds
+                  << " s" << std::endl;
+        file = compactFile;
+    }
+    if (describe) {
+        Describe(file);
+        std::cout << std::endl;
+        return 0;
+    }
+
+    MiResultReader reader;
+    reader.Open(file);
+    const std::vector<MiResultColumn>& columns = reader.GetColumns();
+
+    std::vector<uint32_t> groupColumns;
+    for (const std::string& name : MiParseList<std::string>(groupList)) {
+        groupColumns.push_back(RequireColumn(reader, name));
+    }
+    std::vector<Condition> conditions;
+    for (const std::string& text : MiParseList<std::string>(whereList)) {
+        conditions.push_back(ParseCondition(reader, text));
+    }
+    std::vector<Aggregate> aggregates;
+    std::vector<uint32_t> slotColumns;  // column of each accumulator slot
+    for (const std::string& text : MiParseList<std::string>(aggList)) {
+        size_t colon = text.find(':');
+        std::string function = text.substr(0, colon);
+        int f = 0;
+        while (f <= AGG_SD && function != aggregateNames[f]) {
+            f++;
+        }
+        NS_ABORT_MSG_IF(f > AGG_SD, "unknown aggregate '" << function << "'");
+        Aggregate aggregate{static_cast<AggregateFunction>(f), 0, 0};
+        if (f != AGG_COUNT) {
+            NS_ABORT_MSG_IF(colon == std::string::npos, "aggregate '" << text << "' needs a column");
+            aggregate.column = RequireColumn(reader, text.substr(colon + 1));
+            NS_ABORT_MSG_IF(columns[aggregate.column].type == MI_COLUMN_STRING,
+                            "cannot aggregate string column " << columns[aggregate.column].name);
+            auto slot = std::find(slotColumns.begin(), slotColumns.end(), aggregate.column);
+            aggregate.slot = slot - slotColumns.begin();
+            if (slot == slotColumns.end()) {
+                slotColumns.push_back(aggregate.column);
+            }
+        }
+        aggregates.push_back(aggregate);
+    }
+    NS_ABORT_MSG_IF(aggregates.empty(), "no aggregates");
+
+    // Columns each chunk must decode.
+    std::vector<uint8_t> used(columns.size(), 0);
+    for (uint32_t c : groupColumns) {
+        used[c] = 1;
+    }
+    for (uint32_t c : slotColumns) {
+        used[c] = 1;
+    }
+    for (const Condition& c : conditions) {
+        used[c.column] = 1;
+    }
+
+    std::vector<std::vector<double>> numbers(columns.size());
+    std::vector<std::vector<uint16_t>> codes(columns.size());
+    std::vector<std::vector<std::string>> dictionaries(columns.size());
+    std::vector<uint8_t> match;
+    std::map<std::vector<KeyPart>, Group> groups;
+    std::vector<KeyPart> key(groupColumns.size());
+    uint64_t scanned = 0;
+    uint64_t matched = 0;
+    uint64_t chunksRead = 0;
+    uint64_t chunksSkipped = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (reader.NextChunk()) {
+        uint32_t rows = reader.GetChunkRows();
+        scanned += rows;
+        bool skip = false;
+        for (const Condition& c : conditions) {
+            const MiResultColumnChunk& chunk = reader.GetChunkColumn(c.column);
+            skip = skip || (columns[c.column].type != MI_COLUMN_STRING && !MaySatisfy(c, chunk.min, chunk.max));
+        }
+        if (skip) {
+            chunksSkipped++;
+            continue;
+        }
+        chunksRead++;
+        for (uint32_t c = 0; c < columns.size(); c++) {
+            if (!used[c]) {
+                continue;
+            } else if (columns[c].type == MI_COLUMN_STRING) {
+                reader.ReadStrings(c, codes[c], dictionaries[c]);
+            } else {
+                reader.ReadNumbers(c, numbers[c]);
+            }
+        }
+
+        match.assign(rows, 1);
+        for (const Condition& c : conditions) {
+            if (columns[c.column].type == MI_COLUMN_STRING) {
+                // Decide once per dictionary entry.
+                const std::vector<std::string>& dictionary = dictionaries[c.column];
+                std::vector<uint8_t> pass(dictionary.size());
+                for (size_t e = 0; e < dictionary.size(); e++) {
+                    pass[e] = Compare(dictionary[e], c.op, c.text);
+                }
+                for (uint32_t k = 0; k < rows; k++) {
+                    match[k] &= pass[codes[c.column][k]];
+                }
+            } else {
+                const std::vector<double>& values = numbers[c.column];
+                for (uint32_t k = 0; k < rows; k++) {
+                    match[k] &= Compare(values[k], c.op, c.number);
+                }
+            }
+        }
+
+        // Rows of a sweep come in runs of one configuration, so the group
+        // found for the previous row is usually the right one.
+        Group* group = nullptr;
+        for (uint32_t k = 0; k < rows; k++) {
+            if (!match[k]) {
+                continue;
+            }
+            matched++;
+            bool same = group != nullptr;
+            for (size_t g = 0; g < groupColumns.size(); g++) {
+                uint32_t c = groupColumns[g];
+                KeyPart part;
+                if (columns[c].type == MI_COLUMN_STRING) {
+                    part.text = dictionaries[c][codes[c][k]];
+                } else {
+                    part.number = numbers[c][k];
+                }
+                if (!(part == key[g])) {
+                    key[g] = std::move(part);
+                    same = false;
+                }
+            }
+            if (!same) {
+                group = &groups[key];
+                group->columns.resize(slotColumns.size());
+            }
+            group->rows++;
+            for (size_t s = 0; s < slotColumns.size(); s++) {
+                group->columns[s].Add(numbers[slotColumns[s]][k]);
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (groupColumns.empty() && groups.empty()) {
+        groups[key].columns.resize(slotColumns.size());  // one all-zero row, as for any empty group
+    }
+
+    std::cout << "\n  File:                    " << file << std::endl;
+    std::cout << "  Rows / matched:          " << scanned << " / " << matched << std::endl;
+    std::cout << "  Chunks read / skipped:   " << chunksRead << " / " << chunksSkipped << std::endl;
+    std::cout << "  Bytes read:              " << reader.GetBytesRead() << std::endl;
+    std::cout << "  Query time:              " << seconds * 1e3 << " ms ("
+              << (seconds > 0.0 ? scanned / seconds / 1e6 : 0.0) << " M rows/s)" << std::endl;
+    if (reader.IsTruncated()) {
+        std::cout << "  (ends in a partly written or corrupt chunk, ignored)" << std::endl;
+    }
+
+    std::cout << "\n";
+    for (uint32_t c : groupColumns) {
+        std::cout << std::setw(std::max<int>(10, columns[c].name.size() + 2)) << columns[c].name;
+    }
+    std::vector<std::string> headers;
+    for (const Aggregate& a : aggregates) {
+        headers.push_back(a.function == AGG_COUNT ? std::string("count")
+                                                  : std::string(aggregateNames[a.function]) + ":" +
+                                                        columns[a.column].name);
+        std::cout << std::setw(std::max<int>(14, headers.back().size() + 2)) << headers.back();
+    }
+    std::cout << std::endl;
+    for (const auto& [groupKey, group] : groups) {
+        for (size_t g = 0; g < groupColumns.size(); g++) {
+            int width = std::max<int>(10, columns[groupColumns[g]].name.size() + 2);
+            if (columns[groupColumns[g]].type == MI_COLUMN_STRING) {
+                std::cout << std::setw(width) << groupKey[g].text;
+            } else {
+                int precision = columns[groupColumns[g]].type == MI_COLUMN_F64 ? 3 : 0;
+                std::cout << std::setw(width) << std::setprecision(precision) << groupKey[g].number;
+            }
+        }
+        std::cout << std::setprecision(3);
+        for (size_t a = 0; a < aggregates.size(); a++) {
+            int width = std::max<int>(14, headers[a].size() + 2);
+            const Aggregate& aggregate = aggregates[a];
+            if (aggregate.function == AGG_COUNT) {
+                std::cout << std::setw(width) << group.rows;
+                continue;
+            }
+            const Accumulator& acc = group.columns[aggregate.slot];
+            double value = 0.0;
+            switch (aggregate.function) {
+                case AGG_SUM: value = acc.sum; break;
+                case AGG_MEAN: value = acc.mean; break;
+                case AGG_MIN: value = acc.min; break;
+                case AGG_MAX: value = acc.max; break;
+                case AGG_SD: value = acc.n > 1 ? std::sqrt(acc.m2 / (acc.n - 1)) : 0.0; break;
+                case AGG_COUNT: break;
+            }
+            std::cout << std::setw(width) << value;
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::endl;
+    return 0;
+}
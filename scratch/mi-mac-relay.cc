@@ -0,0 +1,231 @@
+// Multi-hop relaying to a sink (see mi-mac-relay.h): a strip of randomly
+// oriented nodes with the sink at one end.  Routes follow link RSSI; for
+// each requested hop count the source is a node that many hops from the
+// sink, and it sends a fixed number of periodic readings.  Every hop count
+// is run with pipelined forwarding and with stop-and-wait, and reports
+// delivery, end-to-end latency and goodput next to the one-hop baseline,
+// plus the coil pair each hop of the longest route uses.
+//
+//   ./ns3 run "scratch/mi-mac-relay --hops=1,2,4,8 --interval=0.1 --readings=200"
+
+#include "mi-mac-relay.h"
+#include "mi-mac-scenario.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+using namespace ns3;
+
+struct RelayLayout {
+    std::vector<Vector> positions;
+    std::vector<MiOrientation> orientations;
+};
+
+struct RelayRun {
+    uint32_t hops = 0;
+    uint64_t originated = 0;
+    uint64_t delivered = 0;
+    uint64_t rejected = 0;
+    double meanLatency = 0.0;  // s
+    double p95Latency = 0.0;   // s
+    double goodput = 0.0;      // payload bit/s, first reading to last delivery
+    double energyPerReading = 0.0;  // µJ outside IDLE, whole network, per delivered reading
+};
+
+// lanes rows of length nodes along X, jittered, sink at index 0.
+RelayLayout MakeLayout(uint32_t length, uint32_t lanes, double spacing, double laneSpacing) {
+    RelayLayout layout;
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+        for (uint32_t k = 0; k < length; k++) {
+            layout.positions.push_back(Vector(k * spacing + random->GetValue(-0.1, 0.1) * spacing,
+                                              lane * laneSpacing + random->GetValue(-0.1, 0.1) * spacing, 0.0));
+            layout.orientations.push_back(MiOrientation::FromEuler(random->GetValue(0, 2 * M_PI),
+                                                                   random->GetValue(-M_PI / 2, M_PI / 2),
+                                                                   random->GetValue(0, 2 * M_PI)));
+        }
+    }
+    return layout;
+}
+
+RelayRun SimulateRelay(const MiMacHelper& mac, const RelayLayout& layout, const MiRoutingTable& routes,
+                       uint32_t source, bool stopAndWait, uint32_t readings, double interval, uint32_t payload) {
+    NodeContainer nodes;
+    nodes.Create(layout.positions.size());
+    NetDeviceContainer devices = mac.Install(nodes);
+    for (uint32_t i = 0; i < devices.GetN(); i++) {
+        Ptr<MiRadioDevice> device = DynamicCast<MiRadioDevice>(devices.Get(i));
+        device->SetPosition(layout.positions[i]);
+        device->SetOrientation(layout.orientations[i]);
+    }
+    Ptr<MiEnergyModel> energy = CreateObject<MiEnergyModel>();
+    energy->Install(devices);
+    MiRelayNetwork relay;
+    relay.Install(devices, routes);
+    relay.SetStopAndWait(stopAndWait);
+
+    const double start = 1.0;
+    for (uint32_t r = 0; r < readings; r++) {
+        Simulator::ScheduleWithContext(nodes.Get(source)->GetId(), Seconds(start + r * interval),
+                                       &MiRelayNetwork::Originate, &relay, source, payload);
+    }
+    // Stop-and-wait releases held readings long after they were generated.
+    double drain = stopAndWait ? readings * 2.0 : 30.0;
+    Simulator::Stop(Seconds(start + readings * interval + drain));
+    Simulator::Run();
+
+    RelayRun run;
+    run.hops = routes.hops[source];
+    run.originated = relay.GetOriginated();
+    run.delivered = relay.GetDelivered();
+    run.rejected = relay.GetRejected();
+    std::vector<double> latencies = relay.GetLatencies();
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        for (double l : latencies) {
+            run.meanLatency += l / latencies.size();
+        }
+        run.p95Latency = latencies[std::min<size_t>(latencies.size() - 1, 0.95 * latencies.size())];
+        run.goodput = relay.GetDeliveredBytes() * 8.0 / (relay.GetLastDelivery().GetSeconds() - start);
+        double active = 0.0;
+        for (uint32_t i = 0; i < energy->GetN(); i++) {
+            active += energy->GetEnergy(i) - energy->GetStateEnergy(i, STATE_IDLE);
+        }
+        run.energyPerReading = active / run.delivered;
+    }
+    Simulator::Destroy();
+    return run;
+}
+
+int main(int argc, char *argv[]) {
+    std::string hopList = "1,2,3,4,6,8";
+    uint32_t length = 0;
+    uint32_t lanes = 2;
+    double spacing = 1.5;
+    double laneSpacing = 1.5;
+    double range = 4.0;
+    double minRssi = -75.0;
+    double targetRssi = -60.0;
+    double penaltyDb = 10.0;
+    uint32_t readings = 100;
+    double interval = 0.2;
+    uint32_t payload = MiRelayNetwork::GetMaxReadingSize();
+    uint32_t seed = 1;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("hops", "Comma-separated hop counts from source to sink", hopList);
+    cmd.AddValue("length", "Nodes per lane (0: enough for the longest hop count)", length);
+    cmd.AddValue("lanes", "Parallel lanes of nodes, giving routing alternatives", lanes);
+    cmd.AddValue("spacing", "Node spacing along a lane (m)", spacing);
+    cmd.AddValue("laneSpacing", "Distance between lanes (m)", laneSpacing);
+    cmd.AddValue("range", "Coupling evaluation radius (m)", range);
+    cmd.AddValue("minRssi", "Weakest best-pair RSSI a route may use (dBm)", minRssi);
+    cmd.AddValue("targetRssi", "Best-pair RSSI at which a link costs a single hop (dBm)", targetRssi);
+    cmd.AddValue("penaltyDb", "RSSI shortfall below the target that costs one extra hop (dB)", penaltyDb);
+    cmd.AddValue("readings", "Readings sent by the source", readings);
+    cmd.AddValue("interval", "Time between readings at the source (s)", interval);
+    cmd.AddValue("payload", "Reading size (bytes, after the 7-byte route header)", payload);
+    cmd.AddValue("seed", "RNG seed", seed);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(payload < 1 || payload > MiRelayNetwork::GetMaxReadingSize(),
+                    "payload must be 1-" << MiRelayNetwork::GetMaxReadingSize() << " bytes");
+
+    RngSeedManager::SetSeed(seed);
+    std::vector<uint32_t> hopCounts = MiParseList<uint32_t>(hopList);
+    NS_ABORT_MSG_IF(hopCounts.empty(), "no hop counts");
+    if (length == 0) {
+        // Routes may skip nodes, so leave room for about two nodes per hop.
+        length = 2 * *std::max_element(hopCounts.begin(), hopCounts.end()) + 4;
+    }
+
+    MiMacHelper mac;
+    mac.SetChannelAttribute("Range", DoubleValue(range));
+    RelayLayout layout = MakeLayout(length, std::max(lanes, 1u), spacing, laneSpacing);
+
+    // Routes depend on geometry only, so one table serves every run.
+    NodeContainer routeNodes;
+    routeNodes.Create(layout.positions.size());
+    NetDeviceContainer routeDevices = mac.Install(routeNodes);
+    for (uint32_t i = 0; i < routeDevices.GetN(); i++) {
+        Ptr<MiRadioDevice> device = DynamicCast<MiRadioDevice>(routeDevices.Get(i));
+        device->SetPosition(layout.positions[i]);
+        device->SetOrientation(layout.orientations[i]);
+    }
+    Ptr<MiMacChannel> channel = DynamicCast<MiMacChannel>(routeDevices.Get(0)->GetChannel());
+    MiRoutingTable routes = MiRoutingTable::Build(channel, 0, minRssi, targetRssi, penaltyDb);
+    Simulator::Destroy();
+
+    std::cout << "\n" << std::string(70, '=') << std::endl;
+    std::cout << "   MI MAC MULTI-HOP RELAYING" << std::endl;
+    std::cout << std::string(70, '=') << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    uint32_t reachable = 0;
+    for (uint32_t i = 0; i < layout.positions.size(); i++) {
+        reachable += routes.HasRoute(i);
+    }
+    std::cout << "\n  Nodes:                   " << layout.positions.size() << " (" << lanes << " lanes of " << length
+              << ", " << spacing << " m apart)" << std::endl;
+    std::cout << "  Routed to the sink:      " << reachable << std::endl;
+    std::cout << "  Link RSSI floor/target:  " << minRssi << " / " << targetRssi << " dBm" << std::endl;
+    std::cout << "  Offered load:            " << readings << " readings of " << payload << " B every "
+              << interval << " s" << std::endl;
+
+    // Farthest source per hop count along the strip, so routes are as straight as possible.
+    std::vector<std::pair<uint32_t, uint32_t>> sources;  // hop count, source
+    for (uint32_t h : hopCounts) {
+        uint32_t source = MiRoutingTable::NO_ROUTE;
+        for (uint32_t i = 0; i < layout.positions.size(); i++) {
+            if (routes.HasRoute(i) && routes.hops[i] == h &&
+                (source == MiRoutingTable::NO_ROUTE || layout.positions[i].x > layout.positions[source].x)) {
+                source = i;
+            }
+        }
+        if (source == MiRoutingTable::NO_ROUTE) {
+            std::cout << "  (no node is " << h << " hops from the sink; lengthen the strip)" << std::endl;
+            continue;
+        }
+        sources.emplace_back(h, source);
+    }
+    NS_ABORT_MSG_IF(sources.empty(), "no source at any requested hop count");
+    // Ascending, so the 1-hop baseline runs before the rows compared to it.
+    std::sort(sources.begin(), sources.end());
+
+    const std::pair<uint32_t, uint32_t>& longest = sources.back();
+    std::cout << "\n  Route of the " << longest.first << "-hop source (coil pair and best-pair RSSI per hop):"
+              << std::endl;
+    std::vector<uint32_t> path = routes.PathFrom(longest.second);
+    for (size_t k = 0; k + 1 < path.size(); k++) {
+        uint32_t from = path[k];
+        std::cout << "    " << std::setw(4) << from << " -> " << std::setw(4) << path[k + 1] << "   "
+                  << coilNames[routes.linkPair[from] / NUM_COILS] << " -> "
+                  << coilNames[routes.linkPair[from] % NUM_COILS] << std::setw(10) << routes.linkRssi[from]
+                  << " dBm" << std::endl;
+    }
+
+    for (bool stopAndWait : {false, true}) {
+        std::cout << "\n  " << (stopAndWait ? "Stop-and-wait (one reading in the network)" : "Pipelined forwarding")
+                  << std::endl;
+        std::cout << std::setw(8) << "Hops" << std::setw(11) << "Delivery" << std::setw(14) << "Latency ms"
+                  << std::setw(12) << "p95 ms" << std::setw(14) << "Goodput b/s" << std::setw(13) << "vs 1-hop"
+                  << std::setw(15) << "µJ/reading" << std::endl;
+        RelayRun baseline;
+        for (const auto& [h, source] : sources) {
+            RelayRun run = SimulateRelay(mac, layout, routes, source, stopAndWait, readings, interval, payload);
+            if (h == 1) {
+                baseline = run;
+            }
+            std::cout << std::setw(8) << run.hops << std::setw(11)
+                      << static_cast<double>(run.delivered) / std::max<uint64_t>(run.originated, 1) << std::setw(14)
+                      << 1e3 * run.meanLatency << std::setw(12) << 1e3 * run.p95Latency << std::setw(14)
+                      << run.goodput;
+            if (baseline.goodput > 0.0) {
+                std::cout << std::setw(12) << run.goodput / baseline.goodput << "x";
+            } else {
+                std::cout << std::setw(13) << "-";
+            }
+            std::cout << std::setw(15) << run.energyPerReading << std::endl;
+        }
+    }
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,401 @@
+#ifndef MI_MAC_RELAY_H
+#define MI_MAC_RELAY_H
+
+// Multi-hop forwarding over the MI MAC.
+//
+// MiRoutingTable is a shortest-path tree towards one sink over the links
+// whose best coil pair is received with some margin above the sensitivity.
+// A link costs one hop plus a penalty that grows as its best-pair RSSI
+// falls below a target, so routes prefer a few strong hops to many weak or
+// one marginal one.  The RSSI comes from the channel geometry, the same
+// 3x3 coupling the REV sweep measures.
+//
+// MiRelayNetwork forwards readings hop by hop.  Every hop is an ordinary
+// MAC transfer, so each relay picks its own coil pair with the REV/ACK
+// sweep and keeps it in its link cache for the next frames.  A relay queues
+// what it receives and hands the next frame to its MAC once both it and its
+// next hop are idle, so several frames of a flow are in flight on different
+// hops at once, each on the coil pair of its hop.  The MAC has one
+// transceiver and a relay that is forwarding does not answer REVs, so
+// sending into a busy next hop would only burn retries; the next hop's idle
+// state stands in for what a node learns by overhearing it.  Stop-and-wait
+// mode keeps one frame per flow in the network for comparison.
+
+#include "mi-mac-grid.h"
+#include "mi-mac-net-device.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+// Prepended to every relayed payload.  Reading payloads shrink by its size
+// to fit the MAC's 16-byte DATA frames.
+class MiRouteHeader : public Header {
+  public:
+    static constexpr uint32_t SIZE = 7;
+
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::MiRouteHeader")
+                                .SetParent<Header>()
+                                .SetGroupName("MiMac")
+                                .AddConstructor<MiRouteHeader>();
+        return tid;
+    }
+    TypeId GetInstanceTypeId() const override { return GetTypeId(); }
+
+    uint16_t origin = 0;    // channel index of the source; Install() limits networks to 65536 nodes
+    uint32_t sequence = 0;  // per source; 32 bits so long runs do not wrap
+    uint8_t hops = 0;       // hops travelled so far
+
+    uint32_t GetSerializedSize() const override { return SIZE; }
+    void Serialize(Buffer::Iterator start) const override {
+        start.WriteHtonU16(origin);
+        start.WriteHtonU32(sequence);
+        start.WriteU8(hops);
+    }
+    uint32_t Deserialize(Buffer::Iterator start) override {
+        origin = start.ReadNtohU16();
+        sequence = start.ReadNtohU32();
+        hops = start.ReadU8();
+        return SIZE;
+    }
+    void Print(std::ostream& os) const override {
+        os << "origin " << origin << " seq " << sequence << " hops " << uint32_t(hops);
+    }
+};
+
+struct MiRoutingTable {
+    static constexpr uint32_t NO_ROUTE = UINT32_MAX;
+
+    uint32_t sink = 0;
+    // Per channel index.
+    std::vector<uint32_t> nextHop;  // NO_ROUTE if the sink is unreachable; the sink points to itself
+    std::vector<uint32_t> hops;
+    std::vector<double> cost;
+    std::vector<double> linkRssi;   // dBm, best coil pair towards nextHop
+    std::vector<uint8_t> linkPair;  // txCoil * 3 + rxCoil of that pair
+
+    // Links weaker than minRssi are unusable; a link at or above targetRssi
+    // costs 1, and every penaltyDb below it one more.
+    static MiRoutingTable Build(Ptr<MiMacChannel> channel, uint32_t sink, double minRssi, double targetRssi,
+                                double penaltyDb);
+
+    bool HasRoute(uint32_t index) const { return nextHop[index] != NO_ROUTE; }
+    // Channel indices from index to the sink, both included.
+    std::vector<uint32_t> PathFrom(uint32_t index) const;
+};
+
+inline MiRoutingTable MiRoutingTable::Build(Ptr<MiMacChannel> channel, uint32_t sink, double minRssi,
+                                            double targetRssi, double penaltyDb) {
+    uint32_t n = channel->GetNDevices();
+    MiRoutingTable table;
+    table.sink = sink;
+    table.nextHop.assign(n, NO_ROUTE);
+    table.hops.assign(n, 0);
+    table.cost.assign(n, INFINITY);
+    table.linkRssi.assign(n, -INFINITY);
+    table.linkPair.assign(n, 0);
+
+    std::vector<double> x(n), y(n), z(n);
+    for (uint32_t i = 0; i < n; i++) {
+        Vector p = channel->GetPosition(i);
+        x[i] = p.x;
+        y[i] = p.y;
+        z[i] = p.z;
+    }
+    double range = channel->GetRange();
+    MiSpatialGrid grid;
+    grid.Build(x, y, z, range);
+
+    // Dijkstra from the sink over reversed links: settling u relaxes v -> u.
+    typedef std::pair<double, uint32_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    std::vector<bool> settled(n, false);
+    table.nextHop[sink] = sink;
+    table.cost[sink] = 0.0;
+    open.push(Entry(0.0, sink));
+    double rssi[NUM_COILS * NUM_COILS];
+    while (!open.empty()) {
+        uint32_t u = open.top().second;
+        open.pop();
+        if (settled[u]) {
+            continue;
+        }
+        settled[u] = true;
+        grid.ForEachCandidate(x[u], y[u], z[u], [&](uint32_t v) {
+            double dx = x[v] - x[u];
+            double dy = y[v] - y[u];
+            double dz = z[v] - z[u];
+            if (settled[v] || dx * dx + dy * dy + dz * dz > range * range) {
+                return;
+            }
+            channel->GetPairRssi(v, u, rssi);
+            int best = std::max_element(rssi, rssi + NUM_COILS * NUM_COILS) - rssi;
+            if (rssi[best] < minRssi) {
+                return;
+            }
+            double cost = table.cost[u] + 1.0 + std::max(0.0, targetRssi - rssi[best]) / penaltyDb;
+            if (cost < table.cost[v]) {
+                table.cost[v] = cost;
+                table.nextHop[v] = u;
+                table.hops[v] = table.hops[u] + 1;
+                table.linkRssi[v] = rssi[best];
+                table.linkPair[v] = best;
+                open.push(Entry(cost, v));
+            }
+        });
+    }
+    return table;
+}
+
+inline std::vector<uint32_t> MiRoutingTable::PathFrom(uint32_t index) const {
+    std::vector<uint32_t> path;
+    if (!HasRoute(index)) {
+        return path;
+    }
+    path.push_back(index);
+    while (index != sink) {
+        index = nextHop[index];
+        path.push_back(index);
+    }
+    return path;
+}
+
+class MiRelayNetwork {
+  public:
+    // Sets every device's receive callback; devices must be indexed like
+    // their channel.
+    void Install(const NetDeviceContainer& devices, const MiRoutingTable& routes);
+    // Stop-and-wait: a source holds its next reading until the previous one
+    // reached the sink, was dropped, or has not arrived after timeout.
+    void SetStopAndWait(bool enabled, Time timeout = Seconds(2)) {
+        m_stopAndWait = enabled;
+        m_stopAndWaitTimeout = timeout;
+    }
+    // Payload bytes a reading can carry after the route header.
+    static uint32_t GetMaxReadingSize() { return MiMacNetDevice::MAX_PAYLOAD - MiRouteHeader::SIZE; }
+
+    // A new reading of size bytes at the source with this channel index.
+    void Originate(uint32_t source, uint32_t size);
+
+    uint64_t GetOriginated() const { return m_originated; }
+    uint64_t GetDelivered() const { return m_delivered; }
+    uint64_t GetDeliveredBytes() const { return m_deliveredBytes; }
+    uint64_t GetForwarded() const { return m_forwarded; }
+    // Readings with no route or that the MAC refused at some hop (queue full).
+    uint64_t GetRejected() const { return m_rejected; }
+    // End-to-end latency of every delivered reading, s.
+    const std::vector<double>& GetLatencies() const { return m_latencies; }
+    Time GetFirstDelivery() const { return m_firstDelivery; }
+    Time GetLastDelivery() const { return m_lastDelivery; }
+
+  private:
+    struct Flow {
+        uint32_t nextSequence = 0;
+        std::deque<uint32_t> held;  // reading sizes waiting for stop-and-wait
+        bool inFlight = false;
+        uint32_t outstanding = 0;   // sequence of the reading in flight
+        EventId timeout;
+    };
+
+    bool Receive(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address& from);
+    void Forward(uint32_t at, Ptr<Packet> packet);
+    // Hands the oldest pending frame at this node to its MAC if both ends are idle.
+    void TryForward(uint32_t at);
+    static void StateTransition(MiRelayNetwork* relay, uint32_t nodeId, NodeState from, NodeState to,
+                                const char* reason);
+    void Inject(uint32_t source, uint32_t size);
+    // DATA dropped by the MAC at whatever hop, queue full or retries exhausted.
+    static void MacDrop(MiRelayNetwork* relay, uint32_t nodeId, Ptr<const Packet> packet);
+    // The flow's reading left the network, delivered or not.  Ignored for
+    // any reading but the outstanding one, e.g. one delivered after its
+    // stop-and-wait timeout.
+    void Finished(uint32_t origin, uint32_t sequence);
+    // Stop-and-wait gave up on the reading; a late delivery adds no latency.
+    void TimedOut(uint32_t origin, uint32_t sequence);
+    static uint64_t Key(const MiRouteHeader& header) { return uint64_t(header.origin) << 32 | header.sequence; }
+
+    std::vector<Ptr<MiRadioDevice>> m_devices;
+    std::vector<uint32_t> m_indexOfNode;
+    MiRoutingTable m_routes;
+    std::vector<std::vector<uint32_t>> m_upstream;       // nodes whose next hop is this one
+    std::vector<std::deque<Ptr<Packet>>> m_pending;      // frames waiting to be handed to the MAC
+    std::vector<bool> m_idle;
+    bool m_stopAndWait = false;
+    Time m_stopAndWaitTimeout;
+    std::unordered_map<uint32_t, Flow> m_flows;          // by source
+    std::unordered_map<uint64_t, Time> m_created;        // by Key()
+    uint64_t m_originated = 0;
+    uint64_t m_delivered = 0;
+    uint64_t m_deliveredBytes = 0;
+    uint64_t m_forwarded = 0;
+    uint64_t m_rejected = 0;
+    std::vector<double> m_latencies;
+    Time m_firstDelivery = Time::Max();
+    Time m_lastDelivery;
+};
+
+inline void MiRelayNetwork::Install(const NetDeviceContainer& devices, const MiRoutingTable& routes) {
+    uint32_t n = devices.GetN();
+    NS_ABORT_MSG_IF(n > UINT16_MAX + 1u, "relay networks are limited to " << UINT16_MAX + 1u
+                                                                          << " nodes by the route header's origin");
+    m_routes = routes;
+    m_devices.resize(n);
+    m_upstream.assign(n, {});
+    m_pending.assign(n, {});
+    m_idle.assign(n, true);
+    m_indexOfNode.clear();
+    for (uint32_t i = 0; i < n; i++) {
+        m_devices[i] = DynamicCast<MiRadioDevice>(devices.Get(i));
+        NS_ABORT_MSG_IF(m_devices[i]->GetChannelIndex() != i, "devices must be in channel order");
+        if (routes.HasRoute(i) && i != routes.sink) {
+            m_upstream[routes.nextHop[i]].push_back(i);
+        }
+        uint32_t nodeId = m_devices[i]->GetNode()->GetId();
+        if (nodeId >= m_indexOfNode.size()) {
+            m_indexOfNode.resize(nodeId + 1, n);
+        }
+        m_indexOfNode[nodeId] = i;
+        m_devices[i]->SetReceiveCallback(MakeCallback(&MiRelayNetwork::Receive, this));
+        m_devices[i]->TraceConnectWithoutContext("MacTxDrop", MakeBoundCallback(&MiRelayNetwork::MacDrop, this));
+        m_devices[i]->TraceConnectWithoutContext("StateTransition",
+                                                 MakeBoundCallback(&MiRelayNetwork::StateTransition, this));
+    }
+}
+
+inline void MiRelayNetwork::Originate(uint32_t source, uint32_t size) {
+    NS_ABORT_MSG_IF(size == 0 || size > GetMaxReadingSize(), "reading must be 1-" << GetMaxReadingSize() << " bytes");
+    m_originated++;
+    Flow& flow = m_flows[source];
+    if (m_stopAndWait && flow.inFlight) {
+        flow.held.push_back(size);
+        return;
+    }
+    Inject(source, size);
+}
+
+inline void MiRelayNetwork::Inject(uint32_t source, uint32_t size) {
+    Flow& flow = m_flows[source];
+    MiRouteHeader header;
+    header.origin = source;
+    header.sequence = flow.nextSequence++;
+    m_created[Key(header)] = Simulator::Now();
+    flow.inFlight = true;
+    flow.outstanding = header.sequence;
+    if (m_stopAndWait) {
+        flow.timeout =
+            Simulator::Schedule(m_stopAndWaitTimeout, &MiRelayNetwork::TimedOut, this, source, header.sequence);
+    }
+    Ptr<Packet> packet = Create<Packet>(size);
+    packet->AddHeader(header);
+    Forward(source, packet);
+}
+
+inline void MiRelayNetwork::Forward(uint32_t at, Ptr<Packet> packet) {
+    if (!m_routes.HasRoute(at)) {
+        MiRouteHeader header;
+        packet->PeekHeader(header);
+        m_rejected++;
+        m_created.erase(Key(header));
+        Finished(header.origin, header.sequence);
+        return;
+    }
+    m_pending[at].push_back(packet);
+    TryForward(at);
+}
+
+inline void MiRelayNetwork::TryForward(uint32_t at) {
+    uint32_t next = m_routes.nextHop[at];
+    if (m_pending[at].empty() || !m_idle[at] || !m_idle[next]) {
+        return;
+    }
+    Ptr<Packet> packet = m_pending[at].front();
+    m_pending[at].pop_front();
+    if (!m_devices[at]->Send(packet, m_devices[next]->GetAddress(), 0)) {
+        // Queue full; MacDrop() has already let the flow go on.
+        m_rejected++;
+    }
+}
+
+inline void MiRelayNetwork::StateTransition(MiRelayNetwork* relay, uint32_t nodeId, NodeState from, NodeState to,
+                                            const char* reason) {
+    uint32_t i = relay->m_indexOfNode[nodeId];
+    relay->m_idle[i] = to == STATE_IDLE;
+    if (to != STATE_IDLE) {
+        return;
+    }
+    // Deferred: the MAC is still inside its own transition.
+    Simulator::ScheduleNow(&MiRelayNetwork::TryForward, relay, i);
+    for (uint32_t u : relay->m_upstream[i]) {
+        if (!relay->m_pending[u].empty()) {
+            Simulator::ScheduleNow(&MiRelayNetwork::TryForward, relay, u);
+        }
+    }
+}
+
+inline bool MiRelayNetwork::Receive(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                    const Address& from) {
+    uint32_t at = DynamicCast<MiRadioDevice>(device)->GetChannelIndex();
+    Ptr<Packet> copy = packet->Copy();
+    MiRouteHeader header;
+    copy->RemoveHeader(header);
+    header.hops++;
+    if (at != m_routes.sink) {
+        copy->AddHeader(header);
+        m_forwarded++;
+        Forward(at, copy);
+        return true;
+    }
+
+    auto created = m_created.find(Key(header));
+    if (created != m_created.end()) {
+        m_latencies.push_back((Simulator::Now() - created->second).GetSeconds());
+        m_created.erase(created);
+    }
+    m_delivered++;
+    m_deliveredBytes += copy->GetSize();
+    m_firstDelivery = std::min(m_firstDelivery, Simulator::Now());
+    m_lastDelivery = Simulator::Now();
+    Finished(header.origin, header.sequence);
+    return true;
+}
+
+inline void MiRelayNetwork::MacDrop(MiRelayNetwork* relay, uint32_t nodeId, Ptr<const Packet> packet) {
+    MiRouteHeader header;
+    packet->PeekHeader(header);
+    if (relay->m_created.erase(Key(header)) > 0) {
+        relay->Finished(header.origin, header.sequence);
+    }
+}
+
+inline void MiRelayNetwork::TimedOut(uint32_t origin, uint32_t sequence) {
+    MiRouteHeader header;
+    header.origin = origin;
+    header.sequence = sequence;
+    m_created.erase(Key(header));
+    Finished(origin, sequence);
+}
+
+inline void MiRelayNetwork::Finished(uint32_t origin, uint32_t sequence) {
+    Flow& flow = m_flows[origin];
+    if (!flow.inFlight || sequence != flow.outstanding) {
+        return;
+    }
+    flow.inFlight = false;
+    flow.timeout.Cancel();
+    if (m_stopAndWait && !flow.held.empty()) {
+        uint32_t size = flow.held.front();
+        flow.held.pop_front();
+        Simulator::ScheduleNow(&MiRelayNetwork::Inject, this, origin, size);
+    }
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_RELAY_H
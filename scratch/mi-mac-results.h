@@ -0,0 +1,821 @@
+#ifndef MI_MAC_RESULTS_H
+#define MI_MAC_RESULTS_H
+
+// Append-only columnar store for run results.
+//
+// A results file starts with its schema (name and type of every column)
+// and continues with chunks of rows.  Within a chunk every column is stored
+// on its own, so a query reads only the columns it uses:
+//
+//   file   "MIRES001", uint32 columns, then per column uint8 type,
+//          uint8 name length, name
+//   chunk  "MICK", uint32 rows, uint64 bytes that follow, then per column
+//          uint8 encoding, 3 pad bytes, uint32 data bytes, double min,
+//          double max, then the data of each column in schema order
+//
+// A column of one chunk holding a single value is stored once (CONSTANT).
+// One that holds few runs of equal values, like the configuration columns
+// of a sweep whose replications are appended together, is stored as uint32
+// runs and (value, uint32 length) pairs (RLE).  Others are PLAIN arrays of
+// the column type.  String columns start with a per-chunk dictionary
+// (uint32 entries, each uint16 length and text), then store uint16 codes
+// the same way; a CONSTANT one has a single entry and no codes.  min and
+// max bound a numeric column within the chunk, so a filter can skip chunks
+// without reading them.  Numbers are buffered and read back as double, so
+// u64 values are exact up to 2^53.
+//
+// Writers buffer rows and append each chunk with one write() under an
+// exclusive flock(), so concurrent runs can share a file.  A chunk cut
+// short by a crash, or with an unknown encoding, ends the readable part of
+// the file.  Under the lock and before every append, a writer checks the
+// chunks added since its last append and truncates such a tail, so its own
+// chunks never follow a broken one.  Small appends
+// make small chunks; MiCompactResults() rewrites a file into full ones.
+
+#include "mi-mac-scenario.h"
+
+#include "ns3/core-module.h"
+
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <string>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+enum MiColumnType : uint8_t {
+    MI_COLUMN_U32 = 0,
+    MI_COLUMN_U64 = 1,
+    MI_COLUMN_F64 = 2,
+    MI_COLUMN_STRING = 3
+};
+
+inline const char* MiColumnTypeNames[] = {"u32", "u64", "f64", "string"};
+
+enum MiColumnEncoding : uint8_t {
+    MI_ENCODING_PLAIN = 0,
+    MI_ENCODING_CONSTANT = 1,
+    MI_ENCODING_RLE = 2
+};
+
+inline const char* MiEncodingNames[] = {"plain", "constant", "rle"};
+
+struct MiResultColumn {
+    std::string name;
+    MiColumnType type;
+
+    bool operator==(const MiResultColumn& o) const { return name == o.name && type == o.type; }
+};
+
+// Per chunk and column, as stored in the chunk directory.
+struct MiResultColumnChunk {
+    uint8_t encoding;
+    uint8_t pad[3];
+    uint32_t bytes;
+    double min;  // NaN for string columns
+    double max;
+};
+
+static_assert(sizeof(MiResultColumnChunk) == 24, "MiResultColumnChunk is written to disk as is");
+
+constexpr char MI_RESULTS_MAGIC[8] = {'M', 'I', 'R', 'E', 'S', '0', '0', '1'};
+constexpr char MI_CHUNK_MAGIC[4] = {'M', 'I', 'C', 'K'};
+constexpr size_t MI_CHUNK_HEADER_BYTES = sizeof(MI_CHUNK_MAGIC) + sizeof(uint32_t) + sizeof(uint64_t);
+
+inline uint32_t MiColumnWidth(MiColumnType type) {
+    return type == MI_COLUMN_U32 ? 4 : 8;
+}
+
+// Reads exactly size bytes at offset; false at the end of the file.
+inline bool MiReadAt(int fd, void* data, size_t size, uint64_t offset) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = pread(fd, p, size, offset);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+// Sequential reader of a results file, one chunk at a time.
+class MiResultReader {
+  public:
+    MiResultReader() = default;
+    ~MiResultReader() { Close(); }
+    MiResultReader(const MiResultReader&) = delete;
+    MiResultReader& operator=(const MiResultReader&) = delete;
+
+    // Aborts if path is not a results file.
+    void Open(const std::string& path);
+    void Close();
+
+    const std::vector<MiResultColumn>& GetColumns() const { return m_columns; }
+    // Index of a column, or GetColumns().size() if there is none of that name.
+    uint32_t FindColumn(const std::string& name) const;
+
+    // Moves to the next chunk; false after the last complete one.
+    bool NextChunk();
+    uint32_t GetChunkRows() const { return m_chunkRows; }
+    const MiResultColumnChunk& GetChunkColumn(uint32_t column) const { return m_directory[column]; }
+    // Decodes one column of the current chunk.
+    void ReadNumbers(uint32_t column, std::vector<double>& values);
+    void ReadStrings(uint32_t column, std::vector<uint16_t>& codes, std::vector<std::string>& dictionary);
+    // Raw stored data of one column of the current chunk.
+    void ReadRaw(uint32_t column, std::vector<char>& data);
+
+    uint64_t GetBytesRead() const { return m_bytesRead; }
+    // The file ends in a partly written or corrupt chunk.
+    bool IsTruncated() const { return m_truncated; }
+    // Offset just past the last complete chunk read so far.
+    uint64_t GetValidEnd() const { return m_next; }
+    // Continues at offset, which must start a chunk, e.g. an earlier GetValidEnd().
+    void Seek(uint64_t offset) {
+        m_next = offset;
+        m_truncated = false;
+        m_chunkRows = 0;
+    }
+
+  private:
+    // Calls set(row, element) for every row of a PLAIN, CONSTANT or RLE
+    // column stored in [p, end) with elements of width bytes.
+    template <typename F>
+    void Expand(uint32_t column, const char* p, const char* end, uint32_t width, F set);
+
+    int m_fd = -1;
+    std::string m_path;
+    uint64_t m_size = 0;
+    uint64_t m_next = 0;  // offset of the next chunk
+    std::vector<MiResultColumn> m_columns;
+    uint32_t m_chunkRows = 0;
+    std::vector<MiResultColumnChunk> m_directory;
+    std::vector<uint64_t> m_offset;  // per column data offset in the current chunk
+    std::vector<char> m_buffer;
+    uint64_t m_bytesRead = 0;
+    bool m_truncated = false;
+};
+
+// Buffers rows column by column and appends them to a file in chunks.
+class MiResultWriter {
+  public:
+    static constexpr uint32_t DEFAULT_CHUNK_ROWS = 65536;
+    // uint16 string codes cover every distinct value of a chunk this long.
+    static constexpr uint32_t MAX_CHUNK_ROWS = 65536;
+
+    MiResultWriter() = default;
+    ~MiResultWriter() { Close(); }
+    MiResultWriter(const MiResultWriter&) = delete;
+    MiResultWriter& operator=(const MiResultWriter&) = delete;
+
+    // Creates path with the given columns, or appends to it if it already
+    // has exactly these columns (aborts otherwise).
+    void Open(const std::string& path, const std::vector<MiResultColumn>& columns,
+              uint32_t chunkRows = DEFAULT_CHUNK_ROWS);
+    bool IsOpen() const { return m_fd >= 0; }
+    // Writes the buffered rows and closes the file.
+    void Close();
+
+    const std::vector<MiResultColumn>& GetColumns() const { return m_columns; }
+    // Column values of the row being built; columns left unset are 0 or "".
+    void Set(uint32_t column, double value);
+    void Set(uint32_t column, uint64_t value);
+    void Set(uint32_t column, const std::string& value);
+    void EndRow();
+    // Appends the buffered rows as one chunk.
+    void Flush();
+
+    uint64_t GetRowsWritten() const { return m_rowsWritten; }
+
+  private:
+    struct Buffer {
+        std::vector<double> numbers;
+        std::vector<uint16_t> codes;
+        std::vector<std::string> dictionary;
+        std::unordered_map<std::string, uint16_t> codeOf;
+    };
+    void Encode(const MiResultColumn& column, const Buffer& buffer, std::vector<char>& out);
+    // With the lock held: checks the chunks other writers appended since
+    // m_validEnd and truncates a broken tail.
+    void RepairTail();
+
+    int m_fd = -1;
+    std::string m_path;
+    std::vector<MiResultColumn> m_columns;
+    uint32_t m_chunkRows = DEFAULT_CHUNK_ROWS;
+    std::vector<Buffer> m_buffers;
+    std::vector<uint8_t> m_set;  // per column, in the current row
+    uint32_t m_rows = 0;         // buffered
+    uint64_t m_rowsWritten = 0;
+    uint64_t m_validEnd = 0;  // end of the complete chunks when this writer last looked
+    std::vector<char> m_out;
+};
+
+// Rewrites a results file into chunks of chunkRows (same rows, same order).
+inline uint64_t MiCompactResults(const std::string& path, const std::string& outPath,
+                                 uint32_t chunkRows = MiResultWriter::DEFAULT_CHUNK_ROWS);
+
+// ---------------------------------------------------------------------------
+// MiResultReader
+// ---------------------------------------------------------------------------
+
+inline void MiResultReader::Open(const std::string& path) {
+    Close();
+    m_path = path;
+    m_fd = open(path.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(m_fd < 0, "cannot open results file " << path);
+    struct stat info;
+    fstat(m_fd, &info);
+    m_size = info.st_size;
+
+    char magic[sizeof(MI_RESULTS_MAGIC)];
+    uint32_t count = 0;
+    uint64_t offset = 0;
+    bool ok = MiReadAt(m_fd, magic, sizeof(magic), offset) &&
+              std::memcmp(magic, MI_RESULTS_MAGIC, sizeof(magic)) == 0 &&
+              MiReadAt(m_fd, &count, sizeof(count), offset + sizeof(magic));
+    offset += sizeof(magic) + sizeof(count);
+    m_columns.clear();
+    for (uint32_t c = 0; ok && c < count; c++) {
+        uint8_t type = 0;
+        uint8_t length = 0;
+        ok = MiReadAt(m_fd, &type, 1, offset) && MiReadAt(m_fd, &length, 1, offset + 1) && type <= MI_COLUMN_STRING;
+        std::string name(length, '\0');
+        ok = ok && MiReadAt(m_fd, name.data(), length, offset + 2);
+        offset += 2 + length;
+        m_columns.push_back({name, static_cast<MiColumnType>(type)});
+    }
+    NS_ABORT_MSG_IF(!ok, path << " is not a results file");
+    m_next = offset;
+    m_bytesRead = offset;
+    m_truncated = false;
+    m_chunkRows = 0;
+}
+
+inline void MiResultReader::Close() {
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+inline uint32_t MiResultReader::FindColumn(const std::string& name) const {
+    for (uint32_t c = 0; c < m_columns.size(); c++) {
+        if (m_columns[c].name == name) {
+            return c;
+        }
+    }
+    return m_columns.size();
+}
+
+inline bool MiResultReader::NextChunk() {
+    m_chunkRows = 0;
+    if (m_next >= m_size) {
+        return false;
+    }
+    char magic[sizeof(MI_CHUNK_MAGIC)];
+    uint32_t rows = 0;
+    uint64_t bytes = 0;
+    size_t directoryBytes = m_columns.size() * sizeof(MiResultColumnChunk);
+    bool ok = MiReadAt(m_fd, magic, sizeof(magic), m_next) && std::memcmp(magic, MI_CHUNK_MAGIC, sizeof(magic)) == 0 &&
+              MiReadAt(m_fd, &rows, sizeof(rows), m_next + sizeof(magic)) &&
+              MiReadAt(m_fd, &bytes, sizeof(bytes), m_next + sizeof(magic) + sizeof(rows)) &&
+              bytes >= directoryBytes && m_next + MI_CHUNK_HEADER_BYTES + bytes <= m_size;
+    m_directory.resize(m_columns.size());
+    ok = ok && MiReadAt(m_fd, m_directory.data(), directoryBytes, m_next + MI_CHUNK_HEADER_BYTES);
+    for (uint32_t c = 0; ok && c < m_columns.size(); c++) {
+        ok = m_directory[c].encoding <= MI_ENCODING_RLE;
+    }
+    if (!ok) {
+        m_truncated = true;
+        return false;
+    }
+    m_offset.resize(m_columns.size());
+    uint64_t offset = m_next + MI_CHUNK_HEADER_BYTES + directoryBytes;
+    for (uint32_t c = 0; c < m_columns.size(); c++) {
+        m_offset[c] = offset;
+        offset += m_directory[c].bytes;
+    }
+    if (offset != m_next + MI_CHUNK_HEADER_BYTES + bytes) {
+        m_truncated = true;
+        return false;
+    }
+    m_bytesRead += MI_CHUNK_HEADER_BYTES + directoryBytes;
+    m_next = offset;
+    m_chunkRows = rows;
+    return true;
+}
+
+inline void MiResultReader::ReadRaw(uint32_t column, std::vector<char>& data) {
+    data.resize(m_directory[column].bytes);
+    NS_ABORT_MSG_IF(!MiReadAt(m_fd, data.data(), data.size(), m_offset[column]), "cannot read " << m_path);
+    m_bytesRead += data.size();
+}
+
+template <typename F>
+void MiResultReader::Expand(uint32_t column, const char* p, const char* end, uint32_t width, F set) {
+    auto check = [&](size_t size) {
+        NS_ABORT_MSG_IF(p + size > end, m_path << ": bad column " << m_columns[column].name);
+    };
+    uint8_t encoding = m_directory[column].encoding;
+    if (encoding == MI_ENCODING_CONSTANT) {
+        check(width);
+        for (uint32_t k = 0; k < m_chunkRows; k++) {
+            set(k, p);
+        }
+    } else if (encoding == MI_ENCODING_RLE) {
+        uint32_t runs;
+        check(sizeof(runs));
+        std::memcpy(&runs, p, sizeof(runs));
+        p += sizeof(runs);
+        uint32_t k = 0;
+        for (uint32_t r = 0; r < runs; r++) {
+            uint32_t length;
+            check(width + sizeof(length));
+            std::memcpy(&length, p + width, sizeof(length));
+            NS_ABORT_MSG_IF(length > m_chunkRows - k, m_path << ": bad column " << m_columns[column].name);
+            for (uint32_t end = k + length; k < end; k++) {
+                set(k, p);
+            }
+            p += width + sizeof(length);
+        }
+        NS_ABORT_MSG_IF(k != m_chunkRows, m_path << ": bad column " << m_columns[column].name);
+    } else {
+        check(size_t(m_chunkRows) * width);
+        for (uint32_t k = 0; k < m_chunkRows; k++) {
+            set(k, p + size_t(k) * width);
+        }
+    }
+}
+
+inline void MiResultReader::ReadNumbers(uint32_t column, std::vector<double>& values) {
+    MiColumnType type = m_columns[column].type;
+    NS_ABORT_MSG_IF(type == MI_COLUMN_STRING, "column " << m_columns[column].name << " is not numeric");
+    ReadRaw(column, m_buffer);
+    values.resize(m_chunkRows);
+    const char* begin = m_buffer.data();
+    const char* end = begin + m_buffer.size();
+    if (type == MI_COLUMN_U32) {
+        Expand(column, begin, end, 4, [&values](uint32_t k, const char* p) {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            values[k] = v;
+        });
+    } else if (type == MI_COLUMN_U64) {
+        Expand(column, begin, end, 8, [&values](uint32_t k, const char* p) {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            values[k] = static_cast<double>(v);
+        });
+    } else {
+        Expand(column, begin, end, 8, [&values](uint32_t k, const char* p) { std::memcpy(&values[k], p, 8); });
+    }
+}
+
+inline void MiResultReader::ReadStrings(uint32_t column, std::vector<uint16_t>& codes,
+                                        std::vector<std::string>& dictionary) {
+    NS_ABORT_MSG_IF(m_columns[column].type != MI_COLUMN_STRING,
+                    "column " << m_columns[column].name << " is not a string");
+    ReadRaw(column, m_buffer);
+    const char* p = m_buffer.data();
+    const char* end = p + m_buffer.size();
+    auto take = [&](void* value, size_t size) {
+        NS_ABORT_MSG_IF(p + size > end, m_path << ": bad column " << m_columns[column].name);
+        std::memcpy(value, p, size);
+        p += size;
+    };
+    uint32_t entries;
+    take(&entries, sizeof(entries));
+    dictionary.resize(entries);
+    for (std::string& text : dictionary) {
+        uint16_t length;
+        take(&length, sizeof(length));
+        text.resize(length);
+        take(text.data(), length);
+    }
+    codes.resize(m_chunkRows);
+    if (m_directory[column].encoding == MI_ENCODING_CONSTANT) {
+        // The one dictionary entry is the value.
+        NS_ABORT_MSG_IF(entries != 1, m_path << ": bad column " << m_columns[column].name);
+        std::fill(codes.begin(), codes.end(), 0);
+        return;
+    }
+    Expand(column, p, end, sizeof(uint16_t), [&](uint32_t k, const char* q) {
+        std::memcpy(&codes[k], q, sizeof(uint16_t));
+        NS_ABORT_MSG_IF(codes[k] >= entries, m_path << ": bad column " << m_columns[column].name);
+    });
+}
+
+// ---------------------------------------------------------------------------
+// MiResultWriter
+// ---------------------------------------------------------------------------
+
+inline void MiResultWriter::Open(const std::string& path, const std::vector<MiResultColumn>& columns,
+                                 uint32_t chunkRows) {
+    Close();
+    NS_ABORT_MSG_IF(columns.empty(), "a results file needs at least one column");
+    m_path = path;
+    m_columns = columns;
+    m_chunkRows = std::clamp(chunkRows, 1u, MAX_CHUNK_ROWS);
+    m_buffers.assign(columns.size(), Buffer());
+    m_set.assign(columns.size(), 0);
+    m_rows = 0;
+    m_rowsWritten = 0;
+
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    NS_ABORT_MSG_IF(m_fd < 0, "cannot open results file " << path);
+    flock(m_fd, LOCK_EX);
+    struct stat info;
+    fstat(m_fd, &info);
+    if (info.st_size == 0) {
+        std::vector<char> header(MI_RESULTS_MAGIC, MI_RESULTS_MAGIC + sizeof(MI_RESULTS_MAGIC));
+        uint32_t count = columns.size();
+        header.insert(header.end(), reinterpret_cast<const char*>(&count),
+                      reinterpret_cast<const char*>(&count) + sizeof(count));
+        for (const MiResultColumn& column : columns) {
+            NS_ABORT_MSG_IF(column.name.empty() || column.name.size() > 255, "bad column name '" << column.name << "'");
+            header.push_back(static_cast<char>(column.type));
+            header.push_back(static_cast<char>(column.name.size()));
+            header.insert(header.end(), column.name.begin(), column.name.end());
+        }
+        NS_ABORT_MSG_IF(write(m_fd, header.data(), header.size()) != static_cast<ssize_t>(header.size()),
+                        "cannot write results file " << path);
+        m_validEnd = header.size();
+    } else {
+        MiResultReader reader;
+        reader.Open(path);
+        NS_ABORT_MSG_IF(reader.GetColumns() != columns, path << " holds results with other columns");
+        m_validEnd = 0;
+        RepairTail();
+    }
+    flock(m_fd, LOCK_UN);
+}
+
+inline void MiResultWriter::RepairTail() {
+    struct stat info;
+    fstat(m_fd, &info);
+    if (static_cast<uint64_t>(info.st_size) == m_validEnd) {
+        return;
+    }
+    MiResultReader reader;
+    reader.Open(m_path);
+    if (m_validEnd > 0 && m_validEnd < static_cast<uint64_t>(info.st_size)) {
+        reader.Seek(m_validEnd);
+    }
+    while (reader.NextChunk()) {
+    }
+    if (reader.IsTruncated()) {
+        NS_ABORT_MSG_IF(ftruncate(m_fd, reader.GetValidEnd()) != 0, "cannot repair results file " << m_path);
+    }
+    m_validEnd = reader.GetValidEnd();
+}
+
+inline void MiResultWriter::Close() {
+    if (m_fd < 0) {
+        return;
+    }
+    Flush();
+    close(m_fd);
+    m_fd = -1;
+}
+
+inline void MiResultWriter::Set(uint32_t column, double value) {
+    NS_ABORT_MSG_IF(m_set[column], "column " << m_columns[column].name << " set twice in one row");
+    NS_ABORT_MSG_IF(m_columns[column].type == MI_COLUMN_STRING, "column " << m_columns[column].name
+                                                                         << " is not numeric");
+    // Encode() casts integer columns from double, which must stay in range.
+    if (m_columns[column].type == MI_COLUMN_U32 || m_columns[column].type == MI_COLUMN_U64) {
+        double limit = m_columns[column].type == MI_COLUMN_U32 ? 4294967296.0 : 18446744073709551616.0;
+        NS_ABORT_MSG_IF(!(value >= 0.0 && value < limit),  // also rejects NaN
+                        "value " << value << " out of range for " << MiColumnTypeNames[m_columns[column].type]
+                                 << " column " << m_columns[column].name);
+    }
+    m_buffers[column].numbers.push_back(value);
+    m_set[column] = 1;
+}
+
+inline void MiResultWriter::Set(uint32_t column, uint64_t value) {
+    NS_ABORT_MSG_IF(m_columns[column].type == MI_COLUMN_U32 && value > UINT32_MAX,
+                    "column " << m_columns[column].name << " is u32");
+    Set(column, static_cast<double>(value));
+}
+
+inline void MiResultWriter::Set(uint32_t column, const std::string& value) {
+    NS_ABORT_MSG_IF(m_set[column], "column " << m_columns[column].name << " set twice in one row");
+    NS_ABORT_MSG_IF(m_columns[column].type != MI_COLUMN_STRING, "column " << m_columns[column].name
+                                                                         << " is not a string");
+    NS_ABORT_MSG_IF(value.size() > UINT16_MAX, "string too long for column " << m_columns[column].name);
+    Buffer& buffer = m_buffers[column];
+    auto found = buffer.codeOf.find(value);
+    if (found == buffer.codeOf.end()) {
+        found = buffer.codeOf.emplace(value, buffer.dictionary.size()).first;
+        buffer.dictionary.push_back(value);
+    }
+    buffer.codes.push_back(found->second);
+    m_set[column] = 1;
+}
+
+inline void MiResultWriter::EndRow() {
+    for (uint32_t c = 0; c < m_columns.size(); c++) {
+        if (!m_set[c]) {
+            if (m_columns[c].type == MI_COLUMN_STRING) {
+                Set(c, std::string());
+            } else {
+                Set(c, 0.0);
+            }
+        }
+        m_set[c] = 0;
+    }
+    if (++m_rows >= m_chunkRows) {
+        Flush();
+    }
+}
+
+inline void MiResultWriter::Encode(const MiResultColumn& column, const Buffer& buffer, std::vector<char>& out) {
+    auto put = [&out](const void* data, size_t size) {
+        out.insert(out.end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+    };
+    // Rows as stored elements: the value, or the dictionary code.
+    uint32_t width = column.type == MI_COLUMN_STRING ? sizeof(uint16_t) : MiColumnWidth(column.type);
+    auto element = [&](uint32_t k, char* e) {
+        if (column.type == MI_COLUMN_STRING) {
+            std::memcpy(e, &buffer.codes[k], sizeof(uint16_t));
+        } else if (column.type == MI_COLUMN_U32) {
+            uint32_t v = static_cast<uint32_t>(buffer.numbers[k]);
+            std::memcpy(e, &v, sizeof(v));
+        } else if (column.type == MI_COLUMN_U64) {
+            uint64_t v = static_cast<uint64_t>(buffer.numbers[k]);
+            std::memcpy(e, &v, sizeof(v));
+        } else {
+            std::memcpy(e, &buffer.numbers[k], sizeof(double));
+        }
+    };
+    auto same = [&](uint32_t a, uint32_t b) {
+        return column.type == MI_COLUMN_STRING ? buffer.codes[a] == buffer.codes[b]
+                                               : buffer.numbers[a] == buffer.numbers[b];
+    };
+    uint32_t runs = 1;
+    for (uint32_t k = 1; k < m_rows; k++) {
+        runs += !same(k - 1, k);
+    }
+
+    MiResultColumnChunk entry = {};
+    entry.min = std::numeric_limits<double>::quiet_NaN();
+    entry.max = entry.min;
+    size_t start = out.size();
+    if (column.type == MI_COLUMN_STRING) {
+        uint32_t entries = buffer.dictionary.size();
+        put(&entries, sizeof(entries));
+        for (const std::string& text : buffer.dictionary) {
+            uint16_t length = text.size();
+            put(&length, sizeof(length));
+            put(text.data(), text.size());
+        }
+    } else {
+        entry.min = *std::min_element(buffer.numbers.begin(), buffer.numbers.end());
+        entry.max = *std::max_element(buffer.numbers.begin(), buffer.numbers.end());
+    }
+    char e[8];
+    if (runs == 1) {
+        entry.encoding = MI_ENCODING_CONSTANT;
+        if (column.type != MI_COLUMN_STRING) {
+            element(0, e);
+            put(e, width);
+        }
+    } else if (size_t(runs) * (width + sizeof(uint32_t)) + sizeof(uint32_t) < size_t(m_rows) * width) {
+        entry.encoding = MI_ENCODING_RLE;
+        put(&runs, sizeof(runs));
+        for (uint32_t k = 0; k < m_rows;) {
+            uint32_t length = 1;
+            while (k + length < m_rows && same(k, k + length)) {
+                length++;
+            }
+            element(k, e);
+            put(e, width);
+            put(&length, sizeof(length));
+            k += length;
+        }
+    } else {
+        entry.encoding = MI_ENCODING_PLAIN;
+        for (uint32_t k = 0; k < m_rows; k++) {
+            element(k, e);
+            put(e, width);
+        }
+    }
+    entry.bytes = out.size() - start;
+    m_out.insert(m_out.end(), reinterpret_cast<const char*>(&entry),
+                 reinterpret_cast<const char*>(&entry) + sizeof(entry));
+}
+
+inline void MiResultWriter::Flush() {
+    if (m_fd < 0 || m_rows == 0) {
+        return;
+    }
+    // Directory into m_out, data into data; then one write of both.
+    std::vector<char> data;
+    m_out.assign(MI_CHUNK_HEADER_BYTES, 0);
+    for (uint32_t c = 0; c < m_columns.size(); c++) {
+        Encode(m_columns[c], m_buffers[c], data);
+    }
+    m_out.insert(m_out.end(), data.begin(), data.end());
+    uint64_t bytes = m_out.size() - MI_CHUNK_HEADER_BYTES;
+    std::memcpy(m_out.data(), MI_CHUNK_MAGIC, sizeof(MI_CHUNK_MAGIC));
+    std::memcpy(m_out.data() + sizeof(MI_CHUNK_MAGIC), &m_rows, sizeof(m_rows));
+    std::memcpy(m_out.data() + sizeof(MI_CHUNK_MAGIC) + sizeof(m_rows), &bytes, sizeof(bytes));
+
+    flock(m_fd, LOCK_EX);
+    RepairTail();
+    ssize_t written = write(m_fd, m_out.data(), m_out.size());
+    if (written == static_cast<ssize_t>(m_out.size())) {
+        m_validEnd += written;
+    }
+    flock(m_fd, LOCK_UN);
+    NS_ABORT_MSG_IF(written != static_cast<ssize_t>(m_out.size()), "cannot write results file " << m_path);
+
+    m_rowsWritten += m_rows;
+    m_rows = 0;
+    for (Buffer& buffer : m_buffers) {
+        buffer = Buffer();
+    }
+}
+
+inline uint64_t MiCompactResults(const std::string& path, const std::string& outPath, uint32_t chunkRows) {
+    NS_ABORT_MSG_IF(path == outPath, "compact into another file");
+    MiResultReader reader;
+    reader.Open(path);
+    unlink(outPath.c_str());
+    MiResultWriter writer;
+    writer.Open(outPath, reader.GetColumns(), chunkRows);
+    const std::vector<MiResultColumn>& columns = reader.GetColumns();
+    std::vector<std::vector<double>> numbers(columns.size());
+    std::vector<std::vector<uint16_t>> codes(columns.size());
+    std::vector<std::vector<std::string>> dictionaries(columns.size());
+    while (reader.NextChunk()) {
+        for (uint32_t c = 0; c < columns.size(); c++) {
+            if (columns[c].type == MI_COLUMN_STRING) {
+                reader.ReadStrings(c, codes[c], dictionaries[c]);
+            } else {
+                reader.ReadNumbers(c, numbers[c]);
+            }
+        }
+        for (uint32_t k = 0; k < reader.GetChunkRows(); k++) {
+            for (uint32_t c = 0; c < columns.size(); c++) {
+                if (columns[c].type == MI_COLUMN_STRING) {
+                    writer.Set(c, dictionaries[c][codes[c][k]]);
+                } else {
+                    writer.Set(c, numbers[c][k]);
+                }
+            }
+            writer.EndRow();
+        }
+    }
+    writer.Close();
+    return writer.GetRowsWritten();
+}
+
+// ---------------------------------------------------------------------------
+// Scenario runs
+// ---------------------------------------------------------------------------
+
+// One scenario run (a sweep replication, a scaling run, ...) as a results
+// row.  Plain data, so sweep workers can hand it back through shared memory.
+struct MiRunRecord {
+    // Configuration
+    bool csma = false;
+    uint32_t nodes = 0;
+    double density = 0.0;       // nodes/m²
+    double interval = 0.0;      // s, mean between readings per node
+    uint32_t payload = 0;       // bytes
+    double simTime = 0.0;       // s
+    double wakeInterval = 0.0;  // s, 0 for an always-on receiver
+    uint32_t seed = 0;
+    uint32_t run = 0;
+    // Outcome
+    double delivery = 0.0;
+    double throughput = 0.0;  // delivered payload bit/s
+    uint64_t collisions = 0;
+    uint64_t dataSent = 0;
+    uint64_t dataReceived = 0;
+    double energy = 0.0;             // µJ, all nodes
+    double nodeEnergyMean = 0.0;     // µJ per node
+    double nodeEnergyMax = 0.0;      // µJ, hungriest node
+    double minLifetimeDays = 0.0;
+    double meanLifetimeDays = 0.0;
+    double accessDelayMs = 0.0;      // mean, reading ready to DATA done
+    double latencyP50Ms = 0.0;       // REV -> DATA at the source, with MiMacStats
+    double latencyP95Ms = 0.0;
+    double latencyP99Ms = 0.0;
+    uint64_t events = 0;
+    double wallSec = 0.0;
+
+    static std::vector<MiResultColumn> Columns();
+    // Appends the record as one row; program names what produced it.
+    void Append(MiResultWriter& writer, const std::string& program) const;
+};
+
+inline std::vector<MiResultColumn> MiRunRecord::Columns() {
+    return {{"program", MI_COLUMN_STRING},
+            {"mac", MI_COLUMN_STRING},
+            {"nodes", MI_COLUMN_U32},
+            {"density", MI_COLUMN_F64},
+            {"interval_s", MI_COLUMN_F64},
+            {"payload_B", MI_COLUMN_U32},
+            {"sim_time_s", MI_COLUMN_F64},
+            {"wake_interval_s", MI_COLUMN_F64},
+            {"seed", MI_COLUMN_U32},
+            {"run", MI_COLUMN_U32},
+            {"delivery", MI_COLUMN_F64},
+            {"throughput_bps", MI_COLUMN_F64},
+            {"collisions", MI_COLUMN_U64},
+            {"data_sent", MI_COLUMN_U64},
+            {"data_received", MI_COLUMN_U64},
+            {"energy_uJ", MI_COLUMN_F64},
+            {"node_energy_mean_uJ", MI_COLUMN_F64},
+            {"node_energy_max_uJ", MI_COLUMN_F64},
+            {"min_lifetime_days", MI_COLUMN_F64},
+            {"mean_lifetime_days", MI_COLUMN_F64},
+            {"access_delay_ms", MI_COLUMN_F64},
+            {"latency_p50_ms", MI_COLUMN_F64},
+            {"latency_p95_ms", MI_COLUMN_F64},
+            {"latency_p99_ms", MI_COLUMN_F64},
+            {"events", MI_COLUMN_U64},
+            {"wall_s", MI_COLUMN_F64}};
+}
+
+inline void MiRunRecord::Append(MiResultWriter& writer, const std::string& program) const {
+    uint32_t c = 0;
+    writer.Set(c++, program);
+    writer.Set(c++, std::string(csma ? "csma" : "mi"));
+    writer.Set(c++, uint64_t(nodes));
+    writer.Set(c++, density);
+    writer.Set(c++, interval);
+    writer.Set(c++, uint64_t(payload));
+    writer.Set(c++, simTime);
+    writer.Set(c++, wakeInterval);
+    writer.Set(c++, uint64_t(seed));
+    writer.Set(c++, uint64_t(run));
+    writer.Set(c++, delivery);
+    writer.Set(c++, throughput);
+    writer.Set(c++, collisions);
+    writer.Set(c++, dataSent);
+    writer.Set(c++, dataReceived);
+    writer.Set(c++, energy);
+    writer.Set(c++, nodeEnergyMean);
+    writer.Set(c++, nodeEnergyMax);
+    writer.Set(c++, minLifetimeDays);
+    writer.Set(c++, meanLifetimeDays);
+    writer.Set(c++, accessDelayMs);
+    writer.Set(c++, latencyP50Ms);
+    writer.Set(c++, latencyP95Ms);
+    writer.Set(c++, latencyP99Ms);
+    writer.Set(c++, events);
+    writer.Set(c++, wallSec);
+    writer.EndRow();
+}
+
+// Record of a RunMiScenario() run under the current RNG seed and run.
+// Latency percentiles need the MiMacStats the run was given.
+inline MiRunRecord MiMakeRunRecord(const MiScenarioConfig& config, const MiScenarioResult& result,
+                                   const MiMacStats* stats = nullptr) {
+    MiRunRecord record;
+    record.csma = config.csma;
+    record.nodes = result.nodes;
+    record.density = config.topology.empty() ? 1.0 / (config.spacing * config.spacing) : 0.0;
+    record.interval = config.meanInterval;
+    record.payload = config.payloadSize;
+    record.simTime = config.simTime;
+    record.wakeInterval = config.csma ? 0.0 : config.wakeInterval;
+    record.seed = RngSeedManager::GetSeed();
+    record.run = RngSeedManager::GetRun();
+    record.delivery = result.DeliveryRatio();
+    record.throughput = result.counters.dataReceived * config.payloadSize * 8.0 / config.simTime;
+    record.collisions = result.counters.collisions;
+    record.dataSent = result.counters.dataSent;
+    record.dataReceived = result.counters.dataReceived;
+    record.energy = result.energy.totalEnergy;
+    record.nodeEnergyMean = result.nodes == 0 ? 0.0 : result.energy.totalEnergy / result.nodes;
+    record.nodeEnergyMax = result.maxNodeEnergy;
+    record.minLifetimeDays = result.shortestLifetime.GetSeconds() / 86400.0;
+    record.meanLifetimeDays = result.meanLifetime.GetSeconds() / 86400.0;
+    record.accessDelayMs = result.MeanAccessDelay() * 1e3;
+    if (stats != nullptr) {
+        record.latencyP50Ms = stats->GetRevToData().Quantile(0.50) * 1e3;
+        record.latencyP95Ms = stats->GetRevToData().Quantile(0.95) * 1e3;
+        record.latencyP99Ms = stats->GetRevToData().Quantile(0.99) * 1e3;
+    }
+    record.events = result.events;
+    record.wallSec = result.wallSec;
+    return record;
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_RESULTS_H
@@ -0,0 +1,132 @@
+// Scaling run for the event-driven MI MAC: many nodes on a jittered lattice,
+// each sending periodic sensor readings to a lattice neighbour.  Reports the
+// simulator throughput in events per second and checks it against a target
+// so large deployment runs can be sized up front.  --topology replaces the
+// lattice with a node file (see mi-mac-topology.h).  --stats adds per-state
+// dwell times, handshake latency and coil choices (see mi-mac-stats.h).
+// --results appends the run to a columnar results file (see mi-mac-results.h).
+//
+//   ./ns3 run "scratch/mi-mac-scale --nodes=10000 --simTime=60 --targetEventsPerSec=500000"
+//   ./ns3 run "scratch/mi-mac-scale --topology=nodes.txt --simTime=60"
+//   ./ns3 run "scratch/mi-mac-scale --nodes=1000 --stats --statsInterval=10 --statsFile=stats.csv"
+
+#include "mi-mac-results.h"
+#include "mi-mac-scenario.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+using namespace ns3;
+
+int main(int argc, char *argv[]) {
+    MiScenarioConfig config;
+    config.nodes = 10000;
+    uint32_t seed = 1;
+    uint32_t run = 1;
+    double targetEventsPerSec = 500000.0;
+    uint32_t planNodes = 10000;
+    double planHours = 24.0;
+    std::string traceFormat = "none";
+    std::string traceFile = "mi-mac-scale.trace";
+    bool stats = false;
+    double statsInterval = 0.0;
+    std::string statsFile = "mi-mac-scale-stats.csv";
+    std::string resultsFile;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nodes", "Number of MI nodes", config.nodes);
+    cmd.AddValue("spacing", "Lattice spacing between nodes (m)", config.spacing);
+    cmd.AddValue("range", "Coupling evaluation radius (m)", config.range);
+    cmd.AddValue("randomOrientation", "Give every node a random coil orientation", config.randomOrientation);
+    cmd.AddValue("simTime", "Simulated time (s)", config.simTime);
+    cmd.AddValue("interval", "Mean time between sensor readings per node (s)", config.meanInterval);
+    cmd.AddValue("payload", "DATA payload size (1-16 bytes)", config.payloadSize);
+    cmd.AddValue("aggregation", "Readings sent per DATA burst", config.aggregationCount);
+    cmd.AddValue("aggregationDeadline", "Longest a buffered reading waits for its burst (s, 0 for none)",
+                 config.aggregationDeadline);
+    cmd.AddValue("topology", "Node file replacing the lattice (see mi-mac-topology.h)", config.topology);
+    cmd.AddValue("topologyCache", "Read and write the topology file's binary cache", config.topologyCache);
+    cmd.AddValue("seed", "RNG seed", seed);
+    cmd.AddValue("run", "RNG run number", run);
+    cmd.AddValue("targetEventsPerSec", "Required simulator throughput (events per wall-clock second)",
+                 targetEventsPerSec);
+    cmd.AddValue("planNodes", "Node count of the deployment to size", planNodes);
+    cmd.AddValue("planHours", "Simulated hours of the deployment to size", planHours);
+    cmd.AddValue("traceFormat", "Structured trace output: none, csv or binary", traceFormat);
+    cmd.AddValue("traceFile", "Trace output file", traceFile);
+    cmd.AddValue("stats", "Collect and print per-state and handshake statistics", stats);
+    cmd.AddValue("statsInterval", "Per-node statistics snapshot period (s, 0 for none)", statsInterval);
+    cmd.AddValue("statsFile", "Per-node statistics snapshot file", statsFile);
+    cmd.AddValue("results", "Append the run to this columnar results file", resultsFile);
+    cmd.Parse(argc, argv);
+
+    RngSeedManager::SetSeed(seed);
+    RngSeedManager::SetRun(run);
+
+    MiTraceSink trace(traceFile, MiTraceSink::ParseFormat(traceFormat));
+    MiMacStats macStats(Seconds(statsInterval), statsFile);
+    MiScenarioResult result = RunMiScenario(config, &trace, stats ? &macStats : nullptr);
+    trace.Close();
+    const MiMacCounters& total = result.counters;
+    double eventsPerSec = result.events / result.wallSec;
+
+    // Events grow with node count x simulated time at a fixed density and load.
+    double eventsPerNodeSecond = result.events / (static_cast<double>(result.nodes) * config.simTime);
+    double planEvents = eventsPerNodeSecond * planNodes * planHours * 3600.0;
+    double planWallSec = planEvents / eventsPerSec;
+
+    std::cout << "\n" << std::string(70, '=') << std::endl;
+    std::cout << "   MI MAC SCALING RUN" << std::endl;
+    std::cout << std::string(70, '=') << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n  Nodes:                   " << result.nodes << std::endl;
+    if (!config.topology.empty()) {
+        std::cout << "  Topology:                " << config.topology << " (" << result.topologyLoadSec << " s, "
+                  << (result.topologyFromCache ? "binary cache" : "parsed") << ")" << std::endl;
+    }
+    std::cout << "  Simulated time:          " << config.simTime << " s" << std::endl;
+    std::cout << "  Setup time:              " << result.setupSec << " s" << std::endl;
+    std::cout << "  Run time:                " << result.wallSec << " s" << std::endl;
+    std::cout << "  Events executed:         " << result.events << std::endl;
+    std::cout << "  Events per second:       " << eventsPerSec << std::endl;
+    std::cout << "  Sim seconds per wall s:  " << config.simTime / result.wallSec << std::endl;
+    std::cout << "\n  Readings queued:         " << total.dataEnqueued << std::endl;
+    std::cout << "  DATA sent / delivered:   " << total.dataSent << " / " << total.dataReceived << std::endl;
+    std::cout << "  DATA dropped:            " << total.dataDropped << std::endl;
+    std::cout << "  DATA bursts:             " << total.bursts << std::endl;
+    std::cout << "  ACK timeouts:            " << total.ackTimeouts << std::endl;
+    std::cout << "  DATA timeouts / retries: " << total.dataTimeouts << " / " << total.retries << std::endl;
+    std::cout << "  Collisions:              " << total.collisions << std::endl;
+    std::cout << "  REV rounds swept/cached: " << total.revSweeps << " / " << total.revSingles << " ("
+              << total.cacheFallbacks << " cache fallbacks)" << std::endl;
+    std::cout << "  State transitions:       " << total.stateTransitions << std::endl;
+    std::cout << "  Total energy:            " << result.energy.totalEnergy << " µJ" << std::endl;
+    std::cout << "  Shortest node lifetime:  " << result.shortestLifetime.GetSeconds() / 86400.0 << " days"
+              << std::endl;
+    if (!trace.IsSilent()) {
+        std::cout << "  Trace records:           " << trace.GetRecordCount() << " -> " << traceFile << " ("
+                  << trace.GetStallCount() << " writer stalls)" << std::endl;
+    }
+
+    if (stats) {
+        macStats.Print(std::cout);
+        if (statsInterval > 0.0) {
+            std::cout << "  Per-node snapshots:      every " << statsInterval << " s -> " << statsFile << std::endl;
+        }
+    }
+
+    std::cout << "\n  Scaling target:          " << targetEventsPerSec << " events/s -> "
+              << (eventsPerSec >= targetEventsPerSec ? "MET" : "MISSED") << std::endl;
+    std::cout << "  Events per node-second:  " << eventsPerNodeSecond << std::endl;
+    std::cout << "  Projected " << planNodes << " nodes x " << planHours << " h: " << planEvents << " events, "
+              << planWallSec / 60.0 << " min wall-clock\n" << std::endl;
+
+    if (!resultsFile.empty()) {
+        MiResultWriter writer;
+        writer.Open(resultsFile, MiRunRecord::Columns());
+        MiMakeRunRecord(config, result, stats ? &macStats : nullptr).Append(writer, "scale");
+        std::cout << "  Run appended to " << resultsFile << "\n" << std::endl;
+    }
+
+    return 0;
+}
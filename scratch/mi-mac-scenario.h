@@ -0,0 +1,238 @@
+#ifndef MI_MAC_SCENARIO_H
+#define MI_MAC_SCENARIO_H
+
+// Lattice scenario shared by the scaling run and the parameter sweep: nodes
+// on a jittered square lattice, each sending Poisson sensor readings to a
+// lattice neighbour, over the MI MAC or the CSMA/CA baseline.  With a
+// topology file, placement, orientation and traffic come from the file
+// instead.  With mobility, nodes drift and rotate during the run (see
+// mi-mac-mobility.h).  With a wake interval, idle MI receivers are duty
+// cycled.  RunMiScenario() owns one complete Simulator run.
+
+#include "mi-mac-csma.h"
+#include "mi-mac-energy.h"
+#include "mi-mac-helper.h"
+#include "mi-mac-mobility.h"
+#include "mi-mac-stats.h"
+#include "mi-mac-topology.h"
+#include "mi-mac-trace.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <chrono>
+#include <sstream>
+
+namespace ns3 {
+
+struct MiScenarioConfig {
+    uint32_t nodes = 1000;
+    double spacing = 2.0;        // m
+    double range = 4.0;          // m
+    double simTime = 60.0;       // s
+    double meanInterval = 30.0;  // s between readings per node
+    uint32_t payloadSize = 10;   // bytes
+    bool randomOrientation = true;
+    uint32_t aggregationCount = 1;     // readings per DATA burst
+    double aggregationDeadline = 0.0;  // s, 0 for none
+    bool csma = false;                 // CsmaMacNetDevice instead of MiMacNetDevice
+    std::string topology;              // MiTopology file replacing the lattice, if set
+    bool topologyCache = true;         // read and write the topology's binary cache
+    bool couplingCache = false;        // MiMacChannel CouplingCache
+    bool mobility = false;             // drift and rotate nodes as set in drift
+    MiDriftConfig drift;
+    double wakeInterval = 0.0;         // s, MiMacNetDevice WakeInterval (0: receiver always on)
+    double listenTime = 0.002;         // s, per wake-up
+    double sleepCurrent = 1.0;         // µA, MiEnergyModel SleepCurrent
+};
+
+struct MiScenarioResult {
+    uint32_t nodes = 0;
+    bool topologyFromCache = false;
+    double topologyLoadSec = 0.0;
+    MiMacCounters counters;
+    EnergyMetrics energy;
+    Time shortestLifetime;  // battery lifetime of the node with the highest average current
+    Time meanLifetime;      // battery lifetime averaged over nodes
+    double meanCurrent = 0.0;  // µA, average current over all nodes
+    double maxNodeEnergy = 0.0;  // µJ, node that spent the most
+    double sleepShare = 0.0;   // share of node time with the receiver off
+    uint64_t moves = 0;  // node displacements and rotations applied by the mobility model
+    uint64_t turns = 0;
+    MiLinkTable::Counters coupling;  // with couplingCache
+    uint64_t events = 0;
+    double setupSec = 0.0;
+    double wallSec = 0.0;
+
+    double DeliveryRatio() const {
+        return counters.dataEnqueued == 0 ? 0.0 : static_cast<double>(counters.dataReceived) / counters.dataEnqueued;
+    }
+    // Mean time from a reading being ready to its DATA being done, in s.
+    double MeanAccessDelay() const {
+        return counters.dataSent == 0 ? 0.0 : counters.accessDelay / counters.dataSent;
+    }
+};
+
+// Comma-separated command-line list, as taken by the sweep and the benchmark.
+template <typename T>
+std::vector<T> MiParseList(const std::string& text) {
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            std::stringstream field(item);
+            T value;
+            field >> value;
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+inline void MiScenarioSensorReading(Ptr<NetDevice> device, Address destination,
+                                    Ptr<ExponentialRandomVariable> interval, double meanInterval,
+                                    uint32_t payloadSize) {
+    device->Send(Create<Packet>(payloadSize), destination, 0);
+    Simulator::Schedule(Seconds(interval->GetValue(meanInterval, 0)), &MiScenarioSensorReading, device, destination,
+                        interval, meanInterval, payloadSize);
+}
+
+// Every node reports to its right-hand neighbour (left-hand at the end of
+// a row), which is always within range.  A single node has no neighbour and
+// sends nothing.
+inline void MiScenarioLattice(const MiScenarioConfig& config, const NodeContainer& nodes,
+                              const NetDeviceContainer& devices) {
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(config.nodes))));
+    Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable>();
+    for (uint32_t i = 0; i < config.nodes; i++) {
+        Ptr<MiRadioDevice> device = DynamicCast<MiRadioDevice>(devices.Get(i));
+        double dx = jitter->GetValue(-0.1, 0.1) * config.spacing;
+        double dy = jitter->GetValue(-0.1, 0.1) * config.spacing;
+        device->SetPosition(Vector((i % side) * config.spacing + dx, (i / side) * config.spacing + dy, 0.0));
+        if (config.randomOrientation) {
+            device->SetOrientation(MiOrientation::FromEuler(jitter->GetValue(0, 2 * M_PI),
+                                                            jitter->GetValue(-M_PI / 2, M_PI / 2),
+                                                            jitter->GetValue(0, 2 * M_PI)));
+        }
+    }
+    if (config.nodes < 2) {
+        return;
+    }
+    for (uint32_t i = 0; i < config.nodes; i++) {
+        uint32_t peer = (i % side == side - 1 || i + 1 == config.nodes) ? i - 1 : i + 1;
+        Ptr<ExponentialRandomVariable> interval = CreateObject<ExponentialRandomVariable>();
+        Simulator::ScheduleWithContext(nodes.Get(i)->GetId(), Seconds(interval->GetValue(config.meanInterval, 0)),
+                                       &MiScenarioSensorReading, devices.Get(i), devices.Get(peer)->GetAddress(),
+                                       interval, config.meanInterval, config.payloadSize);
+    }
+}
+
+// Placement, orientation and traffic profile of every node from the file.
+// Only nodes of systemId send, so a distributed run schedules each source
+// on one process.
+inline void MiScenarioTopology(const MiTopology& topology, const NodeContainer& nodes,
+                               const NetDeviceContainer& devices, uint32_t systemId = 0) {
+    for (uint32_t i = 0; i < topology.GetN(); i++) {
+        Ptr<MiRadioDevice> device = DynamicCast<MiRadioDevice>(devices.Get(i));
+        device->SetPosition(Vector(topology.x[i], topology.y[i], topology.z[i]));
+        device->SetOrientation(topology.GetOrientation(i));
+        if (!topology.IsSource(i)) {
+            continue;
+        }
+        // Created on every process so that stream numbers do not depend on
+        // the partition.
+        double mean = topology.interval[i];
+        Ptr<ExponentialRandomVariable> interval = CreateObject<ExponentialRandomVariable>();
+        if (nodes.Get(i)->GetSystemId() != systemId) {
+            continue;
+        }
+        Simulator::ScheduleWithContext(nodes.Get(i)->GetId(), Seconds(interval->GetValue(mean, 0)),
+                                       &MiScenarioSensorReading, devices.Get(i),
+                                       devices.Get(topology.destination[i])->GetAddress(), interval, mean,
+                                       topology.payload[i]);
+    }
+}
+
+// Runs the scenario; trace and stats, if given, are attached to every device.
+inline MiScenarioResult RunMiScenario(const MiScenarioConfig& config, MiTraceSink* trace = nullptr,
+                                      MiMacStats* stats = nullptr) {
+    MiScenarioResult result;
+    auto setupStart = std::chrono::steady_clock::now();
+
+    MiTopology topology;
+    if (!config.topology.empty()) {
+        topology = MiTopology::Load(config.topology, config.topologyCache, &result.topologyFromCache);
+        result.topologyLoadSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+    }
+    result.nodes = config.topology.empty() ? config.nodes : topology.GetN();
+
+    NodeContainer nodes;
+    nodes.Create(result.nodes);
+    MiMacHelper mac;
+    mac.SetChannelAttribute("Range", DoubleValue(config.range));
+    mac.SetChannelAttribute("CouplingCache", BooleanValue(config.couplingCache));
+    if (config.csma) {
+        mac.SetDeviceType(CsmaMacNetDevice::GetTypeId().GetName());
+    } else {
+        mac.SetDeviceAttribute("AggregationCount", UintegerValue(config.aggregationCount));
+        mac.SetDeviceAttribute("AggregationDeadline", TimeValue(Seconds(config.aggregationDeadline)));
+        mac.SetDeviceAttribute("WakeInterval", TimeValue(Seconds(config.wakeInterval)));
+        mac.SetDeviceAttribute("ListenTime", TimeValue(Seconds(config.listenTime)));
+    }
+    NetDeviceContainer devices = mac.Install(nodes);
+    if (config.topology.empty()) {
+        MiScenarioLattice(config, nodes, devices);
+    } else {
+        MiScenarioTopology(topology, nodes, devices);
+    }
+    Ptr<MiEnergyModel> energy = CreateObject<MiEnergyModel>();
+    energy->SetAttribute("SleepCurrent", DoubleValue(config.sleepCurrent));
+    energy->Install(devices);
+    if (trace != nullptr) {
+        trace->Attach(devices);
+    }
+    if (stats != nullptr) {
+        stats->Attach(devices);
+    }
+    MiDriftMobility mobility(config.drift);
+    if (config.mobility) {
+        mobility.Install(devices);
+        mobility.Start();
+    }
+    Simulator::Stop(Seconds(config.simTime));
+
+    auto runStart = std::chrono::steady_clock::now();
+    Simulator::Run();
+    auto runEnd = std::chrono::steady_clock::now();
+    if (stats != nullptr) {
+        stats->Finish();
+    }
+
+    result.energy = energy->GetMetrics();
+    result.shortestLifetime = Time::Max();
+    for (uint32_t i = 0; i < result.nodes; i++) {
+        result.counters += DynamicCast<MiRadioDevice>(devices.Get(i))->GetCounters();
+        result.shortestLifetime = std::min(result.shortestLifetime, energy->GetLifetime(i));
+        result.meanLifetime += energy->GetLifetime(i) / result.nodes;
+        result.meanCurrent += energy->GetAverageCurrent(i) / result.nodes;
+        result.maxNodeEnergy = std::max(result.maxNodeEnergy, energy->GetEnergy(i));
+        result.sleepShare += energy->GetSleepTime(i) / (config.simTime * result.nodes);
+    }
+    result.energy.packetsSent = result.counters.framesSent;
+    result.moves = mobility.GetMoves();
+    result.turns = mobility.GetTurns();
+    if (result.nodes > 0) {
+        result.coupling = DynamicCast<MiMacChannel>(devices.Get(0)->GetChannel())->GetLinkTable().GetCounters();
+    }
+    result.events = Simulator::GetEventCount();
+    result.setupSec = std::chrono::duration<double>(runStart - setupStart).count();
+    result.wallSec = std::chrono::duration<double>(runEnd - runStart).count();
+
+    Simulator::Destroy();
+    return result;
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_SCENARIO_H
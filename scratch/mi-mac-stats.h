@@ -0,0 +1,416 @@
+#ifndef MI_MAC_STATS_H
+#define MI_MAC_STATS_H
+
+// Per-node and per-state MAC instrumentation.
+//
+// MiMacStats hangs off the devices' trace sources like MiTraceSink, so a run
+// without it attached pays nothing beyond the empty TracedCallback checks
+// that are always there.  Attached, every callback is O(1): it updates the
+// node's row (structure-of-arrays, as in MiEnergyModel) and bumps a
+// histogram bucket, without allocation or formatting.
+//
+// Collected:
+//   - dwell time in each NodeState, per node (coarse histogram, total, visits)
+//     and over all nodes (fine histogram)
+//   - REV -> ACK and REV -> DATA latency at the source: from the first REV
+//     of a handshake, retries included, to the ACK arriving and to the first
+//     DATA frame going out
+//   - coil pairs chosen by destinations after a REV sweep
+//   - retries and ACK/DATA timeouts, from the device counters
+//
+// With a snapshot interval, a scheduled event appends every node's running
+// totals to a CSV file, so long runs can be watched while they simulate.
+
+#include "mi-mac-net-device.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace ns3 {
+
+// Log-linear histogram of durations in microseconds: exact below 2^SUB_BITS
+// us, then 2^SUB_BITS buckets per power of two, up to 2^40 us (12.7 days).
+template <int SUB_BITS>
+struct MiHistogram {
+    static constexpr int MAX_LOG2 = 40;
+    static constexpr int BUCKETS = (MAX_LOG2 - SUB_BITS + 1) << SUB_BITS;
+
+    uint32_t counts[BUCKETS] = {};
+    uint64_t samples = 0;
+    double sum = 0.0;  // s
+    double max = 0.0;  // s
+
+    static int Bucket(uint64_t us) {
+        us = std::min<uint64_t>(us, (uint64_t(1) << MAX_LOG2) - 1);
+        if (us < (uint64_t(1) << SUB_BITS)) {
+            return static_cast<int>(us);
+        }
+        int octave = 63 - __builtin_clzll(us);
+        int sub = static_cast<int>(us >> (octave - SUB_BITS)) & ((1 << SUB_BITS) - 1);
+        return ((octave - SUB_BITS + 1) << SUB_BITS) | sub;
+    }
+
+    // Smallest value (us) that falls into bucket.
+    static uint64_t LowerEdge(int bucket) {
+        if (bucket < (1 << SUB_BITS)) {
+            return bucket;
+        }
+        int octave = (bucket >> SUB_BITS) + SUB_BITS - 1;
+        uint64_t sub = bucket & ((1 << SUB_BITS) - 1);
+        return ((uint64_t(1) << SUB_BITS) | sub) << (octave - SUB_BITS);
+    }
+
+    void Add(int64_t ns) {
+        counts[Bucket(ns / 1000)]++;
+        samples++;
+        double s = ns * 1e-9;
+        sum += s;
+        max = std::max(max, s);
+    }
+
+    double Mean() const { return samples == 0 ? 0.0 : sum / samples; }
+
+    // Upper edge (s) of the bucket holding the q-quantile sample.
+    double Quantile(double q) const {
+        if (samples == 0) {
+            return 0.0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * samples)));
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += counts[b];
+            if (seen >= rank) {
+                return std::min(max, (b + 1 < BUCKETS ? LowerEdge(b + 1) : LowerEdge(b)) * 1e-6);
+            }
+        }
+        return max;
+    }
+};
+
+class MiMacStats {
+  public:
+    // Per node: one bucket per power of two.  All nodes: eight per power of two.
+    typedef MiHistogram<0> NodeHistogram;
+    typedef MiHistogram<3> NetworkHistogram;
+
+    // snapshotFile is written every snapshotInterval of simulated time; an
+    // empty name or a zero interval takes no snapshots.
+    explicit MiMacStats(Time snapshotInterval = Time(0), const std::string& snapshotFile = "");
+    ~MiMacStats() { CloseSnapshots(); }
+
+    MiMacStats(const MiMacStats&) = delete;
+    MiMacStats& operator=(const MiMacStats&) = delete;
+
+    // Starts collecting for the given devices, all in IDLE from now on.
+    void Attach(const NetDeviceContainer& devices);
+    // Folds the time spent in the current states into the totals, takes a
+    // last snapshot and stops.  Call after Simulator::Run(), before Destroy().
+    void Finish();
+
+    uint32_t GetN() const { return m_state.size(); }
+    double GetStateTime(uint32_t index, NodeState state) const;  // s
+    uint32_t GetVisits(uint32_t index, NodeState state) const { return m_visits[state][index]; }
+    const uint32_t* GetNodeDwellHistogram(uint32_t index, NodeState state) const {
+        return &m_nodeDwell[state][index * NodeHistogram::BUCKETS];
+    }
+    const NetworkHistogram& GetDwellHistogram(NodeState state) const { return m_dwell[state]; }
+    const NetworkHistogram& GetRevToAck() const { return m_revToAck; }
+    const NetworkHistogram& GetRevToData() const { return m_revToData; }
+    // Times destinations chose txCoil -> rxCoil, over all nodes.
+    uint64_t GetCoilChoices(CoilID txCoil, CoilID rxCoil) const;
+    MiMacCounters GetCounters() const;
+
+    // Network-wide tables: state dwell, handshake latency, coil choices.
+    void Print(std::ostream& os) const;
+
+  private:
+    static void StateTransition(MiMacStats* stats, uint32_t nodeId, NodeState from, NodeState to,
+                                const char* reason);
+    static void MacTx(MiMacStats* stats, uint32_t nodeId, Ptr<const Packet> frame, CoilID coil);
+    static void MacRx(MiMacStats* stats, uint32_t nodeId, Ptr<const Packet> frame, CoilID txCoil, CoilID rxCoil,
+                      double rssi);
+    static void CoilSelection(MiMacStats* stats, uint32_t nodeId, const double* rssi, const CoilID* rxCoil,
+                              CoilID best);
+    int64_t Now() const;
+    void Snapshot();
+    void CloseSnapshots();
+
+    Time m_snapshotInterval;
+    std::string m_snapshotFile;
+    FILE* m_snapshots = nullptr;
+    EventId m_snapshotEvent;
+    bool m_finished = false;
+    int64_t m_finishTime = 0;  // time step
+
+    std::vector<Ptr<MiRadioDevice>> m_devices;
+    std::vector<uint32_t> m_indexOfNode;
+    std::vector<uint8_t> m_state;
+    std::vector<int64_t> m_since;                   // time step of the last transition
+    std::vector<double> m_stateTime[NUM_STATES];    // s, up to m_since
+    std::vector<uint32_t> m_visits[NUM_STATES];     // completed stays
+    std::vector<uint32_t> m_nodeDwell[NUM_STATES];  // NodeHistogram::BUCKETS per node
+    std::vector<int64_t> m_revStart;                // time step of the handshake's first REV, -1 if none
+    std::vector<uint8_t> m_ackSeen;
+    std::vector<double> m_revToAckSum, m_revToDataSum;  // s
+    std::vector<uint32_t> m_revToAckCount, m_revToDataCount;
+    std::vector<uint32_t> m_coilChoices;            // NUM_COILS^2 per node, txCoil * 3 + rxCoil
+
+    NetworkHistogram m_dwell[NUM_STATES];
+    NetworkHistogram m_revToAck;
+    NetworkHistogram m_revToData;
+};
+
+inline MiMacStats::MiMacStats(Time snapshotInterval, const std::string& snapshotFile)
+    : m_snapshotInterval(snapshotInterval),
+      m_snapshotFile(snapshotFile) {}
+
+inline void MiMacStats::Attach(const NetDeviceContainer& devices) {
+    uint32_t n = devices.GetN();
+    m_devices.resize(n);
+    m_state.assign(n, STATE_IDLE);
+    m_since.assign(n, Simulator::Now().GetTimeStep());
+    for (int s = 0; s < NUM_STATES; s++) {
+        m_stateTime[s].assign(n, 0.0);
+        m_visits[s].assign(n, 0);
+        m_nodeDwell[s].assign(static_cast<size_t>(n) * NodeHistogram::BUCKETS, 0);
+    }
+    m_revStart.assign(n, -1);
+    m_ackSeen.assign(n, 0);
+    m_revToAckSum.assign(n, 0.0);
+    m_revToDataSum.assign(n, 0.0);
+    m_revToAckCount.assign(n, 0);
+    m_revToDataCount.assign(n, 0);
+    m_coilChoices.assign(static_cast<size_t>(n) * NUM_COILS * NUM_COILS, 0);
+    m_indexOfNode.clear();
+    for (uint32_t i = 0; i < n; i++) {
+        m_devices[i] = DynamicCast<MiRadioDevice>(devices.Get(i));
+        uint32_t nodeId = devices.Get(i)->GetNode()->GetId();
+        if (nodeId >= m_indexOfNode.size()) {
+            m_indexOfNode.resize(nodeId + 1, n);
+        }
+        m_indexOfNode[nodeId] = i;
+        Ptr<NetDevice> device = devices.Get(i);
+        device->TraceConnectWithoutContext("StateTransition", MakeBoundCallback(&MiMacStats::StateTransition, this));
+        device->TraceConnectWithoutContext("MacTx", MakeBoundCallback(&MiMacStats::MacTx, this));
+        device->TraceConnectWithoutContext("MacRx", MakeBoundCallback(&MiMacStats::MacRx, this));
+        // CSMA/CA devices have no coil selection; the connection then fails harmlessly.
+        device->TraceConnectWithoutContext("CoilSelection", MakeBoundCallback(&MiMacStats::CoilSelection, this));
+    }
+
+    if (!m_snapshotFile.empty() && m_snapshotInterval.IsStrictlyPositive()) {
+        m_snapshots = std::fopen(m_snapshotFile.c_str(), "w");
+        NS_ABORT_MSG_IF(m_snapshots == nullptr, "cannot write " << m_snapshotFile);
+        std::fputs("time,node,state,idle_s,receive_s,sensing_s,acquire_s,transmit_s,visits,rev_ack_n,"
+                   "rev_ack_mean_ms,rev_data_n,rev_data_mean_ms,retries,ack_timeouts,data_timeouts",
+                   m_snapshots);
+        for (int tx = 0; tx < NUM_COILS; tx++) {
+            for (int rx = 0; rx < NUM_COILS; rx++) {
+                std::fprintf(m_snapshots, ",coil_%s%s", coilNames[tx].c_str(), coilNames[rx].c_str());
+            }
+        }
+        std::fputs("\n", m_snapshots);
+        m_snapshotEvent = Simulator::Schedule(m_snapshotInterval, &MiMacStats::Snapshot, this);
+    }
+}
+
+inline int64_t MiMacStats::Now() const {
+    return m_finished ? m_finishTime : Simulator::Now().GetTimeStep();
+}
+
+inline void MiMacStats::StateTransition(MiMacStats* stats, uint32_t nodeId, NodeState from, NodeState to,
+                                        const char* reason) {
+    uint32_t i = stats->m_indexOfNode[nodeId];
+    int64_t now = Simulator::Now().GetTimeStep();
+    int64_t dwell = now - stats->m_since[i];
+    int64_t dwellNs = TimeStep(dwell).GetNanoSeconds();
+    stats->m_stateTime[from][i] += TimeStep(dwell).GetSeconds();
+    stats->m_visits[from][i]++;
+    stats->m_nodeDwell[from][i * NodeHistogram::BUCKETS + NodeHistogram::Bucket(dwellNs / 1000)]++;
+    stats->m_dwell[from].Add(dwellNs);
+    stats->m_since[i] = now;
+    stats->m_state[i] = to;
+    if (to == STATE_IDLE) {
+        // Handshake over, completed or given up.
+        stats->m_revStart[i] = -1;
+    }
+}
+
+inline void MiMacStats::MacTx(MiMacStats* stats, uint32_t nodeId, Ptr<const Packet> frame, CoilID coil) {
+    uint32_t i = stats->m_indexOfNode[nodeId];
+    MiMacHeader header;
+    frame->PeekHeader(header);
+    int64_t now = Simulator::Now().GetTimeStep();
+    if (header.GetPacketType() == REV_PACKET && stats->m_revStart[i] < 0) {
+        stats->m_revStart[i] = now;
+        stats->m_ackSeen[i] = false;
+    } else if (header.GetPacketType() == DATA_PACKET && stats->m_revStart[i] >= 0) {
+        int64_t ns = TimeStep(now - stats->m_revStart[i]).GetNanoSeconds();
+        stats->m_revToData.Add(ns);
+        stats->m_revToDataSum[i] += ns * 1e-9;
+        stats->m_revToDataCount[i]++;
+        stats->m_revStart[i] = -1;
+    }
+}
+
+inline void MiMacStats::MacRx(MiMacStats* stats, uint32_t nodeId, Ptr<const Packet> frame, CoilID txCoil,
+                              CoilID rxCoil, double rssi) {
+    uint32_t i = stats->m_indexOfNode[nodeId];
+    if (stats->m_revStart[i] < 0 || stats->m_ackSeen[i]) {
+        return;
+    }
+    MiMacHeader header;
+    frame->PeekHeader(header);
+    if (header.GetPacketType() == ACK_PACKET) {
+        int64_t ns = TimeStep(Simulator::Now().GetTimeStep() - stats->m_revStart[i]).GetNanoSeconds();
+        stats->m_revToAck.Add(ns);
+        stats->m_revToAckSum[i] += ns * 1e-9;
+        stats->m_revToAckCount[i]++;
+        stats->m_ackSeen[i] = true;
+    }
+}
+
+inline void MiMacStats::CoilSelection(MiMacStats* stats, uint32_t nodeId, const double* rssi, const CoilID* rxCoil,
+                                      CoilID best) {
+    uint32_t i = stats->m_indexOfNode[nodeId];
+    stats->m_coilChoices[i * NUM_COILS * NUM_COILS + best * NUM_COILS + rxCoil[best]]++;
+}
+
+inline double MiMacStats::GetStateTime(uint32_t index, NodeState state) const {
+    double pending = m_state[index] == state ? TimeStep(Now() - m_since[index]).GetSeconds() : 0.0;
+    return m_stateTime[state][index] + pending;
+}
+
+inline uint64_t MiMacStats::GetCoilChoices(CoilID txCoil, CoilID rxCoil) const {
+    uint64_t total = 0;
+    for (size_t k = txCoil * NUM_COILS + rxCoil; k < m_coilChoices.size(); k += NUM_COILS * NUM_COILS) {
+        total += m_coilChoices[k];
+    }
+    return total;
+}
+
+inline MiMacCounters MiMacStats::GetCounters() const {
+    MiMacCounters total;
+    for (const Ptr<MiRadioDevice>& device : m_devices) {
+        total += device->GetCounters();
+    }
+    return total;
+}
+
+inline void MiMacStats::Snapshot() {
+    double now = TimeStep(Now()).GetSeconds();
+    for (uint32_t i = 0; i < GetN(); i++) {
+        uint32_t visits = 0;
+        for (int s = 0; s < NUM_STATES; s++) {
+            visits += m_visits[s][i];
+        }
+        const MiMacCounters& counters = m_devices[i]->GetCounters();
+        std::fprintf(m_snapshots, "%.3f,%u,%s,%.6f,%.6f,%.6f,%.6f,%.6f,%u,%u,%.3f,%u,%.3f,%llu,%llu,%llu", now,
+                     m_devices[i]->GetNode()->GetId(), stateNames[m_state[i]].c_str(),
+                     GetStateTime(i, STATE_IDLE), GetStateTime(i, STATE_RECEIVE),
+                     GetStateTime(i, STATE_CHANNEL_SENSING), GetStateTime(i, STATE_DATA_ACQUIRE),
+                     GetStateTime(i, STATE_TRANSMIT), visits, m_revToAckCount[i],
+                     m_revToAckCount[i] == 0 ? 0.0 : 1e3 * m_revToAckSum[i] / m_revToAckCount[i],
+                     m_revToDataCount[i],
+                     m_revToDataCount[i] == 0 ? 0.0 : 1e3 * m_revToDataSum[i] / m_revToDataCount[i],
+                     static_cast<unsigned long long>(counters.retries),
+                     static_cast<unsigned long long>(counters.ackTimeouts),
+                     static_cast<unsigned long long>(counters.dataTimeouts));
+        for (int k = 0; k < NUM_COILS * NUM_COILS; k++) {
+            std::fprintf(m_snapshots, ",%u", m_coilChoices[i * NUM_COILS * NUM_COILS + k]);
+        }
+        std::fputs("\n", m_snapshots);
+    }
+    std::fflush(m_snapshots);
+    if (!m_finished) {
+        m_snapshotEvent = Simulator::Schedule(m_snapshotInterval, &MiMacStats::Snapshot, this);
+    }
+}
+
+inline void MiMacStats::Finish() {
+    if (m_finished) {
+        return;
+    }
+    m_finishTime = Simulator::Now().GetTimeStep();
+    m_finished = true;
+    m_snapshotEvent.Cancel();
+    if (m_snapshots != nullptr) {
+        Snapshot();
+    }
+    CloseSnapshots();
+}
+
+inline void MiMacStats::CloseSnapshots() {
+    if (m_snapshots != nullptr) {
+        std::fclose(m_snapshots);
+        m_snapshots = nullptr;
+    }
+}
+
+inline void MiMacStats::Print(std::ostream& os) const {
+    double total = 0.0;
+    double stateTime[NUM_STATES] = {};
+    for (uint32_t i = 0; i < GetN(); i++) {
+        for (int s = 0; s < NUM_STATES; s++) {
+            stateTime[s] += GetStateTime(i, static_cast<NodeState>(s));
+        }
+    }
+    for (double t : stateTime) {
+        total += t;
+    }
+
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << std::fixed << std::setprecision(2);
+    os << "\n" << std::left << std::setw(20) << "  State" << std::right << std::setw(10) << "Time %" << std::setw(12)
+       << "Visits" << std::setw(12) << "Mean ms" << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms"
+       << std::setw(12) << "Max ms" << std::endl;
+    for (int s = 0; s < NUM_STATES; s++) {
+        const NetworkHistogram& h = m_dwell[s];
+        os << std::left << std::setw(20) << ("  " + stateNames[s]) << std::right << std::setw(10)
+           << (total > 0.0 ? 100.0 * stateTime[s] / total : 0.0) << std::setw(12) << h.samples << std::setw(12)
+           << 1e3 * h.Mean() << std::setw(12) << 1e3 * h.Quantile(0.5) << std::setw(12) << 1e3 * h.Quantile(0.99)
+           << std::setw(12) << 1e3 * h.max << std::endl;
+    }
+
+    os << "\n" << std::left << std::setw(20) << "  Handshake" << std::right << std::setw(10) << "Count"
+       << std::setw(12) << "Mean ms" << std::setw(12) << "p50 ms" << std::setw(12) << "p90 ms" << std::setw(12)
+       << "p99 ms" << std::setw(12) << "Max ms" << std::endl;
+    const NetworkHistogram* latencies[] = {&m_revToAck, &m_revToData};
+    const char* latencyNames[] = {"  REV -> ACK", "  REV -> DATA"};
+    for (int k = 0; k < 2; k++) {
+        const NetworkHistogram& h = *latencies[k];
+        os << std::left << std::setw(20) << latencyNames[k] << std::right << std::setw(10) << h.samples
+           << std::setw(12) << 1e3 * h.Mean() << std::setw(12) << 1e3 * h.Quantile(0.5) << std::setw(12)
+           << 1e3 * h.Quantile(0.9) << std::setw(12) << 1e3 * h.Quantile(0.99) << std::setw(12) << 1e3 * h.max
+           << std::endl;
+    }
+
+    uint64_t choices = 0;
+    for (int tx = 0; tx < NUM_COILS; tx++) {
+        for (int rx = 0; rx < NUM_COILS; rx++) {
+            choices += GetCoilChoices(static_cast<CoilID>(tx), static_cast<CoilID>(rx));
+        }
+    }
+    os << "\n  Coil pairs chosen (Tx -> Rx, % of " << choices << " sweeps):" << std::endl;
+    for (int tx = 0; tx < NUM_COILS; tx++) {
+        os << "    " << coilNames[tx] << " ->";
+        for (int rx = 0; rx < NUM_COILS; rx++) {
+            uint64_t c = GetCoilChoices(static_cast<CoilID>(tx), static_cast<CoilID>(rx));
+            os << "  " << coilNames[rx] << " " << std::setw(6) << (choices > 0 ? 100.0 * c / choices : 0.0);
+        }
+        os << std::endl;
+    }
+
+    MiMacCounters counters = GetCounters();
+    os << "\n  Retries:                 " << counters.retries << std::endl;
+    os << "  ACK / DATA timeouts:     " << counters.ackTimeouts << " / " << counters.dataTimeouts << std::endl;
+    os.flags(flags);
+    os.precision(precision);
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_STATS_H
@@ -0,0 +1,335 @@
+// Monte Carlo parameter sweep for the MI MAC lattice scenario.
+//
+// Every combination of MAC (the MI MAC or the CSMA/CA baseline), node count,
+// density, reading interval, DATA size and seed is run for a number of independent replications, spread over all
+// cores.  The ns-3 Simulator is a process-wide singleton, so each worker is a
+// forked process; workers pull the next job from a shared atomic counter
+// until the queue is empty and write their results into shared memory.
+// Replication r of every point uses RNG run r, so results do not depend on
+// which worker ran a job or in what order.  Automatic stream numbers are
+// process-global in ns-3, so every job also runs in its own short-lived child
+// forked from the untouched parent; a crashing job only loses its own sample.
+// --results also appends every replication as one row of a columnar results
+// file (see mi-mac-results.h), for scratch/mi-mac-query to aggregate.
+//
+//   ./ns3 run "scratch/mi-mac-sweep --nodes=100,1000 --payload=1,4,16 --replications=20"
+//   ./ns3 run "scratch/mi-mac-sweep --mac=mi,csma --interval=30,5,1,0.2"
+//   ./ns3 run "scratch/mi-mac-sweep --interval=30,5,1 --replications=50 --results=sweep.mires"
+
+#include "mi-mac-results.h"
+#include "mi-mac-scenario.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+struct SweepPoint {
+    MiScenarioConfig config;
+    double density;  // nodes per m²
+    uint32_t seed;
+};
+
+// Written by a worker process into shared memory, so plain data only.
+struct SweepSample {
+    bool done;
+    double deliveryRatio;
+    double throughput;         // delivered payload bits/s
+    double energy;             // µJ
+    double energyPerDelivered; // µJ per delivered DATA
+    double collisions;
+    double eventsPerSec;
+    double lifetimeDays;       // shortest node battery lifetime
+    double accessDelay;        // ms, mean from reading ready to DATA done
+    MiRunRecord record;        // with --results
+};
+
+const int NUM_METRICS = 8;
+const char* metricNames[NUM_METRICS] = {"delivery",   "throughput_bps", "energy_uJ",         "energy_per_data_uJ",
+                                        "collisions", "events_per_s",   "min_lifetime_days", "access_delay_ms"};
+
+double SampleMetric(const SweepSample& s, int metric) {
+    switch (metric) {
+        case 0: return s.deliveryRatio;
+        case 1: return s.throughput;
+        case 2: return s.energy;
+        case 3: return s.energyPerDelivered;
+        case 4: return s.collisions;
+        case 5: return s.eventsPerSec;
+        case 6: return s.lifetimeDays;
+        case 7: return s.accessDelay;
+    }
+    return 0.0;
+}
+
+// Header of the shared mapping; one SweepSample per job follows it.  Forked
+// workers see the mapping at the same address, so the pointer stays valid.
+struct alignas(SweepSample) SweepShared {
+    std::atomic<uint32_t> nextJob;
+    SweepSample* samples;
+};
+
+// Two-sided 95% Student-t quantile for the given degrees of freedom.
+double StudentT95(uint32_t df) {
+    static const double table[] = {0.0,   12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179,  2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086, 2.080,
+                                   2.074, 2.069,  2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df == 0) {
+        return 0.0;
+    }
+    return df <= 30 ? table[df] : (df <= 60 ? 2.000 : 1.960);
+}
+
+struct MetricSummary {
+    double mean = 0.0;
+    double stddev = 0.0;
+    double halfWidth = 0.0;  // 95% confidence interval half-width
+};
+
+MetricSummary Summarise(const std::vector<double>& values) {
+    MetricSummary s;
+    size_t n = values.size();
+    if (n == 0) {
+        return s;
+    }
+    for (double v : values) {
+        s.mean += v;
+    }
+    s.mean /= n;
+    if (n > 1) {
+        double sq = 0.0;
+        for (double v : values) {
+            sq += (v - s.mean) * (v - s.mean);
+        }
+        s.stddev = std::sqrt(sq / (n - 1));
+        s.halfWidth = StudentT95(n - 1) * s.stddev / std::sqrt(static_cast<double>(n));
+    }
+    return s;
+}
+
+void RunWorker(SweepShared* shared, const std::vector<SweepPoint>& points, uint32_t replications, bool records) {
+    uint32_t jobCount = points.size() * replications;
+    for (;;) {
+        uint32_t job = shared->nextJob.fetch_add(1);
+        if (job >= jobCount) {
+            return;
+        }
+        pid_t pid = fork();
+        NS_ABORT_MSG_IF(pid < 0, "fork failed");
+        if (pid != 0) {
+            int status = 0;
+            waitpid(pid, &status, 0);
+            continue;
+        }
+
+        const SweepPoint& point = points[job / replications];
+        RngSeedManager::SetSeed(point.seed);
+        RngSeedManager::SetRun(job % replications + 1);
+        MiMacStats stats;
+        MiScenarioResult result = RunMiScenario(point.config, nullptr, records ? &stats : nullptr);
+
+        SweepSample& sample = shared->samples[job];
+        sample.deliveryRatio = result.DeliveryRatio();
+        sample.throughput = result.counters.dataReceived * point.config.payloadSize * 8.0 / point.config.simTime;
+        sample.energy = result.energy.totalEnergy;
+        sample.energyPerDelivered =
+            result.counters.dataReceived == 0 ? 0.0 : result.energy.totalEnergy / result.counters.dataReceived;
+        sample.collisions = result.counters.collisions;
+        sample.eventsPerSec = result.wallSec > 0.0 ? result.events / result.wallSec : 0.0;
+        sample.lifetimeDays = result.shortestLifetime.GetSeconds() / 86400.0;
+        sample.accessDelay = result.MeanAccessDelay() * 1e3;
+        if (records) {
+            sample.record = MiMakeRunRecord(point.config, result, &stats);
+            sample.record.density = point.density;
+        }
+        sample.done = true;
+        _exit(0);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string macList = "mi";
+    std::string nodeList = "100,400";
+    std::string densityList = "0.25";
+    std::string intervalList = "30";
+    std::string payloadList = "10";
+    std::string seedList = "1";
+    uint32_t replications = 10;
+    uint32_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    double simTime = 60.0;
+    double range = 4.0;
+    std::string csvFile;
+    std::string resultsFile;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("mac", "Comma-separated MACs: mi (Multi-Coil MI) and/or csma (CSMA/CA baseline)", macList);
+    cmd.AddValue("nodes", "Comma-separated node counts", nodeList);
+    cmd.AddValue("density", "Comma-separated node densities (nodes/m²)", densityList);
+    cmd.AddValue("interval", "Comma-separated mean reading intervals per node (s); sets the offered load",
+                 intervalList);
+    cmd.AddValue("payload", "Comma-separated DATA payload sizes (1-16 bytes)", payloadList);
+    cmd.AddValue("seeds", "Comma-separated RNG seeds", seedList);
+    cmd.AddValue("replications", "Independent replications (RNG runs) per point and seed", replications);
+    cmd.AddValue("jobs", "Worker processes", jobs);
+    cmd.AddValue("simTime", "Simulated time per replication (s)", simTime);
+    cmd.AddValue("range", "Coupling evaluation radius (m)", range);
+    cmd.AddValue("csv", "Also write the summary to this CSV file", csvFile);
+    cmd.AddValue("results", "Append every replication to this columnar results file", resultsFile);
+    cmd.Parse(argc, argv);
+
+    std::vector<SweepPoint> points;
+    for (const std::string& mac : MiParseList<std::string>(macList)) {
+        NS_ABORT_MSG_IF(mac != "mi" && mac != "csma", "unknown MAC '" << mac << "'");
+        for (uint32_t nodes : MiParseList<uint32_t>(nodeList)) {
+            for (double density : MiParseList<double>(densityList)) {
+                for (double interval : MiParseList<double>(intervalList)) {
+                    for (uint32_t payload : MiParseList<uint32_t>(payloadList)) {
+                        for (uint32_t seed : MiParseList<uint32_t>(seedList)) {
+                            NS_ABORT_MSG_IF(payload < 1 || payload > MiMacNetDevice::MAX_PAYLOAD,
+                                            "payload must be 1-" << MiMacNetDevice::MAX_PAYLOAD << " bytes");
+                            NS_ABORT_MSG_IF(density <= 0.0, "density must be positive");
+                            SweepPoint point;
+                            point.config.nodes = nodes;
+                            point.config.spacing = 1.0 / std::sqrt(density);
+                            point.config.range = range;
+                            point.config.simTime = simTime;
+                            point.config.meanInterval = interval;
+                            point.config.payloadSize = payload;
+                            point.config.csma = mac == "csma";
+                            point.density = density;
+                            point.seed = seed;
+                            points.push_back(point);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    NS_ABORT_MSG_IF(points.empty() || replications == 0, "empty sweep");
+    uint32_t jobCount = points.size() * replications;
+    jobs = std::min(std::max(jobs, 1u), jobCount);
+
+    size_t sharedSize = sizeof(SweepShared) + jobCount * sizeof(SweepSample);
+    void* mapping = mmap(nullptr, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    NS_ABORT_MSG_IF(mapping == MAP_FAILED, "cannot map shared result memory");
+    SweepShared* shared = new (mapping) SweepShared();
+    shared->nextJob.store(0);
+    shared->samples = reinterpret_cast<SweepSample*>(shared + 1);
+    for (uint32_t j = 0; j < jobCount; j++) {
+        new (&shared->samples[j]) SweepSample();
+    }
+
+    std::cout << "\n" << std::string(70, '=') << std::endl;
+    std::cout << "   MI MAC MONTE CARLO SWEEP" << std::endl;
+    std::cout << std::string(70, '=') << std::endl;
+    std::cout << "\n  Points:                  " << points.size() << std::endl;
+    std::cout << "  Replications per point:  " << replications << std::endl;
+    std::cout << "  Worker processes:        " << jobs << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<pid_t> workers;
+    for (uint32_t w = 0; w < jobs; w++) {
+        pid_t pid = fork();
+        NS_ABORT_MSG_IF(pid < 0, "fork failed");
+        if (pid == 0) {
+            RunWorker(shared, points, replications, !resultsFile.empty());
+            _exit(0);
+        }
+        workers.push_back(pid);
+    }
+    for (pid_t pid : workers) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t failed = 0;
+    for (uint32_t j = 0; j < jobCount; j++) {
+        failed += shared->samples[j].done ? 0 : 1;
+    }
+    std::cout << "  Wall-clock time:         " << std::fixed << std::setprecision(2) << wallSec << " s" << std::endl;
+    if (failed > 0) {
+        std::cout << "  Failed replications:     " << failed << " (excluded)" << std::endl;
+    }
+
+    std::ofstream csv;
+    if (!csvFile.empty()) {
+        csv.open(csvFile);
+        csv << "mac,nodes,density,interval_s,payload_B,seed,replications";
+        for (int m = 0; m < NUM_METRICS; m++) {
+            csv << "," << metricNames[m] << "_mean," << metricNames[m] << "_sd," << metricNames[m] << "_ci95";
+        }
+        csv << "\n";
+    }
+
+    std::cout << "\n  Mean ± 95% CI over replications\n" << std::endl;
+    std::cout << std::setw(5) << "MAC" << std::setw(7) << "Nodes" << std::setw(9) << "Dens" << std::setw(8) << "Int(s)"
+              << std::setw(5) << "B" << std::setw(6) << "Seed" << std::setw(18) << "Delivery" << std::setw(20) << "Goodput (bit/s)"
+              << std::setw(22) << "Energy/DATA (µJ)" << std::setw(16) << "Collisions" << std::setw(19)
+              << "Access (ms)" << std::endl;
+
+    for (size_t p = 0; p < points.size(); p++) {
+        const SweepPoint& point = points[p];
+        MetricSummary summary[NUM_METRICS];
+        uint32_t valid = 0;
+        for (int m = 0; m < NUM_METRICS; m++) {
+            std::vector<double> values;
+            for (uint32_t r = 0; r < replications; r++) {
+                const SweepSample& sample = shared->samples[p * replications + r];
+                if (sample.done) {
+                    values.push_back(SampleMetric(sample, m));
+                }
+            }
+            summary[m] = Summarise(values);
+            valid = values.size();
+        }
+
+        const char* mac = point.config.csma ? "csma" : "mi";
+        std::cout << std::setw(5) << mac << std::setw(7) << point.config.nodes << std::setw(9) << std::setprecision(3)
+                  << point.density << std::setw(8) << std::setprecision(1) << point.config.meanInterval << std::setw(5)
+                  << point.config.payloadSize << std::setw(6) << point.seed << std::setprecision(3) << std::setw(9)
+                  << summary[0].mean << " ±" << std::setw(7) << summary[0].halfWidth << std::setprecision(1)
+                  << std::setw(11) << summary[1].mean << " ±" << std::setw(7) << summary[1].halfWidth
+                  << std::setprecision(2) << std::setw(12) << summary[3].mean << " ±" << std::setw(8)
+                  << summary[3].halfWidth << std::setprecision(1) << std::setw(8) << summary[4].mean << " ±"
+                  << std::setw(6) << summary[4].halfWidth << std::setprecision(2) << std::setw(10)
+                  << summary[7].mean << " ±" << std::setw(7) << summary[7].halfWidth << std::endl;
+
+        if (csv.is_open()) {
+            csv << mac << "," << point.config.nodes << "," << point.density << "," << point.config.meanInterval << ","
+                << point.config.payloadSize << "," << point.seed << "," << valid;
+            for (int m = 0; m < NUM_METRICS; m++) {
+                csv << "," << summary[m].mean << "," << summary[m].stddev << "," << summary[m].halfWidth;
+            }
+            csv << "\n";
+        }
+    }
+    std::cout << std::endl;
+    if (csv.is_open()) {
+        std::cout << "  Summary written to " << csvFile << "\n" << std::endl;
+    }
+    if (!resultsFile.empty()) {
+        MiResultWriter writer;
+        writer.Open(resultsFile, MiRunRecord::Columns());
+        for (uint32_t j = 0; j < jobCount; j++) {
+            if (shared->samples[j].done) {
+                shared->samples[j].record.Append(writer, "sweep");
+            }
+        }
+        writer.Close();
+        std::cout << "  Replications appended to " << resultsFile << " (" << writer.GetRowsWritten() << " rows)\n"
+                  << std::endl;
+    }
+
+    munmap(mapping, sharedSize);
+    return failed == jobCount ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+// Topology file loader benchmark.  Writes a jittered three-dimensional
+// lattice of randomly oriented nodes as a topology file (see
+// mi-mac-topology.h), then times reading it back three ways: parsing the
+// text, parsing it and writing the binary cache, and loading the cache.
+// The file can then drive mi-mac-scale through --topology.
+//
+//   ./ns3 run "scratch/mi-mac-topology --nodes=1000000 --file=nodes.txt"
+
+#include "mi-mac-topology.h"
+
+#include "ns3/core-module.h"
+
+#include <chrono>
+
+using namespace ns3;
+
+struct LoadRun {
+    MiTopology topology;
+    bool fromCache = false;
+    double seconds = 0.0;
+};
+
+LoadRun TimeLoad(const std::string& file, bool useCache) {
+    LoadRun run;
+    auto start = std::chrono::steady_clock::now();
+    run.topology = MiTopology::Load(file, useCache, &run.fromCache);
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return run;
+}
+
+void PrintLoad(const std::string& label, const LoadRun& run) {
+    std::cout << "  " << std::left << std::setw(24) << label << std::right << std::setw(8) << run.seconds << " s"
+              << std::setw(14) << run.topology.GetN() / run.seconds / 1e6 << " M nodes/s"
+              << (run.fromCache ? "  (cache)" : "") << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t nodes = 1000000;
+    uint32_t layers = 10;
+    double spacing = 2.0;
+    double interval = 30.0;
+    uint32_t payload = 10;
+    std::string file = "mi-mac-topology.txt";
+    bool generate = true;
+    uint32_t seed = 1;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nodes", "Number of nodes to generate", nodes);
+    cmd.AddValue("layers", "Lattice layers along Z", layers);
+    cmd.AddValue("spacing", "Lattice spacing between nodes (m)", spacing);
+    cmd.AddValue("interval", "Mean time between sensor readings per node (s)", interval);
+    cmd.AddValue("payload", "DATA payload size (1-16 bytes)", payload);
+    cmd.AddValue("file", "Topology file to write and read", file);
+    cmd.AddValue("generate", "Write the file first; false only times loading an existing one", generate);
+    cmd.AddValue("seed", "RNG seed", seed);
+    cmd.Parse(argc, argv);
+
+    RngSeedManager::SetSeed(seed);
+
+    std::cout << "\n" << std::string(70, '=') << std::endl;
+    std::cout << "   TOPOLOGY FILE LOADING" << std::endl;
+    std::cout << std::string(70, '=') << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    if (generate) {
+        auto start = std::chrono::steady_clock::now();
+        MiTopology::Lattice(nodes, std::max(layers, 1u), spacing, interval, payload).SaveText(file);
+        std::cout << "\n  Generated:               " << nodes << " nodes -> " << file << " ("
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s)"
+                  << std::endl;
+        std::remove((file + ".bin").c_str());
+    }
+    struct stat info;
+    NS_ABORT_MSG_IF(stat(file.c_str(), &info) != 0, "cannot open topology file " << file);
+    std::cout << "\n  File size:               " << info.st_size / 1e6 << " MB" << std::endl;
+
+    std::cout << "\n";
+    LoadRun text = TimeLoad(file, false);
+    PrintLoad("Text parse:", text);
+    LoadRun first = TimeLoad(file, true);
+    PrintLoad("Parse + cache write:", first);
+    LoadRun cached = TimeLoad(file, true);
+    PrintLoad("Cached load:", cached);
+
+    const MiTopology& topology = cached.topology;
+    uint32_t n = topology.GetN();
+    uint32_t sources = 0;
+    double lo[3] = {INFINITY, INFINITY, INFINITY};
+    double hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (uint32_t i = 0; i < n; i++) {
+        sources += topology.IsSource(i);
+        const double p[3] = {topology.x[i], topology.y[i], topology.z[i]};
+        for (int k = 0; k < 3; k++) {
+            lo[k] = std::min(lo[k], p[k]);
+            hi[k] = std::max(hi[k], p[k]);
+        }
+    }
+    bool same = text.topology.GetN() == n && std::equal(text.topology.x.begin(), text.topology.x.end(),
+                                                        topology.x.begin()) &&
+                std::equal(text.topology.destination.begin(), text.topology.destination.end(),
+                           topology.destination.begin());
+
+    std::cout << "\n  Nodes / sources:         " << n << " / " << sources << std::endl;
+    std::cout << "  Extent:                  " << hi[0] - lo[0] << " x " << hi[1] - lo[1] << " x " << hi[2] - lo[2]
+              << " m" << std::endl;
+    std::cout << "  Column memory:           " << topology.GetMemoryBytes() / 1e6 << " MB ("
+              << static_cast<double>(topology.GetMemoryBytes()) / std::max(n, 1u) << " bytes/node)" << std::endl;
+    std::cout << "  Cache speed-up:          " << text.seconds / cached.seconds << "x" << std::endl;
+    std::cout << "  Cache matches text:      " << (same ? "yes" : "NO") << "\n" << std::endl;
+
+    return same ? 0 : 1;
+}
@@ -0,0 +1,341 @@
+#ifndef MI_MAC_TOPOLOGY_H
+#define MI_MAC_TOPOLOGY_H
+
+// Node placement and traffic read from a scenario file.
+//
+// Text format, one node per line; '#' starts a comment:
+//   id x y z qw qx qy qz interval payload destination
+// Position in m.  The quaternion rotates the node's X/Y/Z coil frame into
+// the world frame and is normalised on use.  interval is the mean time
+// between Poisson readings (s), payload their size (bytes) and destination
+// the id they go to; interval 0 or destination -1 makes a node that only
+// receives.  Ids must be unique, a node may not send to itself and a
+// sending node's payload must fit one DATA frame.
+//
+// The file is memory-mapped and parsed in one pass with std::from_chars into
+// structure-of-arrays columns, sized up front from a newline count, so the
+// number of allocations does not depend on the node count.  Load() keeps the
+// parsed columns in "<file>.bin" and reads that instead of the text while
+// the text file keeps its size and modification time.
+
+#include "mi-mac-coupling.h"
+#include "mi-mac-net-device.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace ns3 {
+
+struct MiTopology {
+    static constexpr uint32_t NO_DESTINATION = UINT32_MAX;
+    // Cache files start with this magic, then the text file's size and
+    // modification time in ns (int64 each) and the node count (uint64).
+    static constexpr char CACHE_MAGIC[8] = {'M', 'I', 'T', 'O', 'P', 'O', '0', '2'};
+
+    std::vector<uint32_t> id;
+    std::vector<double> x, y, z;  // m
+    std::vector<float> qw, qx, qy, qz;
+    std::vector<float> interval;          // s, 0 for none
+    std::vector<uint16_t> payload;        // bytes
+    std::vector<uint32_t> destination;    // node index, NO_DESTINATION for none
+
+    uint32_t GetN() const { return id.size(); }
+    bool IsSource(uint32_t i) const { return interval[i] > 0.0f && destination[i] != NO_DESTINATION; }
+    MiOrientation GetOrientation(uint32_t i) const;
+    size_t GetMemoryBytes() const;
+    void Resize(uint32_t n);
+
+    // Reads path, through its cache if allowed.  fromCache, if given, tells
+    // which one was used.
+    static MiTopology Load(const std::string& path, bool useCache = true, bool* fromCache = nullptr);
+    static MiTopology ParseText(const std::string& path);
+    // nodes on a jittered side x side x layers lattice with random
+    // orientations, each reporting to the next node in its row (the
+    // previous one at the row end).
+    static MiTopology Lattice(uint32_t nodes, uint32_t layers, double spacing, double interval, uint32_t payload);
+    void SaveText(const std::string& path) const;
+    void SaveCache(const std::string& path, int64_t sourceSize, int64_t sourceTime) const;
+    // False if the cache is missing or was written for another version of the text.
+    bool LoadCache(const std::string& path, int64_t sourceSize, int64_t sourceTime);
+
+  private:
+    // Visits every column, in cache file order.
+    template <typename Self, typename F>
+    static void ForEachColumn(Self& self, F f);
+};
+
+inline MiOrientation MiTopology::GetOrientation(uint32_t i) const {
+    double w = qw[i], a = qx[i], b = qy[i], c = qz[i];
+    double norm = std::sqrt(w * w + a * a + b * b + c * c);
+    if (norm == 0.0) {
+        return MiOrientation();
+    }
+    w /= norm;
+    a /= norm;
+    b /= norm;
+    c /= norm;
+    MiOrientation o;
+    o.m[0] = 1 - 2 * (b * b + c * c);
+    o.m[1] = 2 * (a * b - w * c);
+    o.m[2] = 2 * (a * c + w * b);
+    o.m[3] = 2 * (a * b + w * c);
+    o.m[4] = 1 - 2 * (a * a + c * c);
+    o.m[5] = 2 * (b * c - w * a);
+    o.m[6] = 2 * (a * c - w * b);
+    o.m[7] = 2 * (b * c + w * a);
+    o.m[8] = 1 - 2 * (a * a + b * b);
+    return o;
+}
+
+inline void MiTopology::Resize(uint32_t n) {
+    ForEachColumn(*this, [n](auto& column) { column.resize(n); });
+}
+
+inline size_t MiTopology::GetMemoryBytes() const {
+    size_t bytes = 0;
+    ForEachColumn(*this, [&bytes](const auto& column) { bytes += column.capacity() * sizeof(column[0]); });
+    return bytes;
+}
+
+template <typename Self, typename F>
+void MiTopology::ForEachColumn(Self& self, F f) {
+    f(self.id);
+    f(self.x);
+    f(self.y);
+    f(self.z);
+    f(self.qw);
+    f(self.qx);
+    f(self.qy);
+    f(self.qz);
+    f(self.interval);
+    f(self.payload);
+    f(self.destination);
+}
+
+inline MiTopology MiTopology::Load(const std::string& path, bool useCache, bool* fromCache) {
+    struct stat info;
+    NS_ABORT_MSG_IF(stat(path.c_str(), &info) != 0, "cannot open topology file " << path);
+    std::string cachePath = path + ".bin";
+    MiTopology topology;
+    // Nanoseconds, so an edit that keeps the size within the same second
+    // still invalidates the cache.
+    int64_t mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    bool cached = useCache && topology.LoadCache(cachePath, info.st_size, mtime);
+    if (!cached) {
+        topology = ParseText(path);
+        if (useCache) {
+            topology.SaveCache(cachePath, info.st_size, mtime);
+        }
+    }
+    if (fromCache != nullptr) {
+        *fromCache = cached;
+    }
+    return topology;
+}
+
+inline MiTopology MiTopology::ParseText(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(fd < 0, "cannot open topology file " << path);
+    struct stat info;
+    fstat(fd, &info);
+    size_t length = info.st_size;
+    const char* data = "";
+    void* mapped = MAP_FAILED;
+    if (length > 0) {
+        mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        NS_ABORT_MSG_IF(mapped == MAP_FAILED, "cannot map topology file " << path);
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    const char* end = data + length;
+
+    // Every node takes one line, so the newline count bounds the node count.
+    MiTopology topology;
+    topology.Resize(std::count(data, end, '\n') + 1);
+
+    uint32_t n = 0;
+    uint32_t line = 0;
+    const char* p = data;
+    auto skipBlanks = [&p, end]() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r')) {
+            p++;
+        }
+    };
+    auto number = [&](auto& value) {
+        skipBlanks();
+        auto result = std::from_chars(p, end, value);
+        NS_ABORT_MSG_IF(result.ec != std::errc(), path << ":" << line << ": expected a number");
+        p = result.ptr;
+    };
+    while (p < end) {
+        line++;
+        skipBlanks();
+        if (p == end || *p == '\n' || *p == '#') {
+            p = std::find(p, end, '\n');
+            p += p < end;
+            continue;
+        }
+        uint32_t nodeId;
+        int64_t target;
+        number(nodeId);
+        topology.id[n] = nodeId;
+        number(topology.x[n]);
+        number(topology.y[n]);
+        number(topology.z[n]);
+        number(topology.qw[n]);
+        number(topology.qx[n]);
+        number(topology.qy[n]);
+        number(topology.qz[n]);
+        number(topology.interval[n]);
+        number(topology.payload[n]);
+        number(target);
+        topology.destination[n] = target < 0 ? NO_DESTINATION : static_cast<uint32_t>(target);
+        NS_ABORT_MSG_IF(!(topology.interval[n] >= 0.0f) || std::isinf(topology.interval[n]),
+                        path << ":" << line << ": interval must be a finite value >= 0");
+        NS_ABORT_MSG_IF(target == nodeId, path << ":" << line << ": node " << nodeId << " sends to itself");
+        NS_ABORT_MSG_IF(topology.interval[n] > 0.0f && target >= 0 &&
+                            (topology.payload[n] < 1 || topology.payload[n] > MiMacNetDevice::MAX_PAYLOAD),
+                        path << ":" << line << ": payload must be 1-" << MiMacNetDevice::MAX_PAYLOAD << " bytes");
+        skipBlanks();
+        NS_ABORT_MSG_IF(p < end && *p != '\n' && *p != '#', path << ":" << line << ": trailing characters");
+        p = std::find(p, end, '\n');
+        p += p < end;
+        n++;
+    }
+    if (mapped != MAP_FAILED) {
+        munmap(mapped, length);
+    }
+    close(fd);
+    topology.Resize(n);
+
+    // Destinations were read as node ids; resolve them to array indices.
+    // Ids are usually 0..n-1 in order, which needs no lookup table.
+    bool dense = true;
+    for (uint32_t i = 0; i < n && dense; i++) {
+        dense = topology.id[i] == i;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> byId;
+    if (!dense) {
+        byId.resize(n);
+        for (uint32_t i = 0; i < n; i++) {
+            byId[i] = {topology.id[i], i};
+        }
+        std::sort(byId.begin(), byId.end());
+        for (uint32_t i = 1; i < n; i++) {
+            NS_ABORT_MSG_IF(byId[i].first == byId[i - 1].first, path << ": duplicate node id " << byId[i].first);
+        }
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t target = topology.destination[i];
+        if (target == NO_DESTINATION) {
+            continue;
+        }
+        if (dense) {
+            NS_ABORT_MSG_IF(target >= n, path << ": node " << topology.id[i] << " sends to unknown node " << target);
+            continue;
+        }
+        auto found = std::lower_bound(byId.begin(), byId.end(), std::make_pair(target, 0u));
+        NS_ABORT_MSG_IF(found == byId.end() || found->first != target,
+                        path << ": node " << topology.id[i] << " sends to unknown node " << target);
+        topology.destination[i] = found->second;
+    }
+    return topology;
+}
+
+inline MiTopology MiTopology::Lattice(uint32_t nodes, uint32_t layers, double spacing, double interval,
+                                     uint32_t payload) {
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(std::ceil(static_cast<double>(nodes) / layers))));
+    MiTopology topology;
+    topology.Resize(nodes);
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+    for (uint32_t i = 0; i < nodes; i++) {
+        uint32_t column = i % side;
+        uint32_t row = i / side % side;
+        uint32_t layer = i / (side * side);
+        topology.id[i] = i;
+        topology.x[i] = (column + random->GetValue(-0.1, 0.1)) * spacing;
+        topology.y[i] = (row + random->GetValue(-0.1, 0.1)) * spacing;
+        topology.z[i] = (layer + random->GetValue(-0.1, 0.1)) * spacing;
+        // Uniformly distributed rotation (Shoemake).
+        double u1 = random->GetValue(), u2 = random->GetValue(0, 2 * M_PI), u3 = random->GetValue(0, 2 * M_PI);
+        topology.qw[i] = std::sqrt(1 - u1) * std::sin(u2);
+        topology.qx[i] = std::sqrt(1 - u1) * std::cos(u2);
+        topology.qy[i] = std::sqrt(u1) * std::sin(u3);
+        topology.qz[i] = std::sqrt(u1) * std::cos(u3);
+        topology.interval[i] = interval;
+        topology.payload[i] = payload;
+        // Node 0 of a one-column lattice has no left-hand neighbour.
+        bool rowEnd = column == side - 1 || i + 1 == nodes;
+        topology.destination[i] = !rowEnd ? i + 1 : (i > 0 ? i - 1 : (nodes > 1 ? 1 : NO_DESTINATION));
+    }
+    return topology;
+}
+
+inline void MiTopology::SaveText(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "w");
+    NS_ABORT_MSG_IF(file == nullptr, "cannot write topology file " << path);
+    std::fputs("# id x y z qw qx qy qz interval payload destination\n", file);
+    for (uint32_t i = 0; i < GetN(); i++) {
+        long long target = destination[i] == NO_DESTINATION ? -1 : static_cast<long long>(id[destination[i]]);
+        std::fprintf(file, "%u %.3f %.3f %.3f %.6f %.6f %.6f %.6f %g %u %lld\n", id[i], x[i], y[i], z[i], qw[i],
+                     qx[i], qy[i], qz[i], interval[i], payload[i], target);
+    }
+    std::fclose(file);
+}
+
+inline void MiTopology::SaveCache(const std::string& path, int64_t sourceSize, int64_t sourceTime) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return;  // a read-only directory only costs the next load its speed-up
+    }
+    uint64_t count = GetN();
+    std::fwrite(CACHE_MAGIC, sizeof(CACHE_MAGIC), 1, file);
+    std::fwrite(&sourceSize, sizeof(sourceSize), 1, file);
+    std::fwrite(&sourceTime, sizeof(sourceTime), 1, file);
+    std::fwrite(&count, sizeof(count), 1, file);
+    ForEachColumn(*this,
+                  [file](const auto& column) { std::fwrite(column.data(), sizeof(column[0]), column.size(), file); });
+    std::fclose(file);
+}
+
+inline bool MiTopology::LoadCache(const std::string& path, int64_t sourceSize, int64_t sourceTime) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    char magic[sizeof(CACHE_MAGIC)];
+    int64_t size = -1;
+    int64_t time = -1;
+    uint64_t count = 0;
+    bool ok = std::fread(magic, sizeof(magic), 1, file) == 1 && std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) == 0 &&
+              std::fread(&size, sizeof(size), 1, file) == 1 && std::fread(&time, sizeof(time), 1, file) == 1 &&
+              std::fread(&count, sizeof(count), 1, file) == 1 && size == sourceSize && time == sourceTime;
+    // The columns must fill the rest of the file exactly, so a corrupt count
+    // is rejected before anything is sized from it.
+    size_t nodeBytes = 0;
+    ForEachColumn(*this, [&nodeBytes](const auto& column) { nodeBytes += sizeof(column[0]); });
+    struct stat info;
+    ok = ok && count <= UINT32_MAX && fstat(fileno(file), &info) == 0 &&
+         static_cast<uint64_t>(info.st_size) == sizeof(CACHE_MAGIC) + 3 * sizeof(int64_t) + count * nodeBytes;
+    if (ok) {
+        Resize(count);
+        ForEachColumn(*this, [&](auto& column) {
+            ok = ok && std::fread(column.data(), sizeof(column[0]), count, file) == count;
+        });
+    }
+    std::fclose(file);
+    return ok;
+}
+
+} // namespace ns3
+
+#endif // MI_MAC_TOPOLOGY_H
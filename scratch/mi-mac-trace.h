@@ -0,0 +1,340 @@
+#ifndef MI_MAC_TRACE_H
+#define MI_MAC_TRACE_H
+
+// Structured trace sink for MiMacNetDevice.
+//
+// Trace callbacks only copy a fixed-size record into a lock-free
+// single-producer ring owned by the calling thread; a background writer
+// drains all rings into a CSV or binary file.  Nothing is formatted or
+// flushed on the simulation thread.
+//
+// Verbosity is fixed at compile time with -DMI_TRACE_LEVEL=n:
+//   0  nothing (Attach() connects no trace sources)
+//   1  frames sent, received and dropped
+//   2  + state transitions
+//   3  + coil selection decisions (default)
+// At run time the MI_TRACE_SILENT format turns the sink off as well.
+
+#include "mi-mac-net-device.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define MI_TRACE_LEVEL_FRAMES 1
+#define MI_TRACE_LEVEL_STATES 2
+#define MI_TRACE_LEVEL_COILS 3
+
+#ifndef MI_TRACE_LEVEL
+#define MI_TRACE_LEVEL MI_TRACE_LEVEL_COILS
+#endif
+
+namespace ns3 {
+
+enum MiTraceKind : uint8_t {
+    MI_TRACE_STATE = 0,
+    MI_TRACE_TX = 1,
+    MI_TRACE_RX = 2,
+    MI_TRACE_DROP = 3,
+    MI_TRACE_COIL = 4
+};
+
+inline const char* traceKindNames[] = {"STATE", "TX", "RX", "DROP", "COIL"};
+
+// One trace event.  Fields that do not apply to a kind are zero; coil and
+// rxCoil are the coil pair used (TX: coil only; COIL: the selected pair) and
+// rssi is the received power of RX and COIL records.
+struct MiTraceRecord {
+    int64_t timeNs;
+    uint32_t node;
+    uint8_t kind;
+    uint8_t from;
+    uint8_t to;
+    uint8_t packetType;
+    uint8_t coil;
+    uint8_t rxCoil;
+    uint16_t size;  // frame bytes
+    float rssi;     // dBm
+};
+
+static_assert(sizeof(MiTraceRecord) == 24, "MiTraceRecord is written to disk as is");
+
+// Bounded single-producer / single-consumer queue of records.
+class MiTraceRing {
+  public:
+    explicit MiTraceRing(size_t capacity) {
+        size_t c = 1;
+        while (c < capacity) {
+            c <<= 1;
+        }
+        m_records.resize(c);
+        m_mask = c - 1;
+    }
+
+    bool Push(const MiTraceRecord& record) {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) > m_mask) {
+            return false;
+        }
+        m_records[head & m_mask] = record;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Hands every queued record to f, oldest first.  Returns the count.
+    template <typename F>
+    size_t Drain(F f) {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        for (uint64_t i = tail; i < head; i++) {
+            f(m_records[i & m_mask]);
+        }
+        m_tail.store(head, std::memory_order_release);
+        return head - tail;
+    }
+
+  private:
+    std::vector<MiTraceRecord> m_records;
+    uint64_t m_mask;
+    alignas(64) std::atomic<uint64_t> m_head{0};
+    alignas(64) std::atomic<uint64_t> m_tail{0};
+};
+
+enum MiTraceFormat {
+    MI_TRACE_SILENT,
+    MI_TRACE_CSV,
+    MI_TRACE_BINARY
+};
+
+class MiTraceSink {
+  public:
+    // Binary files start with this magic followed by the uint32_t record size.
+    static constexpr char BINARY_MAGIC[8] = {'M', 'I', 'T', 'R', 'A', 'C', 'E', '1'};
+
+    static MiTraceFormat ParseFormat(const std::string& name) {
+        if (name == "csv") {
+            return MI_TRACE_CSV;
+        }
+        if (name == "binary") {
+            return MI_TRACE_BINARY;
+        }
+        NS_ABORT_MSG_IF(name != "none", "unknown trace format '" << name << "' (none, csv, binary)");
+        return MI_TRACE_SILENT;
+    }
+
+    MiTraceSink(const std::string& path, MiTraceFormat format, size_t ringRecords = 1 << 16)
+        : m_format(format),
+          m_ringRecords(ringRecords),
+          m_id(++s_lastId) {
+        if (m_format == MI_TRACE_SILENT) {
+            return;
+        }
+        m_file = std::fopen(path.c_str(), m_format == MI_TRACE_BINARY ? "wb" : "w");
+        NS_ABORT_MSG_IF(m_file == nullptr, "cannot open trace file " << path);
+        if (m_format == MI_TRACE_BINARY) {
+            uint32_t recordSize = sizeof(MiTraceRecord);
+            std::fwrite(BINARY_MAGIC, sizeof(BINARY_MAGIC), 1, m_file);
+            std::fwrite(&recordSize, sizeof(recordSize), 1, m_file);
+        } else {
+            std::fputs("time_ns,node,kind,from,to,packet,size,coil,rx_coil,rssi_dbm\n", m_file);
+        }
+        m_running = true;
+        m_writer = std::thread(&MiTraceSink::WriterLoop, this);
+    }
+
+    ~MiTraceSink() { Close(); }
+
+    MiTraceSink(const MiTraceSink&) = delete;
+    MiTraceSink& operator=(const MiTraceSink&) = delete;
+
+    bool IsSilent() const { return m_format == MI_TRACE_SILENT; }
+
+    // Connects the trace sources enabled by MI_TRACE_LEVEL on every device.
+    void Attach(const NetDeviceContainer& devices) {
+        if (IsSilent()) {
+            return;
+        }
+        for (uint32_t i = 0; i < devices.GetN(); i++) {
+            Ptr<NetDevice> device = devices.Get(i);
+            if constexpr (MI_TRACE_LEVEL >= MI_TRACE_LEVEL_FRAMES) {
+                device->TraceConnectWithoutContext("MacTx", MakeBoundCallback(&MiTraceSink::TraceTx, this));
+                device->TraceConnectWithoutContext("MacRx", MakeBoundCallback(&MiTraceSink::TraceRx, this));
+                device->TraceConnectWithoutContext("MacTxDrop", MakeBoundCallback(&MiTraceSink::TraceDrop, this));
+            }
+            if constexpr (MI_TRACE_LEVEL >= MI_TRACE_LEVEL_STATES) {
+                device->TraceConnectWithoutContext("StateTransition",
+                                                   MakeBoundCallback(&MiTraceSink::TraceState, this));
+            }
+            if constexpr (MI_TRACE_LEVEL >= MI_TRACE_LEVEL_COILS) {
+                device->TraceConnectWithoutContext("CoilSelection",
+                                                   MakeBoundCallback(&MiTraceSink::TraceCoil, this));
+            }
+        }
+    }
+
+    // Queues a record from the calling thread.  Compiled out above
+    // MI_TRACE_LEVEL.  When the writer falls behind the producer waits for
+    // room rather than losing records.
+    template <int Level>
+    void Record(const MiTraceRecord& record) {
+        if constexpr (Level <= MI_TRACE_LEVEL) {
+            if (IsSilent()) {
+                return;
+            }
+            MiTraceRing* ring = LocalRing();
+            while (!ring->Push(record)) {
+                m_stalls.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Stops the writer after it has drained every ring.  Idempotent.
+    void Close() {
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+        m_writer.join();
+        DrainAll();
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    uint64_t GetRecordCount() const { return m_written; }
+    // Times a producer found its ring full and had to wait for the writer.
+    uint64_t GetStallCount() const { return m_stalls.load(); }
+
+  private:
+    static MiTraceRecord Make(MiTraceKind kind, uint32_t node) {
+        MiTraceRecord r{};
+        r.timeNs = Simulator::Now().GetNanoSeconds();
+        r.node = node;
+        r.kind = kind;
+        return r;
+    }
+
+    static void TraceState(MiTraceSink* sink, uint32_t node, NodeState from, NodeState to, const char* reason) {
+        MiTraceRecord r = Make(MI_TRACE_STATE, node);
+        r.from = from;
+        r.to = to;
+        sink->Record<MI_TRACE_LEVEL_STATES>(r);
+    }
+
+    static void TraceTx(MiTraceSink* sink, uint32_t node, Ptr<const Packet> frame, CoilID coil) {
+        MiTraceRecord r = Make(MI_TRACE_TX, node);
+        r.packetType = PacketTypeOf(frame);
+        r.size = frame->GetSize();
+        r.coil = coil;
+        sink->Record<MI_TRACE_LEVEL_FRAMES>(r);
+    }
+
+    static void TraceRx(MiTraceSink* sink, uint32_t node, Ptr<const Packet> frame, CoilID txCoil, CoilID rxCoil,
+                        double rssi) {
+        MiTraceRecord r = Make(MI_TRACE_RX, node);
+        r.packetType = PacketTypeOf(frame);
+        r.size = frame->GetSize();
+        r.coil = txCoil;
+        r.rxCoil = rxCoil;
+        r.rssi = static_cast<float>(rssi);
+        sink->Record<MI_TRACE_LEVEL_FRAMES>(r);
+    }
+
+    static void TraceDrop(MiTraceSink* sink, uint32_t node, Ptr<const Packet> packet) {
+        MiTraceRecord r = Make(MI_TRACE_DROP, node);
+        r.packetType = DATA_PACKET;
+        r.size = packet->GetSize();
+        sink->Record<MI_TRACE_LEVEL_FRAMES>(r);
+    }
+
+    static void TraceCoil(MiTraceSink* sink, uint32_t node, const double* rssi, const CoilID* rxCoil, CoilID best) {
+        MiTraceRecord r = Make(MI_TRACE_COIL, node);
+        r.packetType = REV_PACKET;
+        r.size = GetFrameSize(REV_PACKET);
+        r.coil = best;
+        r.rxCoil = rxCoil[best];
+        r.rssi = static_cast<float>(rssi[best]);
+        sink->Record<MI_TRACE_LEVEL_COILS>(r);
+    }
+
+    static uint8_t PacketTypeOf(Ptr<const Packet> frame) {
+        MiMacHeader header;
+        frame->PeekHeader(header);
+        return header.GetPacketType();
+    }
+
+    // The calling thread's ring for this sink, registered on first use.
+    MiTraceRing* LocalRing() {
+        thread_local uint64_t owner = 0;
+        thread_local MiTraceRing* ring = nullptr;
+        if (owner != m_id) {
+            std::lock_guard<std::mutex> lock(m_ringsMutex);
+            m_rings.push_back(std::make_unique<MiTraceRing>(m_ringRecords));
+            ring = m_rings.back().get();
+            owner = m_id;
+        }
+        return ring;
+    }
+
+    void WriterLoop() {
+        while (m_running) {
+            if (DrainAll() == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+    }
+
+    size_t DrainAll() {
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        size_t drained = 0;
+        for (auto& ring : m_rings) {
+            drained += ring->Drain([this](const MiTraceRecord& r) { Write(r); });
+        }
+        m_written += drained;
+        return drained;
+    }
+
+    void Write(const MiTraceRecord& r) {
+        if (m_format == MI_TRACE_BINARY) {
+            std::fwrite(&r, sizeof(r), 1, m_file);
+            return;
+        }
+        std::fprintf(m_file, "%lld,%u,%s,", static_cast<long long>(r.timeNs), r.node, traceKindNames[r.kind]);
+        if (r.kind == MI_TRACE_STATE) {
+            std::fprintf(m_file, "%s,%s,,,,,\n", stateNames[r.from].c_str(), stateNames[r.to].c_str());
+        } else if (r.kind == MI_TRACE_TX) {
+            std::fprintf(m_file, ",,%s,%u,%s,,\n", packetNames[r.packetType].c_str(), r.size,
+                         coilNames[r.coil].c_str());
+        } else if (r.kind == MI_TRACE_DROP) {
+            std::fprintf(m_file, ",,%s,%u,,,\n", packetNames[r.packetType].c_str(), r.size);
+        } else {
+            std::fprintf(m_file, ",,%s,%u,%s,%s,%.2f\n", packetNames[r.packetType].c_str(), r.size,
+                         coilNames[r.coil].c_str(), coilNames[r.rxCoil].c_str(), r.rssi);
+        }
+    }
+
+    // Distinguishes sinks in the per-thread ring cache, even if one is later
+    // allocated at a dead sink's address.
+    static inline std::atomic<uint64_t> s_lastId{0};
+
+    MiTraceFormat m_format;
+    size_t m_ringRecords;
+    uint64_t m_id;
+    std::FILE* m_file = nullptr;
+    std::atomic<bool> m_running{false};
+    std::thread m_writer;
+    std::mutex m_ringsMutex;
+    std::vector<std::unique_ptr<MiTraceRing>> m_rings;
+    uint64_t m_written = 0;
+    std::atomic<uint64_t> m_stalls{0};
+};
+
+} // namespace ns3
+
+#endif // MI_MAC_TRACE_H